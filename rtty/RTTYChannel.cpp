@@ -0,0 +1,41 @@
+/*
+Copyright (C) 2024 - Bruce MacKinnon KC1FSZ
+
+This program is free software: you can redistribute it and/or modify it under 
+the terms of the GNU General Public License as published by the Free 
+Software Foundation, either version 3 of the License, or (at your option) any 
+later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT 
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS 
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with 
+this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "RTTYChannel.h"
+
+namespace radlib {
+
+RTTYChannel::RTTYChannel(uint16_t sampleFreq, uint16_t log2fftN, 
+    const q15* fftTrigTable, float symbolSpreadHz)
+:   FSKChannel(sampleFreq, log2fftN, fftTrigTable, symbolSpreadHz),
+    _decoder(sampleFreq, 4545) {
+}
+
+void RTTYChannel::setListener(DemodulatorListener* listener) {
+    FSKChannel::setListener(listener);
+    // Connect the listener to the Baudot decoder as well to report out characters received
+    _decoder.setDataListener(listener);
+}
+
+void RTTYChannel::reset() {
+    FSKChannel::reset();
+    _decoder.reset();
+}
+
+void RTTYChannel::_processSymbol(bool isSymbolValid, uint8_t symbol) {
+    _decoder.processSample(isSymbolValid, symbol);
+}
+
+}
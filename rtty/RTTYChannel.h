@@ -0,0 +1,57 @@
+/*
+Copyright (C) 2024 - Bruce MacKinnon KC1FSZ
+
+This program is free software: you can redistribute it and/or modify it under 
+the terms of the GNU General Public License as published by the Free 
+Software Foundation, either version 3 of the License, or (at your option) any 
+later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT 
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS 
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with 
+this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef _RTTYChannel_h
+#define _RTTYChannel_h
+
+#include <cstdint>
+
+#include "../util/FSKChannel.h"
+#include "BaudotDecoder.h"
+
+namespace radlib {
+
+/**
+ * A skimmer channel that decodes 45.45 baud RTTY.  See FSKSkimmer.
+ */
+class RTTYChannel : public FSKChannel {
+public:
+
+    /**
+     * See FSKChannel for a description of the parameters.  The default
+     * shift has the space 170 Hz above the mark, which is what the usual 
+     * AFSK tones (2125/2295 Hz) look like.
+     */
+    RTTYChannel(uint16_t sampleFreq, uint16_t log2fftN, const q15* fftTrigTable,
+        float symbolSpreadHz = -170);
+
+    virtual void setListener(DemodulatorListener* listener);
+
+    virtual void reset();
+
+    uint32_t getInvalidSampleCount() const { return _decoder.getInvalidSampleCount(); }
+
+protected:
+
+    virtual void _processSymbol(bool isSymbolValid, uint8_t symbol);
+
+private:
+
+    BaudotDecoder _decoder;
+};
+
+}
+
+#endif
@@ -17,30 +17,7 @@ this program. If not, see <https://www.gnu.org/licenses/>.
 
 namespace radlib {
 
-RTTYDemodulator::RTTYDemodulator(uint16_t sampleFreq, uint16_t lowestFreq, uint16_t log2fftN,
-    q15* fftTrigTable, q15* fftWindow,
-    cq15* fftResultSpace, q15* bufferSpace) : 
-    Demodulator(sampleFreq, lowestFreq, log2fftN, fftTrigTable, fftWindow, fftResultSpace, bufferSpace),
-    _decoder(sampleFreq, 4545) {
-}
-
-void RTTYDemodulator::setListener(DemodulatorListener* listener) {
-    // Give the listener to the base class
-    Demodulator::setListener(listener);
-    // Connect the listener to the Baudot decoder as well to report out characters received
-    _decoder.setDataListener(listener);
-}
-
-void RTTYDemodulator::reset() {
-    // Tell the base modulator to reset
-    Demodulator::reset();
-    // Reset the Baudot decoder
-    _decoder.reset();
-}
-
-void RTTYDemodulator::_processSymbol(bool isSymbolValid, uint8_t symbol) {    
-    _decoder.processSample(isSymbolValid, symbol);
-}
+template class RTTYDemodulatorT<0, DEMODULATOR_BLOCK_SIZE, DEMODULATOR_TONE_N, 
+    DEMODULATOR_SAMPLES_PER_SYMBOL, true>;
 
 }
-
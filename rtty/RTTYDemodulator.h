@@ -41,17 +41,64 @@ namespace radlib {
  * say you are transmitting on 14080.00 kHz, that means your MARK 
  * frequency is 14080.00 kHz and your SPACE frequency is 170 Hz lower, 
  * or 14079.83 kHz. 
+ *
+ * See DemodulatorT for a description of the template parameters.  Use 
+ * the RTTYDemodulator typedef to set the FFT size at runtime.
  */
-class RTTYDemodulator : public Demodulator {
+template <uint16_t Log2FFT, uint16_t BlockSize = DEMODULATOR_BLOCK_SIZE, 
+    uint16_t ToneN = DEMODULATOR_TONE_N, 
+    uint16_t SamplesPerSymbol = DEMODULATOR_SAMPLES_PER_SYMBOL, bool MetricsEnabled = true>
+class RTTYDemodulatorT : public DemodulatorT<Log2FFT, BlockSize, ToneN, SamplesPerSymbol, MetricsEnabled> {
 public:
 
-    RTTYDemodulator(uint16_t sampleFreq, uint16_t lowestFreq, uint16_t log2fftN,
-        q15* fftTrigTableSpace, q15* fftWindowSpace, cq15* fftResultSpace, 
-        q15* bufferSpace);
-
-    virtual void setListener(DemodulatorListener* listener);
+    typedef DemodulatorT<Log2FFT, BlockSize, ToneN, SamplesPerSymbol, MetricsEnabled> Base;
 
-    virtual void reset();
+    /**
+     * Use this constructor when Log2FFT is 0.
+     */
+    RTTYDemodulatorT(uint16_t sampleFreq, uint16_t lowestFreq, uint16_t log2fftN,
+        q15* fftTrigTableSpace, q15* fftWindowSpace, cq15* fftResultSpace, 
+        q15* bufferSpace, SlidingDFT::Bin* slidingDFTSpace = 0)
+    :   Base(sampleFreq, lowestFreq, log2fftN, fftTrigTableSpace, fftWindowSpace, 
+            fftResultSpace, bufferSpace, 512, slidingDFTSpace),
+        _decoder(sampleFreq, 4545) {
+    }
+
+    /**
+     * Use this constructor when Log2FFT is 0 and the FFT trig table and 
+     * window have already been built (see SharedTables).
+     */
+    RTTYDemodulatorT(uint16_t sampleFreq, uint16_t lowestFreq, uint16_t log2fftN,
+        const q15* fftTrigTable, const q15* fftWindow, cq15* fftResultSpace, 
+        q15* bufferSpace, SlidingDFT::Bin* slidingDFTSpace = 0)
+    :   Base(sampleFreq, lowestFreq, log2fftN, fftTrigTable, fftWindow, 
+            fftResultSpace, bufferSpace, 512, slidingDFTSpace),
+        _decoder(sampleFreq, 4545) {
+    }
+
+    /**
+     * Use this constructor when Log2FFT is non-zero.
+     */
+    template <uint16_t L = Log2FFT, typename = std::enable_if_t<L != 0>>
+    RTTYDemodulatorT(uint16_t sampleFreq, uint16_t lowestFreq, 
+        SlidingDFT::Bin* slidingDFTSpace = 0)
+    :   Base(sampleFreq, lowestFreq, 512, slidingDFTSpace),
+        _decoder(sampleFreq, 4545) {
+    }
+
+    virtual void setListener(DemodulatorListener* listener) {
+        // Give the listener to the base class
+        Base::setListener(listener);
+        // Connect the listener to the Baudot decoder as well to report out characters received
+        _decoder.setDataListener(listener);
+    }
+
+    virtual void reset() {
+        // Tell the base modulator to reset
+        Base::reset();
+        // Reset the Baudot decoder
+        _decoder.reset();
+    }
 
     uint32_t getSampleCount() const { return _decoder.getSampleCount(); }
 
@@ -59,14 +106,25 @@ public:
 
 protected:
 
-    virtual void _processSymbol(bool isSymbolValid, uint8_t symbol);
+    virtual void _processSymbol(bool isSymbolValid, uint8_t symbol) {
+        _decoder.processSample(isSymbolValid, symbol);
+    }
 
 private:
 
     BaudotDecoder _decoder;
 };
 
+/**
+ * The RTTY demodulator with the FFT size set at runtime.
+ */
+typedef RTTYDemodulatorT<0, DEMODULATOR_BLOCK_SIZE, DEMODULATOR_TONE_N, 
+    DEMODULATOR_SAMPLES_PER_SYMBOL, true> RTTYDemodulator;
+
+// This is compiled once in RTTYDemodulator.cpp
+extern template class RTTYDemodulatorT<0, DEMODULATOR_BLOCK_SIZE, DEMODULATOR_TONE_N, 
+    DEMODULATOR_SAMPLES_PER_SYMBOL, true>;
+
 }
 
 #endif
-
@@ -0,0 +1,41 @@
+/*
+Copyright (C) 2024 - Bruce MacKinnon KC1FSZ
+
+This program is free software: you can redistribute it and/or modify it under 
+the terms of the GNU General Public License as published by the Free 
+Software Foundation, either version 3 of the License, or (at your option) any 
+later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT 
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS 
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with 
+this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "SCAMPChannel.h"
+
+namespace radlib {
+
+// The SCAMP FSK shift is 66.6 Hz, with the space below the mark
+SCAMPChannel::SCAMPChannel(uint16_t sampleFreq, uint16_t log2fftN, 
+    const q15* fftTrigTable)
+:   FSKChannel(sampleFreq, log2fftN, fftTrigTable, 66.6666666666),
+    _decoder(sampleFreq) {
+}
+
+void SCAMPChannel::setListener(DemodulatorListener* listener) {
+    FSKChannel::setListener(listener);
+    _decoder.setListener(listener);
+}
+
+void SCAMPChannel::reset() {
+    FSKChannel::reset();
+    _decoder.reset();
+}
+
+void SCAMPChannel::_processSymbol(bool isSymbolValid, uint8_t symbol) {
+    _decoder.processSample(isSymbolValid, symbol);
+}
+
+}
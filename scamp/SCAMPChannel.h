@@ -0,0 +1,54 @@
+/*
+Copyright (C) 2024 - Bruce MacKinnon KC1FSZ
+
+This program is free software: you can redistribute it and/or modify it under 
+the terms of the GNU General Public License as published by the Free 
+Software Foundation, either version 3 of the License, or (at your option) any 
+later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT 
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS 
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with 
+this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef _SCAMPChannel_h
+#define _SCAMPChannel_h
+
+#include <cstdint>
+
+#include "../util/FSKChannel.h"
+#include "SCAMPDecoder.h"
+
+namespace radlib {
+
+/**
+ * A skimmer channel that decodes SCAMP FSK.  See FSKSkimmer.
+ */
+class SCAMPChannel : public FSKChannel {
+public:
+
+    /**
+     * See FSKChannel for a description of the parameters.
+     */
+    SCAMPChannel(uint16_t sampleFreq, uint16_t log2fftN, const q15* fftTrigTable);
+
+    virtual void setListener(DemodulatorListener* listener);
+
+    virtual void reset();
+
+    uint16_t getFrameCount() const { return _decoder.getFrameCount(); };
+
+protected:
+
+    virtual void _processSymbol(bool isSymbolValid, uint8_t symbol);
+
+private:
+
+    SCAMPDecoder _decoder;
+};
+
+}
+
+#endif
@@ -0,0 +1,69 @@
+/*
+Copyright (C) 2024 - Bruce MacKinnon KC1FSZ
+
+This program is free software: you can redistribute it and/or modify it under 
+the terms of the GNU General Public License as published by the Free 
+Software Foundation, either version 3 of the License, or (at your option) any 
+later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT 
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS 
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with 
+this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef _SCAMPDecoder_h
+#define _SCAMPDecoder_h
+
+#include <cstdint>
+
+#include "../util/DemodulatorListener.h"
+#include "ClockRecoveryDLL.h"
+
+namespace radlib {
+
+/**
+ * Takes the stream of demodulated symbols, recovers the bit clock, and 
+ * assembles/decodes the SCAMP frames.  This doesn't know anything about
+ * the demodulation itself.
+ */
+class SCAMPDecoder {
+public:
+
+    SCAMPDecoder(uint16_t sampleFreq);
+
+    void setListener(DemodulatorListener* listener) { _listener = listener; }
+
+    void reset();
+
+    /**
+     * Call this on the sample cadence!
+     */
+    void processSample(bool isSymbolValid, uint8_t activeSymbol);
+
+    float getClockRecoveryPhaseError() const;
+
+    uint16_t getFrameCount() const { return _frameCount; };
+
+private:
+
+    DemodulatorListener* _listener = 0;
+
+    ClockRecoveryDLL _dataClockRecovery;
+
+    // Have we seen the synchronization frame?
+    bool _inDataSync = false;
+    // Here is where we accumulate data bits
+    uint32_t _frameBitAccumulator = 0;
+    // The number of bits received in the frame
+    uint16_t _frameBitCount = 0;
+    // The number of frames received
+    uint16_t _frameCount = 0;
+    // The last code word that was received (used for duplicate detection)
+    uint16_t _lastCodeWord12 = 0;
+};
+
+}
+
+#endif
@@ -22,8 +22,7 @@ this program. If not, see <https://www.gnu.org/licenses/>.
 #include "../util/fixed_fft.h"
 #include "../util/Demodulator.h"
 #include "../util/DemodulatorListener.h"
-#include "ClockRecoveryPLL.h"
-#include "ClockRecoveryDLL.h"
+#include "SCAMPDecoder.h"
 
 namespace radlib {
 
@@ -31,46 +30,93 @@ namespace radlib {
  * This contains all of the SCAMP demodulator logic.  This is a stateful
  * object that will be called once every sample interval with the latest
  * available sample.
+ *
+ * See DemodulatorT for a description of the template parameters.  Use 
+ * the SCAMPDemodulator typedef to set the FFT size at runtime.
  */
-class SCAMPDemodulator : public Demodulator {
+template <uint16_t Log2FFT, uint16_t BlockSize = DEMODULATOR_BLOCK_SIZE, 
+    uint16_t ToneN = DEMODULATOR_TONE_N, 
+    uint16_t SamplesPerSymbol = DEMODULATOR_SAMPLES_PER_SYMBOL, bool MetricsEnabled = true>
+class SCAMPDemodulatorT : public DemodulatorT<Log2FFT, BlockSize, ToneN, SamplesPerSymbol, MetricsEnabled> {
 public:
 
-    SCAMPDemodulator(uint16_t sampleFreq, uint16_t lowestFreq,
+    typedef DemodulatorT<Log2FFT, BlockSize, ToneN, SamplesPerSymbol, MetricsEnabled> Base;
+
+    /**
+     * Use this constructor when Log2FFT is 0.
+     */
+    SCAMPDemodulatorT(uint16_t sampleFreq, uint16_t lowestFreq,
         uint16_t log2fftN,
         q15* fftTrigTableSpace, q15* fftWindowSpace, cq15* fftResultSpace, 
-        q15* bufferSpace);
+        q15* bufferSpace, SlidingDFT::Bin* slidingDFTSpace = 0)
+    :   Base(sampleFreq, lowestFreq, log2fftN, fftTrigTableSpace, fftWindowSpace, 
+            fftResultSpace, bufferSpace, 512, slidingDFTSpace),
+        _decoder(sampleFreq) {
+    }
+
+    /**
+     * Use this constructor when Log2FFT is 0 and the FFT trig table and 
+     * window have already been built (see SharedTables).
+     */
+    SCAMPDemodulatorT(uint16_t sampleFreq, uint16_t lowestFreq, uint16_t log2fftN,
+        const q15* fftTrigTable, const q15* fftWindow, cq15* fftResultSpace, 
+        q15* bufferSpace, SlidingDFT::Bin* slidingDFTSpace = 0)
+    :   Base(sampleFreq, lowestFreq, log2fftN, fftTrigTable, fftWindow, 
+            fftResultSpace, bufferSpace, 512, slidingDFTSpace),
+        _decoder(sampleFreq) {
+    }
+
+    /**
+     * Use this constructor when Log2FFT is non-zero.
+     */
+    template <uint16_t L = Log2FFT, typename = std::enable_if_t<L != 0>>
+    SCAMPDemodulatorT(uint16_t sampleFreq, uint16_t lowestFreq, 
+        SlidingDFT::Bin* slidingDFTSpace = 0)
+    :   Base(sampleFreq, lowestFreq, 512, slidingDFTSpace),
+        _decoder(sampleFreq) {
+    }
+
+    virtual void setListener(DemodulatorListener* listener) {
+        Base::setListener(listener);
+        _decoder.setListener(listener);
+    }
 
-    float getClockRecoveryPhaseError() const;
+    float getClockRecoveryPhaseError() const { 
+        return _decoder.getClockRecoveryPhaseError(); 
+    }
 
-    uint16_t getFrameCount() const { return _frameCount; };
+    uint16_t getFrameCount() const { return _decoder.getFrameCount(); };
 
     int32_t getPLLIntegration() const {
         return 0;
     }
 
-    virtual void reset();
+    virtual void reset() {
+        Base::reset();
+        _decoder.reset();
+    }
 
 protected:
 
-    virtual void _processSymbol(bool isSymbolValid, uint8_t symbol);
+    virtual void _processSymbol(bool isSymbolValid, uint8_t symbol) {
+        _decoder.processSample(isSymbolValid, symbol);
+    }
 
 private:
 
-    ClockRecoveryDLL _dataClockRecovery;
-
-    // Have we seen the synchronization frame?
-    bool _inDataSync = false;
-    // Here is where we accumulate data bits
-    uint32_t _frameBitAccumulator = 0;
-    // The number of bits received in the frame
-    uint16_t _frameBitCount = 0;
-    // The number of frames received
-    uint16_t _frameCount = 0;
-    // The last code word that was received (used for duplicate detection)
-    uint16_t _lastCodeWord12 = 0;
+    SCAMPDecoder _decoder;
 };
 
+/**
+ * The SCAMP demodulator with the FFT size set at runtime.
+ */
+typedef SCAMPDemodulatorT<0, DEMODULATOR_BLOCK_SIZE, DEMODULATOR_TONE_N, 
+    DEMODULATOR_SAMPLES_PER_SYMBOL, true> SCAMPDemodulator;
+
+// This is compiled once in SCAMPDemodulator.cpp
+extern template class SCAMPDemodulatorT<0, DEMODULATOR_BLOCK_SIZE, DEMODULATOR_TONE_N, 
+    DEMODULATOR_SAMPLES_PER_SYMBOL, true>;
+
 }
 
 #endif
-
@@ -22,6 +22,12 @@ this program. If not, see <https://www.gnu.org/licenses/>.
 #include "../../rtty/BaudotEncoder.h"
 #include "../../rtty/BaudotDecoder.h"
 #include "../../rtty/RTTYDemodulator.h"
+// The fixed FFT size configurations need the demodulator body
+#include "../../util/DemodulatorTImpl.h"
+#include "../../rtty/RTTYChannel.h"
+#include "../../util/FSKSkimmer.h"
+#include "../../util/PolyphaseChannelizer.h"
+#include "../../util/ChannelizerAdapter.h"
 
 #include "../scamp/TestModem2.h"
 #include "../scamp/TestDemodulatorListener.h"
@@ -180,6 +186,98 @@ int main(int,const char**) {
         cout << "MESSAGE : " << testListener.getMessage() << endl;
         cout << "INVALID SAMPLE RATIO: " << (float)demod.getInvalidSampleCount() / (float)demod.getSampleCount() << endl;
         assert(testListener.getMessage() == testMessage1);
+
+        // The compile-time sized version (with its own buffers) should 
+        // behave exactly the same way
+        TestDemodulatorListener testListenerT(cout, 0, 2);
+        RTTYDemodulatorT<log2fftN> demodT(sampleFreq, lowFreq);
+        demodT.setListener(&testListenerT);
+        demodT.setSymbolSpread(spread);
+        demodT.setFrequencyLock(markFreq);
+        demodT.setDetectionCorrelationThreshold(0.01);
+        for (uint32_t i = 0; i < modem2.getSamplesUsed(); i++) {
+            demodT.processSample(f32_to_q15(samples[i]));
+        }
+        cout << "MESSAGE (TEMPLATE) : " << testListenerT.getMessage() << endl;
+        assert(testListenerT.getMessage() == testListener.getMessage());
+        assert(demodT.getInvalidSampleCount() == demod.getInvalidSampleCount());
+
+        // The same signal through a skimmer channel
+        TestDemodulatorListener testListenerS(cout, 0, 2);
+        uint8_t binScore[FSKSkimmer::binScoreSpaceSize(log2fftN)];
+        RTTYChannel channel(sampleFreq, log2fftN, trigTable, spread);
+        channel.setListener(&testListenerS);
+        channel.setDetectionCorrelationThreshold(0.01);
+        FSKChannel* channels[1] = { &channel };
+        FSKSkimmer skimmer(sampleFreq, lowFreq, log2fftN, trigTable, window, 
+            fftResult, buffer, binScore, channels, 1);
+        skimmer.startChannel(markFreq);
+        for (uint32_t i = 0; i < modem2.getSamplesUsed(); i++) {
+            skimmer.processSample(f32_to_q15(samples[i]));
+        }
+        cout << "MESSAGE (SKIMMER) : " << testListenerS.getMessage() << endl;
+        assert(testListenerS.getMessage().find("GOOD MORNING") != string::npos);
+    }
+
+    // The standard 2125/2295 tones sampled at 8 kHz and split into 8 
+    // channels (floating-point version).  Channel 2 is sampled at 2 kHz 
+    // and the tones land on 625/795 Hz.
+    {
+        const uint16_t sampleFreq = 8000;
+        const uint16_t channelSampleFreq = 2000;
+        const uint16_t lowFreq = 100;
+        const uint16_t log2fftN = 9;
+        const uint16_t fftN = 1 << log2fftN;
+        const unsigned int sampleSize = 8000 * 8;
+        static float samples[sampleSize];
+        const uint32_t symbolUs = 22002;
+        const float markFreq = 2125;
+        const float spaceFreq = 2295;
+        const char* testMessage1 = "DE KC1FSZ, GOOD MORNING";
+
+        TestModem2 modem2(samples, sampleSize, sampleFreq, markFreq, spaceFreq, 0.5, 0.1, 0.2);
+        transmitBaudot(testMessage1, modem2, symbolUs);
+        assert(modem2.getSamplesUsed() < sampleSize);
+
+        const uint16_t log2ChannelN = 3;
+        const uint16_t channelN = 1 << log2ChannelN;
+        const uint16_t tapsPerBranch = 16;
+        float chTrigTable[channelN];
+        float chFilter[F32Channelizer::filterSpaceSize(log2ChannelN, tapsPerBranch)];
+        float chHistory[F32Channelizer::historySpaceSize(log2ChannelN, tapsPerBranch)];
+        cf32 chOutput[channelN];
+        F32Channelizer channelizer(log2ChannelN, tapsPerBranch, chTrigTable, 
+            chFilter, chHistory, chOutput);
+
+        const uint16_t channel = 
+            ChannelizerAdapter<RTTYDemodulator>::freqToChannel(markFreq, sampleFreq, channelN);
+        assert(channel == 2);
+        const float channelMarkFreq = 
+            ChannelizerAdapter<RTTYDemodulator>::toChannelFreq(markFreq, channel, sampleFreq, channelN);
+        const float channelSpaceFreq = 
+            ChannelizerAdapter<RTTYDemodulator>::toChannelFreq(spaceFreq, channel, sampleFreq, channelN);
+
+        TestDemodulatorListener testListener(cout, 0, 2);
+        q15 trigTable[fftN];
+        q15 window[fftN];
+        q15 buffer[fftN];
+        cq15 fftResult[fftN];
+        RTTYDemodulator demod(channelSampleFreq, lowFreq, log2fftN,
+            trigTable, window, fftResult, buffer);
+        demod.setListener(&testListener);
+        demod.setSymbolSpread(channelMarkFreq - channelSpaceFreq);
+        demod.setFrequencyLock(channelMarkFreq);
+        demod.setDetectionCorrelationThreshold(0.01);
+        ChannelizerAdapter<RTTYDemodulator> adapter(demod, channel);
+
+        for (uint32_t i = 0; i < modem2.getSamplesUsed(); i++) {
+            if (channelizer.processSample(samples[i])) {
+                adapter.processOutputs(channelizer.getOutputs());
+            }
+        }
+        cout << "MARK HZ (CHANNELIZER) : " << channelMarkFreq << endl;
+        cout << "MESSAGE (CHANNELIZER) : " << testListener.getMessage() << endl;
+        assert(testListener.getMessage() == testMessage1);
     }
 }
 
@@ -39,7 +39,8 @@ TestModem2::TestModem2(float* samples, unsigned int samplesSize,
     _spaceFreq(spaceFreq),
     _amp(amp),
     _dcBias(dcBias),
-    _noiseAmp(noiseAmp) {
+    _noiseAmp(noiseAmp),
+    _nco(sampleRate) {
 }
 
 float TestModem2::_getNoise() {
@@ -63,11 +64,10 @@ void TestModem2::sendSilence(uint32_t us) {
 void TestModem2::sendMark(uint32_t us) {
     // Convert us to samples
     uint32_t samples = (_sampleRate * us) / 1000000;
-    float omega = 2.0f * 3.1415926f * (float)_markFreq / (float)_sampleRate;
+    _nco.setFrequency(_markFreq);
     for (unsigned int i = 0; i < samples; i++) {
         if (_samplesUsed < _samplesSize) {
-            _samples[_samplesUsed++] = _amp * std::cos(_phi) + _dcBias + _getNoise();
-            _phi += omega;
+            _samples[_samplesUsed++] = _amp * _nco.nextF32() + _dcBias + _getNoise();
         }
     }
 }
@@ -75,11 +75,10 @@ void TestModem2::sendMark(uint32_t us) {
 void TestModem2::sendSpace(uint32_t us) {
     // Convert us to samples
     uint32_t samples = (_sampleRate * us) / 1000000;
-    float omega = 2.0f * 3.1415926f * (float)_spaceFreq / (float)_sampleRate;
+    _nco.setFrequency(_spaceFreq);
     for (unsigned int i = 0; i < samples; i++) {
         if (_samplesUsed < _samplesSize) {
-            _samples[_samplesUsed++] = _amp * std::cos(_phi) + _dcBias + _getNoise();
-            _phi += omega;
+            _samples[_samplesUsed++] = _amp * _nco.nextF32() + _dcBias + _getNoise();
         }
     }
 }
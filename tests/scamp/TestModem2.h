@@ -18,6 +18,7 @@ this program. If not, see <https://www.gnu.org/licenses/>.
 
 #include <cstdint>
 #include "../../util/FSKModulator.h"
+#include "../../util/NCO.h"
 
 namespace radlib {
 
@@ -51,7 +52,7 @@ private:
     float _amp;
     float _dcBias;
     float _noiseAmp;
-    float _phi = 0;
+    NCO _nco;
 
 };
 
@@ -20,6 +20,7 @@ this program. If not, see <https://www.gnu.org/licenses/>.
 #include <sstream>
 #include <cassert>
 #include <cstring>
+#include <chrono>
 
 #include "../../scamp/Util.h"
 #include "../../scamp/Symbol6.h"
@@ -166,6 +167,52 @@ int main(int, const char**) {
         // Demo the trace
         //testListener.dumpSamples(cout);
     }
+
+    // Decode success vs. cost for the decimated post-detection path.  This
+    // is done with the default (floating point) engines and with the 
+    // fixed-point engines.  The spectral analysis is turned off while 
+    // locked so that the timing mostly reflects the demodulator.
+    {
+        cout << "DECIMATION" << endl;
+        const uint16_t factors[] = { 1, 2, 4, 8 };
+        for (int fixedPoint = 0; fixedPoint < 2; fixedPoint++) {
+            for (uint16_t factor : factors) {
+
+                ostringstream nullOut;
+                TestDemodulatorListener testListener(nullOut);
+
+                q15 trigTable[fftN];
+                q15 window[fftN];
+                q15 buffer[fftN];
+                cq15 fftResult[fftN];
+
+                SCAMPDemodulator demod(sampleFreq, lowFreq, log2fftN,
+                    trigTable, window, fftResult, buffer);
+                demod.setListener(&testListener);
+                demod.setDetectionCorrelationThreshold(0.02);
+                demod.setIncrementalCorrelationEnabled(fixedPoint == 1);
+                demod.setFixedPointFilterEnabled(fixedPoint == 1);
+                demod.setDecimation(factor);
+                demod.setLockedAnalysis(0);
+
+                auto start = std::chrono::steady_clock::now();
+                for (uint32_t i = 0; i < modem2.getSamplesUsed(); i++) {
+                    demod.processSample(f32_to_q15(samples[i]));
+                }
+                auto end = std::chrono::steady_clock::now();
+                auto us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+
+                const string msg = testListener.getMessage();
+                const bool success = 
+                    msg.find("GOOD MORNING") != string::npos &&
+                    msg.find("HAVE A GOOD DAY") != string::npos;
+                cout << "  " << (fixedPoint ? "q15" : "f32") << " D=" << factor 
+                    << " : " << (float)us / 1000.0 << " ms, frames=" << demod.getFrameCount() 
+                    << ", success=" << success << ", " << msg << endl;
+                assertm(success, "Decimated decode failure");
+            }
+        }
+    }
 }
 
 // FIRST DATA FRAME
@@ -0,0 +1,919 @@
+/*
+SCAMP Encoder/Decoder
+Copyright (C) 2024 - Bruce MacKinnon KC1FSZ
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <cassert>
+#include <cstring>
+#include <chrono>
+#include <vector>
+#include <random>
+
+#include "../../scamp/Util.h"
+#include "../../scamp/Frame30.h"
+#include "../../scamp/SCAMPDemodulator.h"
+// The fixed FFT size configurations need the demodulator body
+#include "../../util/DemodulatorTImpl.h"
+
+#include "../../util/fixed_math.h"
+#include "../../util/DemodulatorListener.h"
+#include "../../util/PolyphaseChannelizer.h"
+#include "../../util/ChannelizerAdapter.h"
+#include "../../util/SharedTables.h"
+
+#include "TestModem2.h"
+
+// Use (void) to silence unused warnings.
+#define assertm(exp, msg) assert(((void)msg, exp))
+
+using namespace std;
+using namespace radlib;
+
+// ------ Data Area -------
+
+const unsigned int sampleFreq = 2000;
+const uint16_t lowFreq = 50;
+const unsigned int samplesPerSymbol = 60;
+const unsigned int usPerSymbol = (1000000 / sampleFreq) * samplesPerSymbol;
+const unsigned int markFreq = 667;
+const unsigned int spaceFreq = 600;
+
+// Reserve space for modulation
+const unsigned int S = ((30 * 30) + 30) * samplesPerSymbol;
+static float samples[S];
+static q15 samplesQ15[S];
+static SampleMetrics metricsSpace[256];
+// The complex (I/Q) version of the signal
+static cq15 iqSamples[S];
+// The same signal at 4x the rate (for the channelizer)
+static float samples8k[S * 4];
+static float weakSamples[S];
+static q15 weakSamplesQ15[S];
+
+// The size of the FFT used for frequency acquisition
+const uint16_t log2fftN = 9;
+const uint16_t fftN = 1 << log2fftN;
+
+/**
+ * A listener that records every event (including the exact bits of the
+ * floating-point metrics) so that two runs can be compared.
+ */
+class RecordingListener : public DemodulatorListener {
+public:
+
+    virtual void frequencyLocked(uint16_t markFreq, uint16_t spaceFreq) {
+        _log << "L " << markFreq << " " << spaceFreq << "\n";
+    }
+
+    virtual void frequencyLockedSigned(int16_t markFreq, int16_t spaceFreq) {
+        _log << "LS " << markFreq << " " << spaceFreq << "\n";
+    }
+
+    virtual void frequencyLockLost() {
+        _log << "U\n";
+        _lockLostCount++;
+    }
+
+    virtual void symbolTransitionDetected() {
+        _log << "T\n";
+    }
+
+    virtual void sampleMetrics(q15 sample, uint8_t activeSymbol, float* symbolCorr,
+        bool isAnySymbolPresent) {
+        uint32_t c0, c1;
+        memcpy(&c0, &symbolCorr[0], sizeof(c0));
+        memcpy(&c1, &symbolCorr[1], sizeof(c1));
+        _log << "M " << sample << " " << (int)activeSymbol << " " << c0 << " "
+            << c1 << " " << isAnySymbolPresent << "\n";
+        _corr[0].push_back(symbolCorr[0]);
+        _corr[1].push_back(symbolCorr[1]);
+        _metricsCount++;
+    }
+
+    virtual void sampleMetricsBatch(SampleMetrics* metrics, uint16_t n) {
+        _batchCount++;
+        DemodulatorListener::sampleMetricsBatch(metrics, n);
+    }
+
+    virtual void received(char asciiChar) {
+        _log << "C " << asciiChar << "\n";
+        _msg << asciiChar;
+    }
+
+    virtual void receivedBit(bool bit, uint16_t frameBitPos, int syncFrameCorr) {
+        _log << "B " << bit << " " << frameBitPos << " " << syncFrameCorr << "\n";
+    }
+
+    virtual void goodFrameReceived() { _log << "G\n"; }
+    virtual void badFrameReceived(uint32_t rawFrame) { _log << "X " << rawFrame << "\n"; }
+    virtual void dataSyncAcquired() { _log << "S\n"; }
+    virtual void discardedDuplicate() { _log << "D\n"; }
+
+    string getLog() const { return _log.str(); }
+    string getMessage() const { return _msg.str(); }
+    uint32_t getMetricsCount() const { return _metricsCount; }
+    uint32_t getLockLostCount() const { return _lockLostCount; }
+    uint32_t getBatchCount() const { return _batchCount; }
+
+    /**
+     * @returns Only the per-sample events (metrics and transitions) from 
+     *   the log.
+     */
+    string getMetricsLog() const { 
+        istringstream in(_log.str());
+        ostringstream out;
+        string line;
+        while (getline(in, line)) {
+            if (line[0] == 'M' || line[0] == 'T') {
+                out << line << "\n";
+            }
+        }
+        return out.str();
+    }
+    const vector<float>& getCorrelations(int symbol) const { return _corr[symbol]; }
+
+private:
+
+    ostringstream _log;
+    vector<float> _corr[2];
+    ostringstream _msg;
+    uint32_t _metricsCount = 0;
+    uint32_t _lockLostCount = 0;
+    uint32_t _batchCount = 0;
+};
+
+/**
+ * A listener that does the minimum amount of work with the metrics. This 
+ * is used to measure the cost of the delivery mechanism.
+ */
+class CountingListener : public DemodulatorListener {
+public:
+
+    virtual void sampleMetrics(q15 sample, uint8_t activeSymbol, float* symbolCorr,
+        bool isAnySymbolPresent) {
+        _metricsCount++;
+    }
+
+    virtual void sampleMetricsBatch(SampleMetrics* metrics, uint16_t n) {
+        _metricsCount += n;
+    }
+
+    uint32_t getMetricsCount() const { return _metricsCount; }
+
+private:
+
+    uint32_t _metricsCount = 0;
+};
+
+/**
+ * @returns The largest difference in the filtered symbol correlations 
+ *   reported by two runs.
+ */
+static float maxCorrelationError(const RecordingListener& l0, const RecordingListener& l1) {
+    float maxError = 0;
+    for (int s = 0; s < 2; s++) {
+        const vector<float>& c0 = l0.getCorrelations(s);
+        const vector<float>& c1 = l1.getCorrelations(s);
+        for (size_t i = 0; i < std::min(c0.size(), c1.size()); i++) {
+            maxError = std::max(maxError, std::abs(c0[i] - c1[i]));
+        }
+    }
+    return maxError;
+}
+
+static void makeSignal(FSKModulator& modem2) {
+
+    const char* testMessage1 = "DE KC1FSZ, GOOD MORNING";
+    const char* testMessage2 = "73S, HAVE A GOOD DAY";
+
+    Frame30 frames[32];
+
+    unsigned int frameCount1 = encodeString(testMessage1, frames, 32, true);
+    assertm(frameCount1 < 32, "FRAME COUNT");
+
+    for (unsigned int i = 0; i < 30; i++)
+        modem2.sendSilence(usPerSymbol);
+    for (unsigned int i = 0; i < frameCount1; i++)
+        frames[i].transmit(modem2, usPerSymbol);
+    for (unsigned int i = 0; i < 30; i++)
+        modem2.sendSilence(usPerSymbol);
+
+    unsigned int frameCount2 = encodeString(testMessage2, frames, 32, true);
+    assertm(frameCount2 < 32, "FRAME COUNT");
+
+    for (unsigned int i = 0; i < frameCount2; i++)
+        frames[i].transmit(modem2, usPerSymbol);
+    for (unsigned int i = 0; i < 30; i++)
+        modem2.sendSilence(usPerSymbol);
+}
+
+/**
+ * Generates a complex (I/Q) FSK signal, which is what an SDR would 
+ * produce.  The frequencies can be negative.
+ */
+class IQModem : public FSKModulator {
+public:
+
+    IQModem(cq15* samples, unsigned int samplesSize, float markFreq, float spaceFreq, 
+        float amp, float dcBias, float noiseAmp) 
+    :   _samples(samples), _samplesSize(samplesSize), _markFreq(markFreq), 
+        _spaceFreq(spaceFreq), _amp(amp), _dcBias(dcBias), _noise(0.0, noiseAmp) { }
+
+    virtual void sendSilence(uint32_t us) { _send(us, 0, 0); }
+    virtual void sendMark(uint32_t us) { _send(us, _markFreq, _amp); }
+    virtual void sendSpace(uint32_t us) { _send(us, _spaceFreq, _amp); }
+
+    uint32_t getSamplesUsed() const { return _samplesUsed; }
+
+private:
+
+    void _send(uint32_t us, float freq, float amp) {
+        uint32_t n = (sampleFreq * us) / 1000000;
+        for (uint32_t i = 0; i < n && _samplesUsed < _samplesSize; i++) {
+            cq15& c = _samples[_samplesUsed++];
+            c.r = f32_to_q15(amp * std::cos(_phi) + _dcBias + _noise(_gen));
+            c.i = f32_to_q15(amp * std::sin(_phi) + _dcBias + _noise(_gen));
+            _phi += 2.0f * pi() * freq / (float)sampleFreq;
+        }
+    }
+
+    cq15* _samples;
+    const unsigned int _samplesSize;
+    const float _markFreq;
+    const float _spaceFreq;
+    const float _amp;
+    const float _dcBias;
+    std::mt19937 _gen { 1 };
+    std::normal_distribution<float> _noise;
+    uint32_t _samplesUsed = 0;
+    float _phi = 0;
+};
+
+/**
+ * The demodulator configuration used for a run.
+ */
+struct Options {
+    bool slidingDFT = false;
+    bool autoLock = true;
+    uint16_t lowestFreq = lowFreq;
+    bool incrementalCorr = false;
+    bool fixedPointFilter = false;
+    bool blockFloatingPoint = false;
+    bool bandAnalysis = false;
+    // Zero means per-sample metrics delivery
+    uint16_t metricsBufferSize = 0;
+};
+
+template <class D> 
+static void configure(D& demod, const Options& options) {
+    demod.setDetectionCorrelationThreshold(0.02);
+    demod.setAutoLockEnabled(options.autoLock);
+    demod.setIncrementalCorrelationEnabled(options.incrementalCorr);
+    demod.setFixedPointFilterEnabled(options.fixedPointFilter);
+    demod.setBlockFloatingPointEnabled(options.blockFloatingPoint);
+    demod.setBandAnalysisEnabled(options.bandAnalysis);
+    demod.setMetricsBuffer(metricsSpace, options.metricsBufferSize);
+}
+
+/**
+ * Runs the demodulator across the signal.  A block size of zero means
+ * that processSample() is called for each sample.
+ *
+ * @returns The elapsed time in microseconds.
+ */
+static uint32_t demodulate(DemodulatorListener& listener, uint32_t sampleCount,
+    size_t blockSize, const Options& options = Options()) {
+
+    // Space for the demodulator to work in (no dynamic memory allocation!)
+    q15 trigTable[fftN];
+    q15 window[fftN];
+    q15 buffer[fftN];
+    cq15 fftResult[fftN];
+    SlidingDFT::Bin sdftSpace[Demodulator::slidingDFTSpaceSize(log2fftN)];
+
+    SCAMPDemodulator demod(sampleFreq, options.lowestFreq, log2fftN,
+        trigTable, window, fftResult, buffer, options.slidingDFT ? sdftSpace : 0);
+    demod.setListener(&listener);
+    configure(demod, options);
+
+    auto start = std::chrono::steady_clock::now();
+
+    if (blockSize == 0) {
+        for (uint32_t i = 0; i < sampleCount; i++) {
+            demod.processSample(samplesQ15[i]);
+        }
+    } else {
+        for (uint32_t i = 0; i < sampleCount; i += blockSize) {
+            size_t n = std::min((size_t)(sampleCount - i), blockSize);
+            demod.processSamples(samplesQ15 + i, n);
+        }
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+}
+
+/**
+ * Same as demodulate(), but uses the compile-time sized demodulator.
+ */
+static uint32_t demodulateT(DemodulatorListener& listener, uint32_t sampleCount,
+    size_t blockSize, const Options& options = Options()) {
+
+    SlidingDFT::Bin sdftSpace[Demodulator::slidingDFTSpaceSize(log2fftN)];
+    SCAMPDemodulatorT<log2fftN> demod(sampleFreq, options.lowestFreq, 
+        options.slidingDFT ? sdftSpace : 0);
+    demod.setListener(&listener);
+    configure(demod, options);
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < sampleCount; i += blockSize) {
+        size_t n = std::min((size_t)(sampleCount - i), blockSize);
+        demod.processSamples(samplesQ15 + i, n);
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+}
+
+/**
+ * Runs the demodulator with a manual frequency lock to measure the 
+ * steady-state (locked) cost.
+ *
+ * @returns The elapsed time in microseconds.
+ */
+static uint32_t demodulateLocked(uint32_t sampleCount, uint16_t lockedAnalysisInterval,
+    const Options& options = Options(), uint16_t signalLossLimit = 0) {
+
+    q15 trigTable[fftN];
+    q15 window[fftN];
+    q15 buffer[fftN];
+    cq15 fftResult[fftN];
+    SlidingDFT::Bin sdftSpace[Demodulator::slidingDFTSpaceSize(log2fftN)];
+    DemodulatorListener nullListener;
+
+    SCAMPDemodulator demod(sampleFreq, options.lowestFreq, log2fftN,
+        trigTable, window, fftResult, buffer, options.slidingDFT ? sdftSpace : 0);
+    demod.setListener(&nullListener);
+    configure(demod, options);
+    demod.setLockedAnalysis(lockedAnalysisInterval, signalLossLimit);
+    demod.setFrequencyLock(markFreq);
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < sampleCount; i += 256) {
+        size_t n = std::min((size_t)(sampleCount - i), (size_t)256);
+        demod.processSamples(samplesQ15 + i, n);
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+}
+
+/**
+ * Same as demodulateLocked(), but allows the per-sample metrics to be 
+ * compiled out.
+ *
+ * @returns The elapsed time in microseconds.
+ */
+template <bool MetricsEnabled>
+static uint32_t demodulateMetrics(DemodulatorListener& listener, uint32_t sampleCount, 
+    const Options& options = Options()) {
+
+    q15 trigTable[fftN];
+    q15 window[fftN];
+    q15 buffer[fftN];
+    cq15 fftResult[fftN];
+
+    SCAMPDemodulatorT<0, DEMODULATOR_BLOCK_SIZE, DEMODULATOR_TONE_N, 
+        DEMODULATOR_SAMPLES_PER_SYMBOL, MetricsEnabled> demod(sampleFreq, 
+        options.lowestFreq, log2fftN, trigTable, window, fftResult, buffer);
+    demod.setListener(&listener);
+    configure(demod, options);
+    demod.setLockedAnalysis(0);
+    demod.setFrequencyLock(markFreq);
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < sampleCount; i += 256) {
+        size_t n = std::min((size_t)(sampleCount - i), (size_t)256);
+        demod.processSamples(samplesQ15 + i, n);
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+}
+
+int main(int, const char**) {
+
+    memset((void*)samples, 0, sizeof(samples));
+
+    // Note that we have applied a DC bias and random noise here
+    TestModem2 modem2(samples, S, sampleFreq, markFreq, spaceFreq, 0.2, 0.1, 0.1);
+    makeSignal(modem2);
+
+    const uint32_t sampleCount = modem2.getSamplesUsed();
+    for (uint32_t i = 0; i < sampleCount; i++) {
+        samplesQ15[i] = f32_to_q15(samples[i]);
+    }
+
+    // Reference run, one sample at a time
+    RecordingListener refListener;
+    demodulate(refListener, sampleCount, 0);
+    cout << "Reference message : " << refListener.getMessage() << endl;
+    cout << "Reference metrics : " << refListener.getMetricsCount() << endl;
+    assertm(refListener.getMetricsCount() > 0, "No demodulation happened");
+
+    // Block runs must produce identical events, including block sizes that
+    // are not aligned with the internal analysis block.
+    const size_t blockSizes[] = { 1, 7, 31, 32, 33, 256, 500, 1024 };
+    for (size_t blockSize : blockSizes) {
+        RecordingListener blockListener;
+        demodulate(blockListener, sampleCount, blockSize);
+        cout << "Block size " << blockSize << " : " << blockListener.getMessage() << endl;
+        assertm(blockListener.getLog() == refListener.getLog(), "Block/sample mismatch");
+    }
+
+    // The compile-time sized demodulator must produce identical events
+    for (int engines = 0; engines < 4; engines++) {
+        RecordingListener l0, l1;
+        Options options;
+        options.incrementalCorr = (engines & 1) != 0;
+        options.fixedPointFilter = (engines & 2) != 0;
+        demodulate(l0, sampleCount, 256, options);
+        demodulateT(l1, sampleCount, 256, options);
+        assertm(l0.getLog() == l1.getLog(), "Template/runtime mismatch");
+    }
+
+    // The sliding DFT should lock and decode just like the FFT
+    {
+        RecordingListener sdftListener;
+        Options options;
+        options.slidingDFT = true;
+        demodulate(sdftListener, sampleCount, 256, options);
+        cout << "Sliding DFT message : " << sdftListener.getMessage() << endl;
+        assertm(sdftListener.getMessage().find("GOOD MORNING") != string::npos, "Sliding DFT decode failure");
+        assertm(sdftListener.getMessage().find("HAVE A GOOD DAY") != string::npos, "Sliding DFT decode failure");
+    }
+
+    // The block-floating-point FFT should decode the normal signal, and 
+    // should still lock onto a signal that is 54 dB weaker (about 13 q15 
+    // LSBs, with the thresholds lowered to match).
+    {
+        RecordingListener bfpListener;
+        Options options;
+        options.blockFloatingPoint = true;
+        demodulate(bfpListener, sampleCount, 256, options);
+        cout << "BFP message : " << bfpListener.getMessage() << endl;
+        assertm(bfpListener.getMessage().find("GOOD MORNING") != string::npos, "BFP decode failure");
+        assertm(bfpListener.getMessage().find("HAVE A GOOD DAY") != string::npos, "BFP decode failure");
+
+        memset((void*)weakSamples, 0, sizeof(weakSamples));
+        TestModem2 weakModem(weakSamples, S, sampleFreq, markFreq, spaceFreq, 0.0004, 0.0, 0.00004);
+        makeSignal(weakModem);
+        for (uint32_t i = 0; i < weakModem.getSamplesUsed(); i++) {
+            weakSamplesQ15[i] = f32_to_q15(weakSamples[i]);
+        }
+
+        // Normal, block-floating-point and q31 FFT
+        const char* modeNames[] = { "normal", "BFP   ", "q31   " };
+        static cq31 fft31Result[fftN / 2 + 1];
+        FixedFFT31 fft31(fftN, SharedTables<log2fftN>::fixed31TrigTable());
+        for (int mode = 0; mode < 3; mode++) {
+            q15 trigTable[fftN];
+            q15 window[fftN];
+            q15 buffer[fftN];
+            cq15 fftResult[fftN];
+            SCAMPDemodulator demod(sampleFreq, lowFreq, log2fftN,
+                trigTable, window, fftResult, buffer);
+            RecordingListener weakListener;
+            demod.setListener(&weakListener);
+            demod.setDetectionCorrelationThreshold(0.00004);
+            demod.setBinPowerThreshold(2.0e-9);
+            demod.setBlockFloatingPointEnabled(mode == 1);
+            if (mode == 2) {
+                demod.setFFT31(&fft31, fft31Result);
+            }
+            demod.processSamples(weakSamplesQ15, weakModem.getSamplesUsed());
+            cout << "Weak signal (" << modeNames[mode] << ") message : " << weakListener.getMessage() << endl;
+            cout << "Weak signal (" << modeNames[mode] << ") mark    : " << demod.getMarkFreq() << endl;
+            // The normal FFT loses this signal to truncation
+            if (mode != 0) {
+                assert(std::abs(demod.getMarkFreq() - markFreq) < 4);
+                assertm(weakListener.getMessage().find("GOOD MORNING") != string::npos, "Weak BFP/q31 decode failure");
+            }
+        }
+    }
+
+    // The q31 FFT should decode the normal signal too
+    {
+        q15 trigTable[fftN];
+        q15 window[fftN];
+        q15 buffer[fftN];
+        cq15 fftResult[fftN];
+        static cq31 fft31Result[fftN / 2 + 1];
+        FixedFFT31 fft31(fftN, SharedTables<log2fftN>::fixed31TrigTable());
+        SCAMPDemodulator demod(sampleFreq, lowFreq, log2fftN,
+            trigTable, window, fftResult, buffer);
+        RecordingListener listener;
+        demod.setListener(&listener);
+        demod.setDetectionCorrelationThreshold(0.02);
+        demod.setFFT31(&fft31, fft31Result);
+        demod.processSamples(samplesQ15, sampleCount);
+        cout << "q31 FFT message : " << listener.getMessage() << endl;
+        assertm(listener.getMessage().find("GOOD MORNING") != string::npos, "q31 FFT decode failure");
+        assertm(listener.getMessage().find("HAVE A GOOD DAY") != string::npos, "q31 FFT decode failure");
+    }
+
+    // A full-scale input through the q31 FFT.  The alternating samples put
+    // everything into the Nyquist bin, which comes out of the FFT very 
+    // close to +/-1.0 (the sign depends on where the block starts in the 
+    // buffer).  One sample is adjusted so that the mean is 0 
+    // (nothing is removed).  The q15 result must still be scaled properly:
+    // a shift of 16 (DFT / N) is as far as it goes, so the Nyquist bin 
+    // ends up close to full scale.
+    for (int sign = -1; sign <= 1; sign += 2) {
+        q15 trigTable[fftN];
+        q15 buffer[fftN];
+        cq15 fftResult[fftN];
+        static cq31 fft31Result[fftN / 2 + 1];
+        FixedFFT31 fft31(fftN, SharedTables<log2fftN>::fixed31TrigTable());
+        // No window so that the input stays at full scale
+        SCAMPDemodulator demod(sampleFreq, lowFreq, log2fftN,
+            trigTable, 0, fftResult, buffer);
+        RecordingListener listener;
+        demod.setListener(&listener);
+        demod.setFFT31(&fft31, fft31Result);
+        for (uint16_t i = 0; i < fftN; i++) {
+            q15 s = ((i & 1) == (sign > 0 ? 1 : 0)) ? -32768 : 32767;
+            if (i == 0 || i == 1) {
+                s += (s < 0) ? fftN / 2 : 0;
+            }
+            demod.processSample(s);
+        }
+        cout << "q31 full scale : " << fft31Result[fftN / 2].r << " -> " 
+            << fftResult[fftN / 2].r << endl;
+        assert(std::abs(fftResult[fftN / 2].r) >= 0x7000);
+        assert((fftResult[fftN / 2].r < 0) == (fft31Result[fftN / 2].r < 0));
+        for (uint16_t i = 0; i < fftN / 2; i++) {
+            assert(std::abs(fftResult[i].r) < 16 && std::abs(fftResult[i].i) < 16);
+        }
+    }
+
+    // The same signal sampled at 8 kHz and moved up into channel 2 of an 
+    // 8-channel channelizer.  The channel comes out at 2 kHz, which is what
+    // the demodulator is designed for, and the mark/space land back on 
+    // 667/600 Hz.
+    {
+        memset((void*)samples8k, 0, sizeof(samples8k));
+        const uint16_t log2ChannelN = 3;
+        const uint16_t channelN = 1 << log2ChannelN;
+        const uint16_t tapsPerBranch = 16;
+        const uint16_t channel = 2;
+        const float offset = channel * 1000 - 500;
+        TestModem2 modem8k(samples8k, S * 4, sampleFreq * 4, markFreq + offset, 
+            spaceFreq + offset, 0.2, 0.1, 0.1);
+        makeSignal(modem8k);
+        assert(ChannelizerAdapter<SCAMPDemodulator>::freqToChannel(markFreq + offset, 
+            sampleFreq * 4, channelN) == channel);
+        assert(ChannelizerAdapter<SCAMPDemodulator>::toChannelFreq(markFreq + offset, 
+            channel, sampleFreq * 4, channelN) == markFreq);
+
+        // The sign flips saturate at full scale
+        {
+            struct { 
+                void processSample(q15 s) { samples[n++] = s; }
+                q15 samples[4];
+                int n = 0;
+            } sink;
+            ChannelizerAdapter<decltype(sink)> fullScale(sink, 0);
+            cq15 y[1];
+            y[0].r = -32768;
+            y[0].i = -32768;
+            for (int k = 0; k < 4; k++) 
+                fullScale.processOutputs(y);
+            assert(sink.samples[0] == -32768 && sink.samples[1] == 32767 &&
+                sink.samples[2] == 32767 && sink.samples[3] == -32768);
+        }
+
+        q15 chTrigTable[channelN];
+        q15 chFilter[FixedChannelizer::filterSpaceSize(log2ChannelN, tapsPerBranch)];
+        q15 chHistory[FixedChannelizer::historySpaceSize(log2ChannelN, tapsPerBranch)];
+        cq15 chOutput[channelN];
+        FixedChannelizer channelizer(log2ChannelN, tapsPerBranch, chTrigTable, 
+            chFilter, chHistory, chOutput);
+
+        q15 trigTable[fftN];
+        q15 window[fftN];
+        q15 buffer[fftN];
+        cq15 fftResult[fftN];
+        SCAMPDemodulator demod(sampleFreq, lowFreq, log2fftN,
+            trigTable, window, fftResult, buffer);
+        RecordingListener chListener;
+        demod.setListener(&chListener);
+        configure(demod, Options());
+        ChannelizerAdapter<SCAMPDemodulator> adapter(demod, channel);
+
+        for (uint32_t i = 0; i < modem8k.getSamplesUsed(); i++) {
+            if (channelizer.processSample(f32_to_q15(samples8k[i]))) {
+                adapter.processOutputs(channelizer.getOutputs());
+            }
+        }
+        cout << "Channelizer message : " << chListener.getMessage() << endl;
+        cout << "Channelizer mark    : " << demod.getMarkFreq() << endl;
+        assertm(chListener.getMessage().find("GOOD MORNING") != string::npos, "Channelizer decode failure");
+        assertm(chListener.getMessage().find("HAVE A GOOD DAY") != string::npos, "Channelizer decode failure");
+
+        // The same channel fed to a demodulator with complex input.  The 
+        // mark is above the channel center.
+        channelizer.reset();
+        cq15 iqBuffer[fftN];
+        cq15 iqFftResult[fftN];
+        SCAMPDemodulator iqDemod(sampleFreq, lowFreq, log2fftN,
+            trigTable, window, fftResult, buffer);
+        RecordingListener iqListener;
+        iqDemod.setListener(&iqListener);
+        configure(iqDemod, Options());
+        iqDemod.setComplexInput(iqBuffer, iqFftResult);
+        ComplexChannelizerAdapter<SCAMPDemodulator> iqAdapter(iqDemod, channel);
+        const float iqMarkFreq = ComplexChannelizerAdapter<SCAMPDemodulator>::toChannelFreq(
+            markFreq + offset, channel, sampleFreq * 4, channelN);
+        for (uint32_t i = 0; i < modem8k.getSamplesUsed(); i++) {
+            if (channelizer.processSample(f32_to_q15(samples8k[i]))) {
+                iqAdapter.processOutputs(channelizer.getOutputs());
+            }
+        }
+        cout << "Channelizer I/Q message : " << iqListener.getMessage() << endl;
+        cout << "Channelizer I/Q mark    : " << iqDemod.getMarkFreq() << " (expected " 
+            << iqMarkFreq << ")" << endl;
+        assert(std::abs(iqDemod.getMarkFreq() - iqMarkFreq) < 4);
+        assertm(iqListener.getMessage().find("GOOD MORNING") != string::npos, "Channelizer I/Q decode failure");
+        assertm(iqListener.getMessage().find("HAVE A GOOD DAY") != string::npos, "Channelizer I/Q decode failure");
+    }
+
+    // Complex (I/Q) input with the signal on the negative side of DC.  A 
+    // block run must match a sample-by-sample run and both matched filter
+    // engines should decode.
+    {
+        const float iqMarkFreq = -600;
+        IQModem iqModem(iqSamples, S, iqMarkFreq, iqMarkFreq - 66.6666666666, 
+            0.1, 0.05, 0.07);
+        makeSignal(iqModem);
+        const uint32_t iqSampleCount = iqModem.getSamplesUsed();
+
+        string refLog;
+        for (int engine = 0; engine < 2; engine++) {
+            for (size_t blockSize : { (size_t)0, (size_t)100 }) {
+
+                q15 trigTable[fftN];
+                q15 window[fftN];
+                q15 buffer[fftN];
+                cq15 fftResult[fftN];
+                cq15 iqBuffer[fftN];
+                cq15 iqFftResult[fftN];
+                SCAMPDemodulator demod(sampleFreq, lowFreq, log2fftN,
+                    trigTable, window, fftResult, buffer);
+                RecordingListener iqListener;
+                demod.setListener(&iqListener);
+                Options options;
+                options.incrementalCorr = (engine == 1);
+                configure(demod, options);
+                demod.setComplexInput(iqBuffer, iqFftResult);
+                assert(demod.isComplexInput());
+
+                if (blockSize == 0) {
+                    for (uint32_t i = 0; i < iqSampleCount; i++) {
+                        demod.processSample(iqSamples[i]);
+                    }
+                } else {
+                    for (uint32_t i = 0; i < iqSampleCount; i += blockSize) {
+                        size_t n = std::min((size_t)(iqSampleCount - i), blockSize);
+                        demod.processSamples(iqSamples + i, n);
+                    }
+                }
+
+                cout << "I/Q message (engine " << engine << ", block " << blockSize << ") : " 
+                    << iqListener.getMessage() << endl;
+                cout << "I/Q mark : " << demod.getMarkFreq() << endl;
+                // The lock is on the negative side (within a bin) and is 
+                // reported through the signed callback
+                assert(std::abs(demod.getMarkFreq() - iqMarkFreq) < 4);
+                assert(iqListener.getLog().find("LS -") != string::npos);
+                assertm(iqListener.getMessage().find("GOOD MORNING") != string::npos, "I/Q decode failure");
+                assertm(iqListener.getMessage().find("HAVE A GOOD DAY") != string::npos, "I/Q decode failure");
+                if (blockSize == 0) {
+                    refLog = iqListener.getLog();
+                } else {
+                    assertm(iqListener.getLog() == refLog, "I/Q block/sample mismatch");
+                }
+            }
+        }
+    }
+
+    // A listener that only knows about the unsigned callback still hears 
+    // about a complex lock
+    {
+        struct : public DemodulatorListener {
+            void frequencyLocked(uint16_t markFreq, uint16_t spaceFreq) {
+                mark = markFreq;
+            }
+            uint16_t mark = 0;
+        } oldListener;
+        DemodulatorListener& l = oldListener;
+        l.frequencyLockedSigned(-600, -667);
+        assert(oldListener.mark == (uint16_t)-600);
+    }
+
+    // The fixed-point engines (the incremental matched filter and the q15 
+    // LPF) should produce the same filtered correlations as the reference 
+    // to within a small tolerance (the raw correlations are within 16 q15 
+    // LSBs and the LPF has unity gain), and should decode the messages.  
+    // Decisions made on noise between the messages can differ.
+    for (int engines = 1; engines < 4; engines++) {
+        RecordingListener fixedListener;
+        Options options;
+        options.incrementalCorr = (engines & 1) != 0;
+        options.fixedPointFilter = (engines & 2) != 0;
+        demodulate(fixedListener, sampleCount, 256, options);
+        float maxError = maxCorrelationError(refListener, fixedListener);
+        cout << "Fixed point (incremental=" << options.incrementalCorr 
+            << ", filter=" << options.fixedPointFilter << ") message : " 
+            << fixedListener.getMessage() << endl;
+        cout << "  Max error : " << maxError << endl;
+        assertm(fixedListener.getMetricsCount() == refListener.getMetricsCount(), "Lock mismatch");
+        assertm(maxError < 0.0005, "Fixed point correlation mismatch");
+        assertm(fixedListener.getMessage().find("GOOD MORNING") != string::npos, "Fixed point decode failure");
+        assertm(fixedListener.getMessage().find("HAVE A GOOD DAY") != string::npos, "Fixed point decode failure");
+    }
+
+    // Batched metrics must carry exactly the same per-sample events. The 
+    // buffer size is deliberately not aligned with the processing blocks.
+    {
+        const uint16_t bufferSizes[] = { 1, 100, 256 };
+        for (uint16_t bufferSize : bufferSizes) {
+            RecordingListener batchListener;
+            Options options;
+            options.metricsBufferSize = bufferSize;
+            demodulate(batchListener, sampleCount, 256, options);
+            cout << "Metrics buffer " << bufferSize << " : " << batchListener.getMessage() 
+                << " (" << batchListener.getBatchCount() << " batches)" << endl;
+            assertm(batchListener.getBatchCount() > 0, "Metrics not batched");
+            assertm(batchListener.getMessage() == refListener.getMessage(), "Batched decode mismatch");
+            assertm(batchListener.getMetricsLog() == refListener.getMetricsLog(), "Batched metrics mismatch");
+        }
+    }
+
+    // Per-sample metrics compiled out
+    {
+        RecordingListener listener;
+        demodulateMetrics<false>(listener, sampleCount);
+        cout << "Metrics disabled : " << listener.getMessage() << endl;
+        assertm(listener.getMessage().find("GOOD MORNING") != string::npos, "Decode failure");
+        assertm(listener.getMetricsCount() == 0, "Metrics not disabled");
+    }
+
+    // Check for the loss of the signal while locked.  The signal ends with 
+    // 30 symbols of silence, which is enough to trigger the check.  The 
+    // band analysis only computes the bins used by the check.
+    for (int band = 0; band < 2; band++) {
+        q15 trigTable[fftN];
+        q15 window[fftN];
+        q15 buffer[fftN];
+        cq15 fftResult[fftN];
+        RecordingListener listener;
+
+        SCAMPDemodulator demod(sampleFreq, lowFreq, log2fftN,
+            trigTable, window, fftResult, buffer);
+        demod.setListener(&listener);
+        demod.setDetectionCorrelationThreshold(0.02);
+        demod.setBandAnalysisEnabled(band == 1);
+        demod.setLockedAnalysis(8, 3);
+        demod.processSamples(samplesQ15, sampleCount);
+
+        cout << "Loss check message " << (band ? "(band) " : "       ") << ": " << listener.getMessage() << endl;
+        cout << "Loss check count   " << (band ? "(band) " : "       ") << ": " << listener.getLockLostCount() << endl;
+        assertm(listener.getMessage().find("GOOD MORNING") != string::npos, "Decode failure");
+        assertm(listener.getLockLostCount() > 0, "Signal loss not detected");
+        assertm(!demod.isFrequencyLocked(), "Signal loss not detected");
+    }
+
+    // Steady-state cost while locked
+    {
+        const uint16_t runs = 5;
+        const uint16_t intervals[] = { 1, 16, 0 };
+        cout << "Locked demodulation, " << sampleCount << " samples, N=" << fftN << endl;
+        for (int sdft = 0; sdft < 2; sdft++) {
+            for (uint16_t interval : intervals) {
+                uint32_t us = 0;
+                for (uint16_t r = 0; r < runs; r++) {
+                    Options options;
+                    options.slidingDFT = (sdft == 1);
+                    us += demodulateLocked(sampleCount, interval, options);
+                }
+                cout << "  " << (sdft ? "Sliding DFT" : "FFT        ") 
+                    << " analysis interval " << interval << " : " 
+                    << (float)us / (float)runs / 1000.0 << " ms" << endl;
+            }
+        }
+        // With the signal loss check, which is all that the analysis is 
+        // needed for while locked
+        for (int band = 0; band < 2; band++) {
+            uint32_t us = 0;
+            for (uint16_t r = 0; r < runs; r++) {
+                Options options;
+                options.bandAnalysis = (band == 1);
+                us += demodulateLocked(sampleCount, 1, options, 1000);
+            }
+            cout << "  " << (band ? "Band DFT   " : "FFT        ") 
+                << " analysis interval 1 with loss check : " 
+                << (float)us / (float)runs / 1000.0 << " ms" << endl;
+        }
+    }
+
+    // Cost of the matched filter/LPF engines, with the locked spectral 
+    // analysis turned off to isolate the demodulator
+    {
+        const uint16_t runs = 5;
+        cout << "Demodulator engines, " << sampleCount << " samples" << endl;
+        for (int engines = 0; engines < 4; engines++) {
+            Options options;
+            options.incrementalCorr = (engines & 1) != 0;
+            options.fixedPointFilter = (engines & 2) != 0;
+            uint32_t us = 0;
+            for (uint16_t r = 0; r < runs; r++) {
+                us += demodulateLocked(sampleCount, 0, options);
+            }
+            cout << "  " << (options.incrementalCorr ? "Incremental" : "Full       ") 
+                << " correlation, " << (options.fixedPointFilter ? "q15" : "f32") 
+                << " LPF : " << (float)us / (float)runs / 1000.0 << " ms" << endl;
+        }
+    }
+
+    // Cost of the metrics delivery in the locked steady state
+    {
+        const uint16_t runs = 5;
+        uint32_t sampleUs = 0, batchUs = 0, disabledUs = 0;
+        Options batchOptions;
+        batchOptions.metricsBufferSize = 256;
+        for (uint16_t r = 0; r < runs; r++) {
+            CountingListener sampleListener, batchListener, disabledListener;
+            sampleUs += demodulateMetrics<true>(sampleListener, sampleCount);
+            batchUs += demodulateMetrics<true>(batchListener, sampleCount, batchOptions);
+            disabledUs += demodulateMetrics<false>(disabledListener, sampleCount);
+            assertm(sampleListener.getMetricsCount() == batchListener.getMetricsCount(), "Metrics count mismatch");
+        }
+        cout << "Metrics delivery, " << sampleCount << " samples" << endl;
+        cout << "  Per-sample   : " << (float)sampleUs / (float)runs / 1000.0 << " ms" << endl;
+        cout << "  Batched      : " << (float)batchUs / (float)runs / 1000.0 << " ms" << endl;
+        cout << "  Compiled out : " << (float)disabledUs / (float)runs / 1000.0 << " ms" << endl;
+    }
+
+    // Runtime vs. compile-time sizing
+    {
+        DemodulatorListener nullListener;
+        const uint16_t runs = 5;
+        uint32_t runtimeUs = 0, templateUs = 0;
+        for (uint16_t r = 0; r < runs; r++) {
+            runtimeUs += demodulate(nullListener, sampleCount, 256);
+            templateUs += demodulateT(nullListener, sampleCount, 256);
+        }
+        cout << "Sizing, " << sampleCount << " samples" << endl;
+        cout << "  SCAMPDemodulator     : " << (float)runtimeUs / (float)runs / 1000.0 << " ms" << endl;
+        cout << "  SCAMPDemodulatorT<" << log2fftN << "> : " << (float)templateUs / (float)runs / 1000.0 << " ms" << endl;
+    }
+
+    // Benchmark of the spectral analysis only (auto-lock is disabled so 
+    // the demodulator never locks).
+    {
+        DemodulatorListener nullListener;
+        const uint16_t runs = 5;
+        // The cost of the sliding DFT depends on the number of bins tracked
+        const uint16_t lowestFreqs[] = { lowFreq, 500 };
+        for (uint16_t lowestFreq : lowestFreqs) {
+            uint32_t fftUs = 0, sdftUs = 0;
+            Options fftOptions;
+            fftOptions.autoLock = false;
+            fftOptions.lowestFreq = lowestFreq;
+            Options sdftOptions = fftOptions;
+            sdftOptions.slidingDFT = true;
+            for (uint16_t r = 0; r < runs; r++) {
+                fftUs += demodulate(nullListener, sampleCount, 256, fftOptions);
+                sdftUs += demodulate(nullListener, sampleCount, 256, sdftOptions);
+            }
+            cout << "Spectral analysis, " << sampleCount << " samples, N=" << fftN 
+                << ", " << lowestFreq << " Hz and up" << endl;
+            cout << "  FFT every 32 samples : " << (float)fftUs / (float)runs / 1000.0 << " ms" << endl;
+            cout << "  Sliding DFT          : " << (float)sdftUs / (float)runs / 1000.0 << " ms" << endl;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,398 @@
+/*
+SCAMP Encoder/Decoder
+Copyright (C) 2024 - Bruce MacKinnon KC1FSZ
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+// Multi-channel skimmer test.  Several SCAMP signals are mixed together
+// and each should be found and decoded on its own channel.
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <cassert>
+#include <cstring>
+#include <chrono>
+
+#include "../../scamp/Util.h"
+#include "../../scamp/Frame30.h"
+#include "../../scamp/SCAMPChannel.h"
+
+#include "../../util/fixed_math.h"
+#include "../../util/FSKSkimmer.h"
+#include "../../util/FSKChannelPool.h"
+
+#include "TestModem2.h"
+
+// Use (void) to silence unused warnings.
+#define assertm(exp, msg) assert(((void)msg, exp))
+
+using namespace std;
+using namespace radlib;
+
+// ------ Data Area -------
+
+const unsigned int sampleFreq = 2000;
+const uint16_t lowFreq = 50;
+const unsigned int samplesPerSymbol = 60;
+const unsigned int usPerSymbol = (1000000 / sampleFreq) * samplesPerSymbol;
+// The SCAMP FSK shift
+const unsigned int shiftFreq = 67;
+
+const uint16_t log2fftN = 9;
+const uint16_t fftN = 1 << log2fftN;
+
+// The signals being mixed together.  The starts are staggered so the
+// long marks don't all line up.
+const uint16_t signalCount = 4;
+const unsigned int markFreqs[signalCount] = { 300, 500, 700, 900 };
+const unsigned int leadSymbols[signalCount] = { 30, 75, 45, 90 };
+const char* testMessages[signalCount] = {
+    "DE KC1FSZ, GOOD MORNING",
+    "CQ CQ DE W1AW",
+    "73S, HAVE A GOOD DAY",
+    "TEST 1 2 3"
+};
+
+const unsigned int S = 1500 * samplesPerSymbol;
+static float signalSamples[S];
+static float samples[S];
+static q15 samplesQ15[S];
+static uint32_t sampleCount = 0;
+
+const uint16_t channelCount = 8;
+
+// Space for the skimmer to work in (no dynamic memory allocation!)
+static q15 trigTable[fftN];
+static q15 window[fftN];
+static q15 buffer[fftN];
+static cq15 fftResult[fftN];
+static uint8_t binScore[FSKSkimmer::binScoreSpaceSize(log2fftN)];
+
+/**
+ * Keeps track of what happens on one channel.
+ */
+class ChannelListener : public DemodulatorListener {
+public:
+
+    virtual void frequencyLocked(uint16_t markFreq, uint16_t spaceFreq) {
+        _log << "L " << markFreq << "\n";
+        _markFreq = markFreq;
+        _lockCount++;
+    }
+
+    virtual void frequencyLockLost() {
+        _log << "U\n";
+        _lockLostCount++;
+    }
+
+    virtual void symbolTransitionDetected() {
+        _log << "T\n";
+    }
+
+    virtual void received(char asciiChar) {
+        _log << "C " << asciiChar << "\n";
+        _msg << asciiChar;
+    }
+
+    virtual void receivedBit(bool bit, uint16_t frameBitPos, int syncFrameCorr) {
+        _log << "B " << bit << " " << frameBitPos << " " << syncFrameCorr << "\n";
+    }
+
+    string getLog() const { return _log.str(); }
+    string getMessage() const { return _msg.str(); }
+    uint16_t getMarkFreq() const { return _markFreq; }
+    uint16_t getLockCount() const { return _lockCount; }
+    uint16_t getLockLostCount() const { return _lockLostCount; }
+
+private:
+
+    ostringstream _log;
+    ostringstream _msg;
+    uint16_t _markFreq = 0;
+    uint16_t _lockCount = 0;
+    uint16_t _lockLostCount = 0;
+};
+
+/**
+ * Writes the events from all of the channels into one shared log, tagged
+ * with the channel number.  This is not thread-safe.
+ */
+class SharedLogListener : public DemodulatorListener {
+public:
+
+    void setLog(ostringstream* log, uint16_t channel) { 
+        _sharedLog = log;
+        _channel = channel;
+    }
+
+    virtual void frequencyLocked(uint16_t markFreq, uint16_t spaceFreq) {
+        *_sharedLog << _channel << " L " << markFreq << "\n";
+    }
+
+    virtual void frequencyLockLost() {
+        *_sharedLog << _channel << " U\n";
+    }
+
+    virtual void symbolTransitionDetected() {
+        *_sharedLog << _channel << " T\n";
+    }
+
+    virtual void received(char asciiChar) {
+        *_sharedLog << _channel << " C " << asciiChar << "\n";
+    }
+
+    virtual void receivedBit(bool bit, uint16_t frameBitPos, int syncFrameCorr) {
+        *_sharedLog << _channel << " B " << bit << " " << frameBitPos << " " << syncFrameCorr << "\n";
+    }
+
+private:
+
+    ostringstream* _sharedLog = 0;
+    uint16_t _channel = 0;
+};
+
+/**
+ * Adds one SCAMP signal to the sample buffer.
+ *
+ * @returns The number of samples used.
+ */
+static uint32_t addSignal(unsigned int markFreq, unsigned int leadSymbolCount,
+    const char* message) {
+
+    memset((void*)signalSamples, 0, sizeof(signalSamples));
+    TestModem2 modem2(signalSamples, S, sampleFreq, markFreq, markFreq - shiftFreq, 0.15);
+
+    Frame30 frames[32];
+    unsigned int frameCount = encodeString(message, frames, 32, true);
+    assertm(frameCount < 32, "FRAME COUNT");
+
+    for (unsigned int i = 0; i < leadSymbolCount; i++)
+        modem2.sendSilence(usPerSymbol);
+    for (unsigned int i = 0; i < frameCount; i++)
+        frames[i].transmit(modem2, usPerSymbol);
+    for (unsigned int i = 0; i < 60; i++)
+        modem2.sendSilence(usPerSymbol);
+
+    for (uint32_t i = 0; i < modem2.getSamplesUsed(); i++) {
+        samples[i] += signalSamples[i];
+    }
+    return modem2.getSamplesUsed();
+}
+
+/**
+ * Runs the skimmer across the signal with a new set of channels.
+ *
+ * @param listeners One for each channel.
+ * @returns The largest number of channels that were active at once.
+ */
+template <class L>
+static uint16_t skim(L* listeners, uint16_t count, size_t blockSize,
+    FSKChannelExecutor* executor = 0) {
+
+    FSKChannel* channels[channelCount];
+    assertm(count <= channelCount, "Too many channels");
+    for (uint16_t c = 0; c < count; c++) {
+        channels[c] = new SCAMPChannel(sampleFreq, log2fftN, trigTable);
+        channels[c]->setListener(&listeners[c]);
+        channels[c]->setDetectionCorrelationThreshold(0.02);
+    }
+
+    FSKSkimmer skimmer(sampleFreq, lowFreq, log2fftN, trigTable, window,
+        fftResult, buffer, binScore, channels, count);
+    skimmer.setExecutor(executor);
+
+    uint16_t maxActive = 0;
+    for (uint32_t i = 0; i < sampleCount; i += blockSize) {
+        size_t n = std::min((size_t)(sampleCount - i), blockSize);
+        skimmer.processSamples(samplesQ15 + i, n);
+        maxActive = std::max(maxActive, skimmer.getActiveChannelCount());
+    }
+    // The signals all end with silence, so the channels are released
+    assertm(skimmer.getActiveChannelCount() == 0, "Channels not released");
+
+    for (uint16_t c = 0; c < count; c++) {
+        delete channels[c];
+    }
+    return maxActive;
+}
+
+int main(int, const char**) {
+
+    memset((void*)samples, 0, sizeof(samples));
+
+    for (uint16_t i = 0; i < signalCount; i++) {
+        sampleCount = std::max(sampleCount, addSignal(markFreqs[i], leadSymbols[i], testMessages[i]));
+    }
+    // A DC bias and some noise
+    TestModem2 noise(signalSamples, S, sampleFreq, 0, 0, 0, 0.1, 0.1);
+    noise.sendSilence((uint32_t)((uint64_t)sampleCount * 1000000 / sampleFreq));
+    for (uint32_t i = 0; i < sampleCount; i++) {
+        samplesQ15[i] = f32_to_q15(samples[i] + signalSamples[i]);
+    }
+
+    // Decode everything that is present
+    ChannelListener listeners[channelCount];
+    {
+        const uint16_t maxActive = skim(listeners, channelCount, 256);
+
+        for (uint16_t c = 0; c < channelCount; c++) {
+            if (listeners[c].getLockCount() > 0) {
+                cout << "Channel " << c << " : mark=" << listeners[c].getMarkFreq()
+                    << " locks=" << listeners[c].getLockCount()
+                    << " message=" << listeners[c].getMessage() << endl;
+            }
+        }
+        cout << "Max active channels : " << maxActive << endl;
+
+        // Each signal should have been decoded on the channel that locked
+        // onto its mark
+        for (uint16_t i = 0; i < signalCount; i++) {
+            bool found = false;
+            for (uint16_t c = 0; c < channelCount; c++) {
+                const int err = (int)listeners[c].getMarkFreq() - (int)markFreqs[i];
+                if (listeners[c].getLockCount() > 0 && err >= -4 && err <= 4 &&
+                    listeners[c].getMessage().find(testMessages[i]) != string::npos) {
+                    found = true;
+                }
+            }
+            assertm(found, "Signal not decoded");
+        }
+        assertm(maxActive == signalCount, "Wrong number of channels");
+    }
+
+    // The events seen by each channel must not depend on the block size or
+    // on the threads used
+    {
+        const uint16_t threadCounts[] = { 1, 2, 4, 7 };
+        for (uint16_t threadCount : threadCounts) {
+            FSKChannelPool pool(threadCount);
+            ChannelListener poolListeners[channelCount];
+            skim(poolListeners, channelCount, 1000, &pool);
+            for (uint16_t c = 0; c < channelCount; c++) {
+                assertm(poolListeners[c].getLog() == listeners[c].getLog(), "Thread pool mismatch");
+            }
+        }
+        ChannelListener sampleListeners[channelCount];
+        skim(sampleListeners, channelCount, 1);
+        for (uint16_t c = 0; c < channelCount; c++) {
+            assertm(sampleListeners[c].getLog() == listeners[c].getLog(), "Block size mismatch");
+        }
+    }
+
+    // When the channels share a listener the events from all of the 
+    // channels must come out in the same order (and on this thread) no 
+    // matter how many threads are used
+    {
+        const size_t blockSize = 1000;
+        const uint16_t threadCounts[] = { 2, 4, 7 };
+        ostringstream log1;
+        {
+            FSKChannelPool pool(1);
+            SharedLogListener poolListeners[channelCount];
+            for (uint16_t c = 0; c < channelCount; c++) {
+                poolListeners[c].setLog(&log1, c);
+            }
+            skim(poolListeners, channelCount, blockSize, &pool);
+        }
+        assertm(log1.str().find(" C ") != string::npos, "No characters received");
+        for (uint16_t threadCount : threadCounts) {
+            ostringstream logN;
+            FSKChannelPool pool(threadCount);
+            SharedLogListener poolListeners[channelCount];
+            for (uint16_t c = 0; c < channelCount; c++) {
+                poolListeners[c].setLog(&logN, c);
+            }
+            skim(poolListeners, channelCount, blockSize, &pool);
+            assertm(logN.str() == log1.str(), "Shared listener order mismatch");
+        }
+        // The same as running without the pool
+        ostringstream log0;
+        SharedLogListener listeners0[channelCount];
+        for (uint16_t c = 0; c < channelCount; c++) {
+            listeners0[c].setLog(&log0, c);
+        }
+        skim(listeners0, channelCount, blockSize);
+        assertm(log0.str() == log1.str(), "Shared listener order mismatch (no pool)");
+    }
+
+    // The cost per channel.  Channels are started manually across the band
+    // and are never released.
+    {
+        const uint16_t benchChannelCount = 32;
+        const uint16_t runs = 3;
+        ChannelListener benchListeners[benchChannelCount];
+        FSKChannel* channels[benchChannelCount];
+        for (uint16_t c = 0; c < benchChannelCount; c++) {
+            channels[c] = new SCAMPChannel(sampleFreq, log2fftN, trigTable);
+            channels[c]->setListener(&benchListeners[c]);
+            channels[c]->setDetectionCorrelationThreshold(0.02);
+        }
+
+        const uint16_t channelCounts[] = { 0, 8, 32 };
+        cout << "Skimmer, " << sampleCount << " samples ("
+            << (float)sampleCount / (float)sampleFreq << " seconds)" << endl;
+        for (uint16_t count : channelCounts) {
+            uint32_t us = 0;
+            for (uint16_t r = 0; r < runs; r++) {
+                FSKSkimmer skimmer(sampleFreq, lowFreq, log2fftN, trigTable, window,
+                    fftResult, buffer, binScore, channels, count);
+                skimmer.setChannelLossLimit(0);
+                for (uint16_t c = 0; c < count; c++) {
+                    skimmer.startChannel(100 + c * 25);
+                }
+                auto start = std::chrono::steady_clock::now();
+                for (uint32_t i = 0; i < sampleCount; i += 256) {
+                    size_t n = std::min((size_t)(sampleCount - i), (size_t)256);
+                    skimmer.processSamples(samplesQ15 + i, n);
+                }
+                auto end = std::chrono::steady_clock::now();
+                us += std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+                skimmer.reset();
+            }
+            cout << "  " << count << " channels : " << (float)us / (float)runs / 1000.0 << " ms" << endl;
+        }
+
+        // Scaling across threads with all of the channels running
+        cout << "Skimmer threads, " << benchChannelCount << " channels, " 
+            << std::thread::hardware_concurrency() << " cores" << endl;
+        const uint16_t threadCounts[] = { 1, 2, 4, 8, 16 };
+        for (uint16_t threadCount : threadCounts) {
+            FSKChannelPool pool(threadCount);
+            uint32_t us = 0;
+            for (uint16_t r = 0; r < runs; r++) {
+                FSKSkimmer skimmer(sampleFreq, lowFreq, log2fftN, trigTable, window,
+                    fftResult, buffer, binScore, channels, benchChannelCount);
+                skimmer.setChannelLossLimit(0);
+                skimmer.setExecutor(&pool);
+                for (uint16_t c = 0; c < benchChannelCount; c++) {
+                    skimmer.startChannel(100 + c * 25);
+                }
+                auto start = std::chrono::steady_clock::now();
+                for (uint32_t i = 0; i < sampleCount; i += 1024) {
+                    size_t n = std::min((size_t)(sampleCount - i), (size_t)1024);
+                    skimmer.processSamples(samplesQ15 + i, n);
+                }
+                auto end = std::chrono::steady_clock::now();
+                us += std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+                skimmer.reset();
+            }
+            cout << "  " << threadCount << " threads : " << (float)us / (float)runs / 1000.0 << " ms" << endl;
+        }
+
+        for (uint16_t c = 0; c < benchChannelCount; c++) {
+            delete channels[c];
+        }
+    }
+
+    return 0;
+}
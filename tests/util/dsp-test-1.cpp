@@ -1,10 +1,13 @@
 #include <iostream>
 #include <cassert>
+#include <chrono>
+#include <random>
 
 #include "../../util/fixed_math.h"
 #include "../../util/fixed_fft.h"
 #include "../../util/f32_fft.h"
 #include "../../util/dsp_util.h"
+#include "../../util/Convolver.h"
 
 using namespace std;
 using namespace radlib;
@@ -506,11 +509,121 @@ static void test_set_4() {
     //}
 }
 
+// Inverse FFT
+static void test_set_5() {
+
+    const uint16_t N = 256;
+    float trig_area[N];
+    F32FFT fft(N, trig_area);
+
+    std::mt19937 gen(5);
+    std::uniform_real_distribution<float> dist(-1.0, 1.0);
+    cf32 x[N], y[N];
+    for (uint16_t i = 0; i < N; i++) {
+        x[i] = cf32(dist(gen), dist(gen));
+        y[i] = x[i];
+    }
+
+    // Complex
+    fft.transform(y);
+    fft.inverseTransform(y);
+    for (uint16_t i = 0; i < N; i++) {
+        assert(std::abs(y[i].r - x[i].r) < 1e-5);
+        assert(std::abs(y[i].i - x[i].i) < 1e-5);
+    }
+
+    // Real (the entries are the packed samples)
+    cf32 z[N / 2 + 1];
+    for (uint16_t i = 0; i < N / 2; i++) {
+        z[i] = x[i];
+    }
+    fft.transformReal(z);
+    fft.inverseTransformReal(z);
+    for (uint16_t i = 0; i < N / 2; i++) {
+        assert(std::abs(z[i].r - x[i].r) < 1e-5);
+        assert(std::abs(z[i].i - x[i].i) < 1e-5);
+    }
+}
+
+// Streaming convolution
+static void test_set_6() {
+
+    const unsigned int S = 4096;
+    const uint16_t maxTaps = 256;
+    const uint16_t maxFFTN = Convolver::fftSize(maxTaps);
+    static f32 in[S], ref[S], out[S];
+    static f32 h[maxTaps];
+    static float trigTable[maxFFTN];
+    static f32 buffer[Convolver::bufferSpaceSize(maxTaps, maxFFTN)];
+    static cf32 filter[Convolver::spectrumSpaceSize(maxFFTN)];
+    static cf32 work[Convolver::spectrumSpaceSize(maxFFTN)];
+
+    std::mt19937 gen(6);
+    std::uniform_real_distribution<float> dist(-1.0, 1.0);
+    for (unsigned int i = 0; i < S; i++) {
+        in[i] = dist(gen);
+    }
+    for (uint16_t k = 0; k < maxTaps; k++) {
+        h[k] = dist(gen) / 16.0;
+    }
+
+    // Same result as convolve_f32() for both forms, with the stream 
+    // broken up into uneven pieces
+    const uint16_t tapCounts[] = { 1, 7, 31, 33, 100, 256 };
+    const unsigned int chunks[] = { 1, 17, 100, 1000 };
+    for (uint16_t taps : tapCounts) {
+        convolve_f32(ref, in, S, h, taps);
+        const uint16_t fftN = Convolver::fftSize(taps);
+        F32FFT fft(fftN, trigTable);
+        Convolver conv(h, taps, &fft, buffer, filter, work);
+        assert(conv.isFFT() == (taps >= Convolver::DEFAULT_FFT_CROSSOVER));
+        for (int mode = 0; mode < 2; mode++) {
+            conv.setFFTCrossover(mode == 0 ? 0xffff : 1);
+            assert(conv.isFFT() == (mode == 1));
+            unsigned int i = 0, c = 0;
+            while (i < S) {
+                const unsigned int n = std::min(chunks[c++ % 4], S - i);
+                conv.process(in + i, out + i, n);
+                i += n;
+            }
+            float maxError = 0;
+            for (unsigned int i = 0; i < S; i++) {
+                maxError = std::max(maxError, std::abs(out[i] - ref[i]));
+            }
+            assert(maxError < 1e-4);
+        }
+    }
+
+    // Crossover benchmark (1024 samples per call)
+    cout << "Convolution of " << S << " samples (us), taps / direct / FFT (N)" << endl;
+    for (uint16_t taps = 4; taps <= maxTaps; taps *= 2) {
+        const uint16_t fftN = Convolver::fftSize(taps);
+        F32FFT fft(fftN, trigTable);
+        Convolver conv(h, taps, &fft, buffer, filter, work);
+        float us[2];
+        for (int mode = 0; mode < 2; mode++) {
+            conv.setFFTCrossover(mode == 0 ? 0xffff : 1);
+            const unsigned int reps = 10;
+            auto start = std::chrono::steady_clock::now();
+            for (unsigned int r = 0; r < reps; r++) {
+                for (unsigned int i = 0; i < S; i += 1024) {
+                    conv.process(in + i, out + i, 1024);
+                }
+            }
+            auto end = std::chrono::steady_clock::now();
+            us[mode] = (float)std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / (float)reps;
+        }
+        cout << "  " << taps << " / " << us[0] << " / " << us[1] << " (" << fftN << ")" << endl;
+    }
+}
+
 int main(int, const char**) {
     test_set_1();
     test_set_2();
     test_set_3();
     test_set_4();
+    test_set_5();
+    test_set_6();
 }
 
 
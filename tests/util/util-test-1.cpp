@@ -1,10 +1,26 @@
 #include <iostream>
 #include <cassert>
+#include <chrono>
+#include <random>
+#if defined(__x86_64__)
+#include <x86intrin.h>
+#endif
 
 #include "../../util/fixed_math.h"
 #include "../../util/fixed_fft.h"
 #include "../../util/f32_fft.h"
 #include "../../util/dsp_util.h"
+#include "../../util/SlidingDFT.h"
+#include "../../util/SlidingCorrelator.h"
+#include "../../util/PolyphaseChannelizer.h"
+#include "../../util/simd_q15.h"
+#include "../../util/SharedTables.h"
+#include "../../util/BandDFT.h"
+#include "../../util/fixed_fft31.h"
+#include "../../util/FirFilter.h"
+#include "../../util/Resampler.h"
+#include "../../util/CICDecimator.h"
+#include "../../util/NCO.h"
 
 using namespace std;
 using namespace radlib;
@@ -172,13 +188,14 @@ static void test_set_2() {
     // FFT after filtering.  We expect to see the power cut in half
     {
         float filteredSamples[samplesSize];
+        const uint16_t h_500_n = sizeof(h_500) / sizeof(h_500[0]);
         // Here is where we convolve the FIR filter coefficients with 
         // the tone.
         for (uint16_t i = 0; i < samplesSize; i++) {
             // Check to see whether we have enough samples to convolve yet
-            if (i >= sizeof(h_500)) {
+            if (i >= h_500_n) {
                 float conv = 0;
-                for (uint16_t k = 0; k < sizeof(h_500); k++) {
+                for (uint16_t k = 0; k < h_500_n; k++) {
                     // Multiply-accumulate.  Looking backwards through the samples
                     // and forwards across the h[k] transfer function.
                     conv += samples[i - k] * h_500[k];
@@ -193,7 +210,7 @@ static void test_set_2() {
         cf32 fftResult[fftN];
         for (uint16_t i = 0; i < fftN; i++) {
             // Notice: we are ignoring the zero section!
-            fftInput[i].r = filteredSamples[i + sizeof(h_500)];
+            fftInput[i].r = filteredSamples[i + h_500_n];
             fftInput[i].i = 0;
         }
         simpleDFT(fftInput, fftResult, fftN);
@@ -370,10 +387,1501 @@ void test_set_1() {
         cout << "  Max Freq : " << fft.binToFreq(maxBin, sampleFreq) << endl;
         cout << "  Max Mag  : " << fftResult[maxBin].mag_f32() << endl;
     }
+    // The real-input FFT (N/2 point transform + split) should match the full
+    // complex FFT of the same series.
+    {
+        const uint16_t samplesSize = 2000;
+        float samples[samplesSize];
+        float tone[samplesSize];
+        make_real_tone_f32(samples, samplesSize, sampleFreq, 433.3, 0.4);
+        make_real_tone_f32(tone, samplesSize, sampleFreq, 120.0, 0.3);
+        for (uint16_t i = 0; i < fftN; i++) {
+            // A DC offset and some deterministic "noise"
+            samples[i] += tone[i] + 0.1 + 0.05 * std::sin((float)(i * i) * 0.37f);
+        }
+
+        float f32TrigTable[fftN];
+        F32FFT f32fft(fftN, f32TrigTable);
+        cf32 f32Full[fftN];
+        cf32 f32Real[fftN / 2 + 1];
+        q15 trigTable[fftN];
+        FixedFFT fft(fftN, trigTable);
+        cq15 full[fftN];
+        cq15 real[fftN / 2 + 1];
+
+        for (uint16_t i = 0; i < fftN; i++) {
+            f32Full[i] = cf32(samples[i], 0);
+            full[i].r = f32_to_q15(samples[i]);
+            full[i].i = 0;
+        }
+        for (uint16_t i = 0; i < fftN / 2; i++) {
+            f32Real[i] = cf32(samples[2 * i], samples[2 * i + 1]);
+            real[i].r = f32_to_q15(samples[2 * i]);
+            real[i].i = f32_to_q15(samples[2 * i + 1]);
+        }
+
+        f32fft.transform(f32Full);
+        f32fft.transformReal(f32Real);
+        fft.transform(full);
+        fft.transformReal(real);
+
+        float f32MaxError = 0;
+        float maxError = 0;
+        for (uint16_t k = 0; k <= fftN / 2; k++) {
+            f32MaxError = std::max(f32MaxError, std::abs(f32Full[k].r - f32Real[k].r));
+            f32MaxError = std::max(f32MaxError, std::abs(f32Full[k].i - f32Real[k].i));
+            maxError = std::max(maxError, std::abs(q15_to_f32(full[k].r) - q15_to_f32(real[k].r)));
+            maxError = std::max(maxError, std::abs(q15_to_f32(full[k].i) - q15_to_f32(real[k].i)));
+        }
+
+        cout << "Real-Input FFT" << endl;
+        cout << "  Max Error (f32) : " << f32MaxError << endl;
+        cout << "  Max Error (q15) : " << maxError << endl;
+        cout << "  Bin " << fftN / 2 << " (q15) : " << real[fftN / 2].r << " " << full[fftN / 2].r << endl;
+        assert(f32MaxError < 0.000001);
+        // Both versions truncate at every stage, so they differ by a few 
+        // LSBs
+        assert(maxError < 8.0 / 32768.0);
+    }
+}
+
+// Tests related to the sliding DFT
+static void test_set_4() {
+
+    const uint16_t sampleFreq = 2000;
+    const uint16_t log2fftN = 9;
+    const uint16_t fftN = 1 << log2fftN;
+    const uint16_t firstBin = 12;
+    const uint16_t lastBin = fftN / 2 - 1;
+
+    q15 fftTrigTable[fftN];
+    q15 fftWindow[fftN];
+    cq15 fftResult[fftN];
+    cq15 sdftResult[fftN];
+    FixedFFT fft(fftN, fftTrigTable);
+
+    for (uint16_t i = 0; i < fftN; i++) {
+        fftWindow[i] = f32_to_q15(0.5 * (1.0 - std::cos(2.0 * pi() * ((float) i) / ((float)fftN))));
+    }
+
+    SlidingDFT::Bin binSpace[SlidingDFT::binSpaceSize(firstBin, lastBin)];
+    SlidingDFT sdft(log2fftN, firstBin, lastBin, fftTrigTable, binSpace);
+
+    // Two tones and a DC offset
+    const uint16_t samplesSize = 2000;
+    q15 samples[samplesSize];
+    make_real_tone_distorted(samples, samplesSize, sampleFreq, 667, 0.25, 0, 0.1);
+    add_real_tone_q15(samples, samplesSize, sampleFreq, 431, 0.125, 33.0);
+
+    // Run the samples through a circular buffer, keeping the sliding DFT
+    // up to date as we go.
+    q15 buffer[fftN];
+    for (uint16_t i = 0; i < fftN; i++) {
+        buffer[i] = 0;
+    }
+    uint16_t bufferPtr = 0;
+    for (uint16_t n = 0; n < samplesSize; n++) {
+        sdft.update(samples[n], buffer[bufferPtr], bufferPtr);
+        buffer[bufferPtr] = samples[n];
+        bufferPtr = (bufferPtr + 1) & (fftN - 1);
+    }
+
+    // Compare against the FFT with and without the window. The window is 
+    // started at an arbitrary location in the circular buffer.
+    for (int w = 0; w < 2; w++) {
+
+        const bool hann = (w == 1);
+        const uint16_t windowStart = bufferPtr + 37;
+
+        for (uint16_t i = 0; i < fftN; i++) {
+            q15 s = buffer[wrapIndex(windowStart, i, fftN)];
+            fftResult[i].r = hann ? mult_q15(s, fftWindow[i]) : s;
+            fftResult[i].i = 0;
+        }
+        fft.transform(fftResult);
+        sdft.getSpectrum(sdftResult, windowStart, hann);
+
+        float maxError = 0;
+        for (uint16_t k = firstBin; k <= lastBin; k++) {
+            float er = q15_to_f32(fftResult[k].r - sdftResult[k].r);
+            float ei = q15_to_f32(fftResult[k].i - sdftResult[k].i);
+            maxError = std::max(maxError, std::sqrt(er * er + ei * ei));
+        }
+        const uint16_t fftMaxBin = max_idx_2(fftResult, firstBin, fftN / 2);
+        const uint16_t sdftMaxBin = max_idx_2(sdftResult, firstBin, fftN / 2);
+
+        cout << "Sliding DFT (hann=" << hann << ")" << endl;
+        cout << "  Max Bin   : " << sdftMaxBin << endl;
+        cout << "  Max Mag   : " << sdftResult[sdftMaxBin].mag_f32() << endl;
+        cout << "  Max Error : " << maxError << endl;
+        assert(fftMaxBin == sdftMaxBin);
+        // The FFT loses a little bit of precision in each stage
+        assert(maxError < 0.001);
+    }
+
+    // A resync from the buffer contents gives exactly the same result
+    cq15 resyncResult[fftN];
+    sdft.getSpectrum(sdftResult, bufferPtr, true);
+    sdft.resync(buffer);
+    sdft.getSpectrum(resyncResult, bufferPtr, true);
+    for (uint16_t k = firstBin; k <= lastBin; k++) {
+        assert(sdftResult[k].r == resyncResult[k].r);
+        assert(sdftResult[k].i == resyncResult[k].i);
+    }
+}
+
+// Tests related to the incremental correlator
+static void test_set_5() {
+
+    const uint16_t sampleFreq = 2000;
+    const uint16_t log2fftN = 9;
+    const uint16_t fftN = 1 << log2fftN;
+    const uint16_t log2ToneN = 4;
+    const uint16_t toneN = 1 << log2ToneN;
+
+    q15 fftTrigTable[fftN];
+    FixedFFT fft(fftN, fftTrigTable);
+
+    // Spot check the integer square root
+    assert(isqrt_u32(0) == 0);
+    assert(isqrt_u32(15) == 3);
+    assert(isqrt_u32(16) == 4);
+    assert(isqrt_u32(0xffffffff) == 0xffff);
+    for (uint32_t a = 1; a != 0 && a < 0xfff00000; a = a * 3 + 7) {
+        const uint32_t r = isqrt_u32(a);
+        assert(r * r <= a && (uint64_t)(r + 1) * (r + 1) > a);
+    }
+
+    // A tone that is on-frequency for one of the correlators, plus a strong 
+    // interfering tone and a DC offset.  This pushes the samples close to 
+    // full scale.
+    const uint16_t samplesSize = 4000;
+    q15 samples[samplesSize];
+    make_real_tone_distorted(samples, samplesSize, sampleFreq, 667, 0.4, 0, 0.1);
+    add_real_tone_q15(samples, samplesSize, sampleFreq, 431, 0.3, 33.0);
+
+    const float toneFreqs[2] = { 600.5, 667 };
+
+    for (uint16_t t = 0; t < 2; t++) {
+
+        cq15 tone[toneN];
+        make_complex_tone_cq15(tone, toneN, sampleFreq, toneFreqs[t], 0.5);
+
+        SlidingCorrelator::Product history[toneN];
+        SlidingCorrelator corr(log2ToneN, log2fftN, fftTrigTable, history);
+        corr.setTone(sampleFreq, toneFreqs[t]);
+
+        // Run the samples through a circular buffer like the Demodulator
+        q15 buffer[fftN];
+        for (uint16_t i = 0; i < fftN; i++) {
+            buffer[i] = 0;
+        }
+        uint16_t bufferPtr = 0;
+        float maxError = 0;
+        float maxCorr = 0;
+
+        for (uint16_t n = 0; n < samplesSize; n++) {
+            buffer[bufferPtr] = samples[n];
+            corr.update(samples[n]);
+            bufferPtr = (bufferPtr + 1) & (fftN - 1);
+            // Compare the window that ends with the latest sample
+            float c0 = corr_q15_cq15_2(buffer, bufferPtr + fftN - toneN, fftN, tone, toneN);
+            float c1 = q15_to_f32(corr.getMagnitude());
+            maxError = std::max(maxError, std::abs(c0 - c1));
+            maxCorr = std::max(maxCorr, c0);
+        }
+
+        cout << "Incremental Correlation (tone=" << toneFreqs[t] << ")" << endl;
+        cout << "  Max Corr  : " << maxCorr << endl;
+        cout << "  Max Error : " << maxError << endl;
+        // The difference comes mostly from the phase resolution of the trig 
+        // table.  The tolerance is 16 q15 LSBs, which is well under 1% of 
+        // the on-frequency correlation.
+        assert(maxError < 0.0005);
+    }
+
+    // The same check with complex (I/Q) samples and a negative frequency
+    {
+        const float toneFreq = -433.3;
+        cq15 iq[samplesSize];
+        make_complex_tone_cq15(iq, samplesSize, sampleFreq, toneFreq, 0.7);
+        for (uint16_t n = 0; n < samplesSize; n++) {
+            iq[n].r += samples[n] / 4;
+        }
+
+        cq15 tone[toneN];
+        make_complex_tone_cq15(tone, toneN, sampleFreq, toneFreq, 0.5);
+        SlidingCorrelator::Product history[toneN];
+        SlidingCorrelator corr(log2ToneN, log2fftN, fftTrigTable, history);
+        corr.setTone(sampleFreq, toneFreq);
+
+        cq15 buffer[fftN];
+        uint16_t bufferPtr = 0;
+        float maxError = 0;
+        float maxCorr = 0;
+        for (uint16_t n = 0; n < samplesSize; n++) {
+            buffer[bufferPtr] = iq[n];
+            corr.update(iq[n]);
+            bufferPtr = (bufferPtr + 1) & (fftN - 1);
+            // Skip until the buffer is full
+            if (n < fftN) {
+                continue;
+            }
+            float c0 = corr_cq15_cq15_2(buffer, bufferPtr + fftN - toneN, fftN, tone, toneN);
+            float c1 = q15_to_f32(corr.getMagnitude());
+            maxError = std::max(maxError, std::abs(c0 - c1));
+            maxCorr = std::max(maxCorr, c0);
+        }
+
+        cout << "Incremental Correlation (complex, tone=" << toneFreq << ")" << endl;
+        cout << "  Max Corr  : " << maxCorr << endl;
+        cout << "  Max Error : " << maxError << endl;
+        assert(maxCorr > 0.3);
+        assert(maxError < 0.0005);
+    }
+}
+
+
+// Tests related to the polyphase channelizer
+static void test_set_6() {
+
+    const float sampleFreq = 8000;
+    const uint16_t log2ChannelN = 3;
+    const uint16_t channelN = 1 << log2ChannelN;
+    const uint16_t decimation = channelN / 2;
+    const uint16_t tapsPerBranch = 16;
+    const uint16_t filterN = channelN * tapsPerBranch;
+
+    float f32TrigTable[channelN];
+    float f32Filter[F32Channelizer::filterSpaceSize(log2ChannelN, tapsPerBranch)];
+    float f32History[F32Channelizer::historySpaceSize(log2ChannelN, tapsPerBranch)];
+    cf32 f32Output[channelN];
+    F32Channelizer f32Channelizer(log2ChannelN, tapsPerBranch, f32TrigTable, 
+        f32Filter, f32History, f32Output);
+
+    q15 trigTable[channelN];
+    q15 filter[FixedChannelizer::filterSpaceSize(log2ChannelN, tapsPerBranch)];
+    q15 history[FixedChannelizer::historySpaceSize(log2ChannelN, tapsPerBranch)];
+    cq15 output[channelN];
+    FixedChannelizer channelizer(log2ChannelN, tapsPerBranch, trigTable, 
+        filter, history, output);
+
+    assert(channelizer.getDecimation() == decimation);
+
+    // Two tones in different channels plus a DC offset
+    const uint16_t samplesSize = 2048;
+    float samples[samplesSize];
+    for (uint16_t n = 0; n < samplesSize; n++) {
+        const float t = (float)n / sampleFreq;
+        samples[n] = 0.1 + 
+            0.4 * std::cos(2.0 * pi() * 2100.0 * t) +
+            0.2 * std::cos(2.0 * pi() * 1130.0 * t + 1.0);
+    }
+
+    float f32MaxError = 0;
+    float maxError = 0;
+    float mag[channelN / 2 + 1] = { 0 };
+    uint16_t outputCount = 0;
+
+    for (uint16_t n = 0; n < samplesSize; n++) {
+
+        const bool f32Ready = f32Channelizer.processSample(samples[n]);
+        const bool ready = channelizer.processSample(f32_to_q15(samples[n]));
+        assert(f32Ready == ready);
+        if (!ready) {
+            continue;
+        }
+
+        // Straight mix/filter/decimate for comparison.  The mixing phase 
+        // is referenced to the start of each decimation period, and the 
+        // 1/M is the scaling of the FFT.
+        const uint32_t mixN = (uint32_t)outputCount * decimation;
+        for (uint16_t k = 0; k <= channelN / 2; k++) {
+            double yr = 0, yi = 0;
+            for (uint16_t i = 0; i < filterN && i <= n; i++) {
+                const double a = -2.0 * pi() * (double)k * ((double)mixN - (double)i) / (double)channelN;
+                yr += f32Filter[i] * samples[n - i] * std::cos(a);
+                yi += f32Filter[i] * samples[n - i] * std::sin(a);
+            }
+            yr /= channelN;
+            yi /= channelN;
+            f32MaxError = std::max(f32MaxError, (float)std::abs(f32Output[k].r - yr));
+            f32MaxError = std::max(f32MaxError, (float)std::abs(f32Output[k].i - yi));
+            maxError = std::max(maxError, (float)std::abs(q15_to_f32(output[k].r) - yr));
+            maxError = std::max(maxError, (float)std::abs(q15_to_f32(output[k].i) - yi));
+            // Once the filter is full
+            if (n >= filterN) {
+                mag[k] = std::max(mag[k], output[k].mag_f32());
+            }
+        }
+        outputCount++;
+    }
+
+    cout << "Channelizer" << endl;
+    cout << "  Outputs         : " << outputCount << endl;
+    cout << "  Max Error (f32) : " << f32MaxError << endl;
+    cout << "  Max Error (q15) : " << maxError << endl;
+    for (uint16_t k = 0; k <= channelN / 2; k++) {
+        cout << "  Channel " << k << " mag : " << mag[k] << endl;
+    }
+
+    assert(outputCount == samplesSize / decimation);
+    assert(f32MaxError < 0.0001);
+    assert(maxError < 0.0005);
+    // A real tone of amplitude A comes out at A/2 in its own channel and
+    // is well down in the others.  DC isn't halved.
+    assert(std::abs(mag[0] - 0.1) < 0.005);
+    assert(std::abs(mag[1] - 0.1) < 0.005);
+    assert(std::abs(mag[2] - 0.2) < 0.005);
+    assert(mag[3] < 0.005);
+    assert(mag[4] < 0.005);
+}
+
+static uint64_t cycles() {
+#if defined(__x86_64__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+// Times one transform (including the copy of the input)
+template<class FFT, class C> static void time_fft(FFT& fft, const C* input, 
+    C* work, uint16_t n, unsigned int reps, float* ns, float* cyc) {
+    auto start = std::chrono::steady_clock::now();
+    uint64_t startCycles = cycles();
+    for (unsigned int r = 0; r < reps; r++) {
+        for (uint16_t i = 0; i < n; i++) {
+            work[i] = input[i];
+        }
+        fft.transform(work);
+    }
+    uint64_t endCycles = cycles();
+    auto end = std::chrono::steady_clock::now();
+    *ns = (float)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / (float)reps;
+    *cyc = (float)(endCycles - startCycles) / (float)reps;
+}
+
+// Tests related to the radix-4 FFT
+static void test_set_7() {
+
+    const uint16_t maxN = 4096;
+    static float f32TrigTable[maxN];
+    static q15 trigTable[maxN];
+    static cf32 f32Input[maxN], f32Radix2[maxN], f32Radix4[maxN];
+    static cq15 input[maxN], radix2[maxN], radix4[maxN];
+
+    cout << "Radix-4 FFT" << endl;
+    cout << "      N    r2 ns    r4 ns  r2 cyc  r4 cyc  f32 r2 ns  f32 r4 ns  f32 r2 cyc  f32 r4 cyc" << endl;
+
+    for (uint16_t log2N = 6; log2N <= 12; log2N++) {
+
+        const uint16_t fftN = 1 << log2N;
+        F32FFT f32fft(fftN, f32TrigTable);
+        FixedFFT fft(fftN, trigTable);
+
+        // Two tones, a DC offset, and some deterministic "noise"
+        for (uint16_t i = 0; i < fftN; i++) {
+            const float t = (float)i / (float)fftN;
+            const float x = 0.1 + 0.3 * std::cos(2.0 * pi() * 37.0 * t) +
+                0.2 * std::sin(2.0 * pi() * 5.5 * t) + 0.05 * std::sin((float)(i * i) * 0.37f);
+            const float y = 0.2 * std::sin(2.0 * pi() * 11.0 * t + 0.3);
+            f32Input[i] = cf32(x, y);
+            input[i].r = f32_to_q15(x);
+            input[i].i = f32_to_q15(y);
+            f32Radix2[i] = f32Input[i];
+            f32Radix4[i] = f32Input[i];
+            radix2[i] = input[i];
+            radix4[i] = input[i];
+        }
+
+        f32fft.transform(f32Radix2);
+        fft.transform(radix2);
+        f32fft.setRadix4Enabled(true);
+        fft.setRadix4Enabled(true);
+        f32fft.transform(f32Radix4);
+        fft.transform(radix4);
+
+        float f32MaxError = 0;
+        int maxError = 0;
+        for (uint16_t k = 0; k < fftN; k++) {
+            f32MaxError = std::max(f32MaxError, std::abs(f32Radix2[k].r - f32Radix4[k].r));
+            f32MaxError = std::max(f32MaxError, std::abs(f32Radix2[k].i - f32Radix4[k].i));
+            maxError = std::max(maxError, std::abs(radix2[k].r - radix4[k].r));
+            maxError = std::max(maxError, std::abs(radix2[k].i - radix4[k].i));
+        }
+        assert(f32MaxError < 0.000001);
+        // The truncation happens in different places so the q15 results 
+        // drift apart by up to about an LSB per stage
+        assert(maxError <= log2N);
+
+        // The real-input FFT uses the same kernel
+        for (uint16_t i = 0; i < fftN; i++) {
+            f32Radix4[i] = f32Input[i];
+            radix4[i] = input[i];
+        }
+        f32fft.transformReal(f32Radix4);
+        fft.transformReal(radix4);
+        f32fft.setRadix4Enabled(false);
+        fft.setRadix4Enabled(false);
+        f32fft.transformReal(f32Input);
+        fft.transformReal(input);
+        for (uint16_t k = 0; k <= fftN / 2; k++) {
+            assert(std::abs(f32Input[k].r - f32Radix4[k].r) < 0.000001);
+            assert(std::abs(f32Input[k].i - f32Radix4[k].i) < 0.000001);
+            assert(std::abs(input[k].r - radix4[k].r) <= log2N);
+            assert(std::abs(input[k].i - radix4[k].i) <= log2N);
+        }
+
+        // Timing
+        const unsigned int reps = (1 << 20) / fftN;
+        float ns2, ns4, cyc2, cyc4, f32ns2, f32ns4, f32cyc2, f32cyc4;
+        time_fft(fft, input, radix2, fftN, reps, &ns2, &cyc2);
+        fft.setRadix4Enabled(true);
+        time_fft(fft, input, radix4, fftN, reps, &ns4, &cyc4);
+        time_fft(f32fft, f32Input, f32Radix2, fftN, reps, &f32ns2, &f32cyc2);
+        f32fft.setRadix4Enabled(true);
+        time_fft(f32fft, f32Input, f32Radix4, fftN, reps, &f32ns4, &f32cyc4);
+
+        cout << "  " << fftN << " " << ns2 << " " << ns4 << " " << cyc2 << " " << cyc4 
+            << " " << f32ns2 << " " << f32ns4 << " " << f32cyc2 << " " << f32cyc4 
+            << "  (max error " << maxError << " LSB, " << f32MaxError << ")" << endl;
+    }
+}
+
+// Tests related to the FFT bit-reversal table
+static void test_set_8() {
+
+    const uint16_t maxN = 4096;
+    static float f32TrigTable[maxN];
+    static q15 trigTable[maxN];
+    static uint16_t bitReverseTable[FixedFFT::bitReverseSpaceSize(12)];
+    static cf32 f32Input[maxN], f32Calc[maxN], f32Table[maxN];
+    static cq15 input[maxN], calc[maxN], table[maxN];
+
+    cout << "Bit-Reversal Table" << endl;
+    cout << "      N  words  calc ns  table ns  f32 calc ns  f32 table ns" << endl;
+
+    for (uint16_t log2N = 6; log2N <= 12; log2N++) {
+
+        const uint16_t fftN = 1 << log2N;
+        F32FFT f32fft(fftN, f32TrigTable);
+        FixedFFT fft(fftN, trigTable);
+
+        for (uint16_t i = 0; i < fftN; i++) {
+            const float x = 0.4 * std::sin((float)(i * i) * 0.37f);
+            const float y = 0.4 * std::cos((float)(i * 3) * 0.11f);
+            f32Input[i] = cf32(x, y);
+            input[i].r = f32_to_q15(x);
+            input[i].i = f32_to_q15(y);
+            f32Calc[i] = f32Input[i];
+            f32Table[i] = f32Input[i];
+            calc[i] = input[i];
+            table[i] = input[i];
+        }
+
+        // The swaps are the same, so the results should be identical
+        f32fft.transform(f32Calc);
+        fft.transform(calc);
+        f32fft.setBitReverseTable(bitReverseTable);
+        fft.setBitReverseTable(bitReverseTable);
+        f32fft.transform(f32Table);
+        fft.transform(table);
+        for (uint16_t k = 0; k < fftN; k++) {
+            assert(f32Calc[k].r == f32Table[k].r && f32Calc[k].i == f32Table[k].i);
+            assert(calc[k].r == table[k].r && calc[k].i == table[k].i);
+        }
+
+        for (uint16_t i = 0; i < fftN; i++) {
+            calc[i] = input[i];
+            table[i] = input[i];
+        }
+        fft.transformReal(table);
+        fft.setBitReverseTable(0);
+        fft.transformReal(calc);
+        for (uint16_t k = 0; k <= fftN / 2; k++) {
+            assert(calc[k].r == table[k].r && calc[k].i == table[k].i);
+        }
+
+        // Timing
+        const unsigned int reps = (1 << 20) / fftN;
+        float ns0, ns1, f32ns0, f32ns1, cyc;
+        time_fft(fft, input, calc, fftN, reps, &ns0, &cyc);
+        fft.setBitReverseTable(bitReverseTable);
+        time_fft(fft, input, table, fftN, reps, &ns1, &cyc);
+        f32fft.setBitReverseTable(0);
+        time_fft(f32fft, f32Input, f32Calc, fftN, reps, &f32ns0, &cyc);
+        f32fft.setBitReverseTable(bitReverseTable);
+        time_fft(f32fft, f32Input, f32Table, fftN, reps, &f32ns1, &cyc);
+
+        cout << "  " << fftN << " " << FixedFFT::bitReverseSpaceSize(log2N) 
+            << " " << ns0 << " " << ns1 << " " << f32ns0 << " " << f32ns1 << endl;
+    }
+}
+
+// Differential tests for the vectorized q15 kernels.  Everything must 
+// match the scalar code exactly.
+static void test_set_9() {
+
+    const SIMDLevel detected = simd_detect_level();
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<int> full(-32768, 32767);
+    std::uniform_int_distribution<int> half(-16384, 16383);
+
+    SIMDLevel levels[2] = { detected, SIMDLevel::SSE2 };
+    const uint16_t levelCount = (detected == SIMDLevel::AVX2) ? 2 : 1;
+
+    cout << "SIMD (level " << (int)detected << ")" << endl;
+
+    // FFT.  The inputs are kept to half scale since the FFT overflows
+    // otherwise.
+    const uint16_t maxN = 4096;
+    static q15 trigTable[maxN];
+    static cq15 input[maxN], ref[maxN], vec[maxN];
+    for (uint16_t log2N = 2; log2N <= 12; log2N++) {
+        const uint16_t fftN = 1 << log2N;
+        FixedFFT fft(fftN, trigTable);
+        for (uint16_t trial = 0; trial < 4; trial++) {
+            for (uint16_t i = 0; i < fftN; i++) {
+                input[i].r = half(rng);
+                input[i].i = half(rng);
+                ref[i] = input[i];
+            }
+            simd_set_level(SIMDLevel::NONE);
+            fft.transform(ref);
+            for (uint16_t l = 0; l < levelCount; l++) {
+                assert(simd_set_level(levels[l]));
+                for (uint16_t i = 0; i < fftN; i++) {
+                    vec[i] = input[i];
+                }
+                fft.transform(vec);
+                for (uint16_t i = 0; i < fftN; i++) {
+                    assert(ref[i].r == vec[i].r && ref[i].i == vec[i].i);
+                }
+            }
+        }
+    }
+
+    // Peak search, including the extreme values, ties, and odd ranges
+    for (uint16_t trial = 0; trial < 2000; trial++) {
+        const uint16_t len = rng() % 300;
+        const uint16_t start = rng() % 300;
+        for (uint16_t i = 0; i < len; i++) {
+            switch (rng() % 4) {
+            case 0: 
+                input[i].r = full(rng);
+                input[i].i = full(rng);
+                break;
+            case 1:
+                input[i].r = -32768;
+                input[i].i = (rng() % 2) ? 32767 : -32768;
+                break;
+            case 2:
+                input[i].r = rng() % 8;
+                input[i].i = -(int)(rng() % 8);
+                break;
+            default:
+                input[i].r = 0;
+                input[i].i = 0;
+            }
+        }
+        simd_set_level(SIMDLevel::NONE);
+        const uint16_t r = max_idx_2(input, start, len);
+        for (uint16_t l = 0; l < levelCount; l++) {
+            simd_set_level(levels[l]);
+            assert(max_idx_2(input, start, len) == r);
+        }
+    }
+
+    // Symmetric FIR
+    q15 h[64] = { 0 }, x[128] = { 0 };
+    for (uint16_t trial = 0; trial < 2000; trial++) {
+        const uint16_t taps = 2 * (rng() % 60) + 1;
+        for (uint16_t i = 0; i <= taps / 2; i++) {
+            h[i] = full(rng);
+        }
+        for (uint16_t i = 0; i < taps; i++) {
+            x[i] = half(rng);
+        }
+        simd_set_level(SIMDLevel::NONE);
+        const q31 r = fir_sym_q15(h, x, taps);
+        for (uint16_t l = 0; l < levelCount; l++) {
+            simd_set_level(levels[l]);
+            assert(fir_sym_q15(h, x, taps) == r);
+        }
+    }
+
+    // Timing
+    cout << "      N  scalar ns  simd ns" << endl;
+    for (uint16_t log2N = 6; log2N <= 12; log2N++) {
+        const uint16_t fftN = 1 << log2N;
+        FixedFFT fft(fftN, trigTable);
+        const unsigned int reps = (1 << 20) / fftN;
+        float ns0, ns1, cyc;
+        simd_set_level(SIMDLevel::NONE);
+        time_fft(fft, input, ref, fftN, reps, &ns0, &cyc);
+        simd_set_level(detected);
+        time_fft(fft, input, vec, fftN, reps, &ns1, &cyc);
+        cout << "  " << fftN << " " << ns0 << " " << ns1 << endl;
+    }
+    {
+        const unsigned int reps = 20000;
+        unsigned int sum = 0;
+        float ns[2];
+        for (uint16_t l = 0; l < 2; l++) {
+            simd_set_level(l == 0 ? SIMDLevel::NONE : detected);
+            auto start = std::chrono::steady_clock::now();
+            for (unsigned int r = 0; r < reps; r++) {
+                sum += max_idx_2(input, 12, 256);
+            }
+            auto end = std::chrono::steady_clock::now();
+            ns[l] = (float)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / (float)reps;
+        }
+        cout << "  max_idx_2(256) " << ns[0] << " " << ns[1] << " " << (sum & 1) << endl;
+    }
+    {
+        const unsigned int reps = 200000;
+        q31 sum = 0;
+        float ns[2];
+        for (uint16_t l = 0; l < 2; l++) {
+            simd_set_level(l == 0 ? SIMDLevel::NONE : detected);
+            auto start = std::chrono::steady_clock::now();
+            for (unsigned int r = 0; r < reps; r++) {
+                sum += fir_sym_q15(h, x + (r & 7), 47);
+            }
+            auto end = std::chrono::steady_clock::now();
+            ns[l] = (float)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / (float)reps;
+        }
+        cout << "  fir_sym_q15(47) " << ns[0] << " " << ns[1] << " " << (sum & 1) << endl;
+    }
+
+    simd_set_level(detected);
+}
+
+// Tests related to the block-floating-point FFT
+static void test_set_10() {
+
+    const uint16_t log2N = 10;
+    const uint16_t fftN = 1 << log2N;
+    static float f32TrigTable[fftN];
+    static q15 trigTable[fftN];
+    static cf32 ref[fftN];
+    static cq15 normal[fftN], bfp[fftN], bfpReal[fftN / 2 + 1];
+    F32FFT f32fft(fftN, f32TrigTable);
+    FixedFFT fft(fftN, trigTable);
+
+    cout << "Block-Floating-Point FFT" << endl;
+
+    // From full scale down to a few LSBs
+    const float amps[] = { 0.45, 0.01, 0.001, 0.0002 };
+    for (float amp : amps) {
+
+        // A tone between bins plus a weaker tone 
+        for (uint16_t i = 0; i < fftN; i++) {
+            const float t = (float)i / (float)fftN;
+            const float x = amp * (0.8 * std::cos(2.0 * pi() * 100.3 * t) + 
+                0.2 * std::sin(2.0 * pi() * 211.0 * t));
+            const q15 q = f32_to_q15(x);
+            // The float reference uses the quantized samples
+            ref[i] = cf32(q15_to_f32(q), 0);
+            normal[i].r = q;
+            normal[i].i = 0;
+            bfp[i] = normal[i];
+        }
+        for (uint16_t i = 0; i < fftN / 2; i++) {
+            bfpReal[i].r = normal[2 * i].r;
+            bfpReal[i].i = normal[2 * i + 1].r;
+        }
+
+        f32fft.transform(ref);
+        fft.transform(normal);
+        const uint16_t s = fft.transformBFP(bfp);
+        const uint16_t sReal = fft.transformRealBFP(bfpReal);
+        const float scale = std::ldexp(1.0f, s - log2N);
+        const float scaleReal = std::ldexp(1.0f, sReal - log2N);
+
+        // The errors are relative to the largest bin
+        float peak = 0;
+        float normalError = 0, bfpError = 0, bfpRealError = 0;
+        int16_t maxComponent = 0;
+        for (uint16_t k = 0; k < fftN; k++) {
+            peak = std::max(peak, std::abs(ref[k].r));
+            normalError = std::max(normalError, std::abs(q15_to_f32(normal[k].r) - ref[k].r));
+            normalError = std::max(normalError, std::abs(q15_to_f32(normal[k].i) - ref[k].i));
+            bfpError = std::max(bfpError, std::abs(q15_to_f32(bfp[k].r) * scale - ref[k].r));
+            bfpError = std::max(bfpError, std::abs(q15_to_f32(bfp[k].i) * scale - ref[k].i));
+            maxComponent = std::max(maxComponent, (int16_t)std::max(std::abs(bfp[k].r), std::abs(bfp[k].i)));
+            if (k <= fftN / 2) {
+                bfpRealError = std::max(bfpRealError, std::abs(q15_to_f32(bfpReal[k].r) * scaleReal - ref[k].r));
+                bfpRealError = std::max(bfpRealError, std::abs(q15_to_f32(bfpReal[k].i) * scaleReal - ref[k].i));
+            }
+        }
+        normalError /= peak;
+        bfpError /= peak;
+        bfpRealError /= peak;
+
+        cout << "  Amplitude " << amp << " : exponent " << s << "/" << sReal
+            << ", relative error " << normalError << " (normal) " << bfpError 
+            << " (BFP) " << bfpRealError << " (BFP real)" << endl;
+
+        // One bit of headroom
+        assert(maxComponent < 0x4000);
+        // Full scale uses all of the stages, so there is little to gain.
+        // Otherwise the BFP result is far better.  At the lowest amplitude
+        // the twiddle precision is the limit.
+        assert(bfpError < 0.02);
+        assert(bfpRealError < 0.02);
+        if (amp < 0.1) {
+            assert(s < log2N);
+            assert(bfpError < normalError / 4);
+        }
+    }
+}
+
+// Shared (read-only) tables
+static void test_set_11() {
+
+    const uint16_t log2N = 9;
+    const uint16_t fftN = 1 << log2N;
+
+    // One copy per size
+    assert(SharedTables<log2N>::fixedTrigTable() == SharedTables<log2N>::fixedTrigTable());
+    assert(SharedTables<log2N>::f32TrigTable() == SharedTables<log2N>::f32TrigTable());
+    assert(SharedTables<log2N>::hannWindow() == SharedTables<log2N>::hannWindow());
+    assert(SharedTables<log2N>::fixedTrigTable() != SharedTables<log2N + 1>::fixedTrigTable());
+
+    // Same contents as the tables that the instances build themselves
+    static q15 trigTable[fftN];
+    static float f32TrigTable[fftN];
+    static q15 window[fftN];
+    FixedFFT ownFFT(fftN, trigTable);
+    F32FFT ownF32FFT(fftN, f32TrigTable);
+    make_hann_window_q15(window, fftN);
+    for (uint16_t i = 0; i < fftN; i++) {
+        assert(trigTable[i] == SharedTables<log2N>::fixedTrigTable()[i]);
+        assert(f32TrigTable[i] == SharedTables<log2N>::f32TrigTable()[i]);
+        assert(window[i] == SharedTables<log2N>::hannWindow()[i]);
+    }
+
+    // Two instances sharing the table give the same result as one with
+    // its own table
+    FixedFFT sharedFFT0(fftN, SharedTables<log2N>::fixedTrigTable());
+    FixedFFT sharedFFT1(fftN, SharedTables<log2N>::fixedTrigTable());
+    static cq15 a[fftN], b[fftN], c[fftN];
+    for (uint16_t i = 0; i < fftN; i++) {
+        a[i].r = f32_to_q15(0.5 * std::cos(2.0 * pi() * 17.0 * i / fftN));
+        a[i].i = 0;
+        b[i] = a[i];
+        c[i] = a[i];
+    }
+    ownFFT.transform(a);
+    sharedFFT0.transform(b);
+    sharedFFT1.transform(c);
+    for (uint16_t i = 0; i < fftN; i++) {
+        assert(a[i].r == b[i].r && a[i].i == b[i].i);
+        assert(a[i].r == c[i].r && a[i].i == c[i].i);
+    }
+}
+
+// Band-limited DFT
+static void test_set_12() {
+
+    const uint16_t log2N = 9;
+    const uint16_t fftN = 1 << log2N;
+    FixedFFT fft(fftN, SharedTables<log2N>::fixedTrigTable());
+    F32FFT f32fft(fftN, SharedTables<log2N>::f32TrigTable());
+
+    // A few tones and some noise
+    std::mt19937 gen(19);
+    std::uniform_real_distribution<float> noise(-0.01, 0.01);
+    static float x[fftN];
+    for (uint16_t n = 0; n < fftN; n++) {
+        x[n] = 0.3 * std::cos(2.0 * pi() * 160.3 * n / fftN) + 
+            0.1 * std::sin(2.0 * pi() * 171.0 * n / fftN) + noise(gen);
+    }
+    static cf32 ref[fftN];
+    static cq15 packed[fftN / 2 + 1], full[fftN / 2 + 1], band[fftN / 2 + 1];
+    // The reference uses the same (quantized) input
+    for (uint16_t n = 0; n < fftN; n++) {
+        ref[n].r = q15_to_f32(f32_to_q15(x[n]));
+        ref[n].i = 0;
+    }
+    f32fft.transform(ref);
+    for (uint16_t n = 0; n < fftN / 2; n++) {
+        packed[n].r = f32_to_q15(x[2 * n]);
+        packed[n].i = f32_to_q15(x[2 * n + 1]);
+    }
+    for (uint16_t n = 0; n < fftN / 2; n++) {
+        full[n] = packed[n];
+    }
+    fft.transformReal(full);
+
+    BandDFT bandDFT(fft);
+    assert(!bandDFT.isDirect());
+    assert(BandDFT::defaultDirectBinLimit(log2N) == 8);
+
+    // Every bin (including DC and N/2) evaluated directly
+    for (uint16_t first = 0; first <= fftN / 2; first += 8) {
+        const uint16_t last = std::min(first + 7, fftN / 2);
+        bandDFT.setDirectBinLimit(8);
+        bandDFT.setBand(first, last);
+        assert(bandDFT.isDirect());
+        for (uint16_t n = 0; n < fftN / 2; n++) {
+            band[n] = packed[n];
+        }
+        bandDFT.transformReal(band);
+        for (uint16_t k = first; k <= last; k++) {
+            const float bandError = std::max(
+                std::abs(q15_to_f32(band[k].r) - ref[k].r),
+                std::abs(q15_to_f32(band[k].i) - ref[k].i));
+            const float fullError = std::max(
+                std::abs(q15_to_f32(full[k].r) - ref[k].r),
+                std::abs(q15_to_f32(full[k].i) - ref[k].i));
+            // Only one rounding, so this is at least as good as the FFT
+            assert(bandError <= 1.0 / 32768.0);
+            assert(bandError <= fullError + 1.0 / 32768.0);
+        }
+    }
+
+    // The crossover
+    bandDFT.setDirectBinLimit(BandDFT::defaultDirectBinLimit(log2N));
+    bandDFT.setBand(160, 167);
+    assert(bandDFT.isDirect());
+    bandDFT.setBand(160, 168);
+    assert(!bandDFT.isDirect());
+    bandDFT.setDirectBinLimit(0);
+    bandDFT.setBand(160, 160);
+    assert(!bandDFT.isDirect());
+    bandDFT.setDirectBinLimit(1000);
+    bandDFT.setBand(0, BandDFT::MAX_DIRECT_BINS);
+    assert(!bandDFT.isDirect());
+
+    // Several bands (i.e. DC plus a mark and space)
+    bandDFT.setDirectBinLimit(BandDFT::defaultDirectBinLimit(log2N));
+    bandDFT.setBand(0, 0);
+    assert(bandDFT.addBand(159, 161));
+    assert(bandDFT.addBand(170, 172));
+    assert(!bandDFT.addBand(180, 180));
+    assert(bandDFT.isDirect());
+    for (uint16_t n = 0; n < fftN / 2; n++) {
+        band[n] = packed[n];
+    }
+    bandDFT.transformReal(band);
+    const uint16_t bins[] = { 0, 159, 160, 161, 170, 171, 172 };
+    for (uint16_t k : bins) {
+        assert(std::abs(band[k].r - full[k].r) <= 4);
+        assert(std::abs(band[k].i - full[k].i) <= 4);
+    }
+
+    // Block floating point gives the same exponent as the FFT.  The 
+    // strongest bin is at the FFT scale.
+    static cq15 fullBFP[fftN / 2 + 1];
+    for (uint16_t n = 0; n < fftN / 2; n++) {
+        band[n] = packed[n];
+        fullBFP[n] = packed[n];
+    }
+    bandDFT.setBand(159, 161);
+    const uint16_t s = bandDFT.transformRealBFP(band);
+    const uint16_t sFull = fft.transformRealBFP(fullBFP);
+    assert(s <= sFull);
+    for (uint16_t k = 159; k <= 161; k++) {
+        assert(std::abs(band[k].r) < 0x4000 && std::abs(band[k].i) < 0x4000);
+        const float scale = (float)(1 << s) / (float)fftN;
+        assert(std::abs(q15_to_f32(band[k].r) * scale - ref[k].r) <= 1.0 / 32768.0);
+        assert(std::abs(q15_to_f32(band[k].i) * scale - ref[k].i) <= 1.0 / 32768.0);
+    }
+    // A weak signal gets a small exponent
+    static cq15 weak[fftN / 2 + 1];
+    for (uint16_t n = 0; n < fftN / 2; n++) {
+        weak[n].r = packed[n].r >> 6;
+        weak[n].i = packed[n].i >> 6;
+    }
+    assert(bandDFT.transformRealBFP(weak) < s);
+
+    // Timing (direct evaluation vs. the full real FFT)
+    const unsigned int reps = 2000;
+    for (uint16_t bins = 1; bins <= BandDFT::MAX_DIRECT_BINS; bins *= 2) {
+        float ns[2], cyc[2];
+        for (uint16_t direct = 0; direct < 2; direct++) {
+            bandDFT.setDirectBinLimit(direct ? bins : 0);
+            bandDFT.setBand(160, 160 + bins - 1);
+            auto start = std::chrono::steady_clock::now();
+            uint64_t startCycles = cycles();
+            for (unsigned int r = 0; r < reps; r++) {
+                for (uint16_t n = 0; n < fftN / 2; n++) {
+                    band[n] = packed[n];
+                }
+                bandDFT.transformReal(band);
+            }
+            uint64_t endCycles = cycles();
+            auto end = std::chrono::steady_clock::now();
+            ns[direct] = (float)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / (float)reps;
+            cyc[direct] = (float)(endCycles - startCycles) / (float)reps;
+        }
+        cout << "  N=" << fftN << " bins=" << bins << " : FFT " << ns[0] << " ns (" 
+            << cyc[0] << " cycles), direct " << ns[1] << " ns (" << cyc[1] << " cycles)" << endl;
+    }
+}
+
+// q31 FFT
+static void test_set_13() {
+
+    const uint16_t log2N = 10;
+    const uint16_t fftN = 1 << log2N;
+    FixedFFT fft(fftN, SharedTables<log2N>::fixedTrigTable());
+    F32FFT f32fft(fftN, SharedTables<log2N>::f32TrigTable());
+    FixedFFT31 fft31(fftN, SharedTables<log2N>::fixed31TrigTable());
+    // Sharing the q15 table
+    FixedFFT31 fft31q15(fftN, SharedTables<log2N>::fixedTrigTable());
+
+    static cf32 ref[fftN];
+    static cq15 x15[fftN];
+    static cq31 x31[fftN], x31q15[fftN], real31[fftN / 2 + 1];
+
+    const float amps[] = { 0.45, 0.01, 0.0002 };
+    for (float amp : amps) {
+        for (uint16_t n = 0; n < fftN; n++) {
+            ref[n].r = amp * std::cos(2.0 * pi() * 100.3 * n / fftN);
+            ref[n].i = amp * std::sin(2.0 * pi() * 37.0 * n / fftN);
+            x15[n].r = f32_to_q15(ref[n].r);
+            x15[n].i = f32_to_q15(ref[n].i);
+            x31[n].r = f32_to_q31(ref[n].r);
+            x31[n].i = f32_to_q31(ref[n].i);
+            x31q15[n] = x31[n];
+        }
+        // The packed real part
+        for (uint16_t n = 0; n < fftN / 2; n++) {
+            real31[n].r = x31[2 * n].r;
+            real31[n].i = x31[2 * n + 1].r;
+        }
+        static cf32 refReal[fftN];
+        for (uint16_t n = 0; n < fftN; n++) {
+            refReal[n].r = ref[n].r;
+            refReal[n].i = 0;
+        }
+        f32fft.transform(ref);
+        f32fft.transform(refReal);
+        fft.transform(x15);
+        fft31.transform(x31);
+        fft31q15.transform(x31q15);
+        fft31.transformReal(real31);
+
+        // Errors relative to the peak
+        float peak = 0, error15 = 0, error31 = 0, error31q15 = 0, errorReal = 0;
+        for (uint16_t k = 0; k < fftN; k++) {
+            peak = std::max(peak, std::sqrt(ref[k].r * ref[k].r + ref[k].i * ref[k].i));
+            error15 = std::max(error15, std::abs(q15_to_f32(x15[k].r) - ref[k].r));
+            error31 = std::max(error31, std::abs(q31_to_f32(x31[k].r) - ref[k].r));
+            error31 = std::max(error31, std::abs(q31_to_f32(x31[k].i) - ref[k].i));
+            error31q15 = std::max(error31q15, std::abs(q31_to_f32(x31q15[k].r) - ref[k].r));
+            if (k <= fftN / 2) {
+                errorReal = std::max(errorReal, std::abs(q31_to_f32(real31[k].r) - refReal[k].r));
+                errorReal = std::max(errorReal, std::abs(q31_to_f32(real31[k].i) - refReal[k].i));
+            }
+        }
+        error15 /= peak;
+        error31 /= peak;
+        error31q15 /= peak;
+        errorReal /= peak;
+        cout << "  Amplitude " << amp << " : relative error " << error15 << " (q15) " 
+            << error31 << " (q31) " << error31q15 << " (q31, q15 twiddles) " 
+            << errorReal << " (q31 real)" << endl;
+        assert(error31 < 0.001);
+        assert(errorReal < 0.001);
+        assert(error31 < error15 / 10);
+        assert(error31q15 < 0.01);
+    }
+
+    // Timing
+    const unsigned int reps = 1000;
+    float ns15, cyc15, ns31, cyc31;
+    static cq15 work15[fftN];
+    static cq31 work31[fftN];
+    time_fft(fft, x15, work15, fftN, reps, &ns15, &cyc15);
+    time_fft(fft31, x31, work31, fftN, reps, &ns31, &cyc31);
+    cout << "  N=" << fftN << " : q15 " << ns15 << " ns (" << cyc15 << " cycles), q31 "
+        << ns31 << " ns (" << cyc31 << " cycles)" << endl;
+}
+
+// Tests related to the streaming FIR filter
+static void test_set_14() {
+
+    const SIMDLevel detected = simd_detect_level();
+    std::mt19937 rng(3);
+    std::uniform_int_distribution<int> full(-32768, 32767);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+    const uint16_t maxTaps = 63;
+    const unsigned int streamN = 1000;
+    static q15 x15[streamN], y15[streamN];
+    static f32 x32[streamN], y32[streamN], ref32[streamN];
+    q15 h15[maxTaps];
+    f32 h32[maxTaps];
+    q15 history15[FirFilter<q15>::historySpaceSize(maxTaps)];
+    f32 history32[FirFilter<f32>::historySpaceSize(maxTaps)];
+
+    for (uint16_t trial = 0; trial < 40; trial++) {
+
+        const bool symmetric = (trial % 2) == 0;
+        const uint16_t taps = 2 * (rng() % (maxTaps / 2)) + 1;
+
+        // Scale the coefficients so that sum(|h|) < 1 and the q15 
+        // accumulator can't overflow.
+        for (uint16_t i = 0; i < taps; i++) {
+            h32[i] = unit(rng);
+            if (symmetric && i > taps / 2) {
+                h32[i] = h32[taps - 1 - i];
+            }
+        }
+        float total = 0;
+        for (uint16_t i = 0; i < taps; i++) 
+            total += std::abs(h32[i]);
+        for (uint16_t i = 0; i < taps; i++) {
+            h32[i] *= 0.99f / total;
+            h15[i] = f32_to_q15(h32[i]);
+        }
+        for (unsigned int i = 0; i < streamN; i++) {
+            x15[i] = full(rng);
+            x32[i] = unit(rng);
+        }
+
+        // The q15 filter must match the direct convolution exactly, no 
+        // matter how the stream is split up.
+        FirFilter<q15> filter15(h15, taps, symmetric, history15);
+        for (uint16_t l = 0; l < 2; l++) {
+            simd_set_level(l == 0 ? SIMDLevel::NONE : detected);
+            filter15.reset();
+            unsigned int i = 0;
+            while (i < streamN) {
+                const unsigned int n = std::min(streamN - i, (unsigned int)(rng() % 70));
+                if (n == 1) {
+                    y15[i] = filter15.process(x15[i]);
+                } else {
+                    filter15.process(x15 + i, y15 + i, n);
+                }
+                i += n;
+            }
+            for (unsigned int n = 0; n < streamN; n++) {
+                q31 acc = 0;
+                for (unsigned int k = 0; k < taps && k <= n; k++) {
+                    acc += (q31)h15[k] * (q31)x15[n - k];
+                }
+                assert(y15[n] == (q15)((acc + (1 << 14)) >> 15));
+            }
+        }
+
+        // The f32 filter is the same as convolve_f32 (within rounding for 
+        // the symmetric version)
+        convolve_f32(ref32, x32, streamN, h32, taps);
+        FirFilter<f32> filter32(h32, taps, symmetric, history32);
+        unsigned int i = 0;
+        while (i < streamN) {
+            const unsigned int n = std::min(streamN - i, (unsigned int)(rng() % 70));
+            filter32.process(x32 + i, y32 + i, n);
+            i += n;
+        }
+        for (unsigned int n = 0; n < streamN; n++) {
+            assert(std::abs(y32[n] - ref32[n]) < 1e-5);
+        }
+    }
+    simd_set_level(detected);
+
+    // Timing for the correlation LPF size
+    const uint16_t taps = 47;
+    const unsigned int reps = 200;
+    float ns[3];
+    q31 sum = 0;
+    {
+        FirFilter<q15> filter15(h15, taps, true, history15);
+        for (uint16_t l = 0; l < 2; l++) {
+            simd_set_level(l == 0 ? SIMDLevel::NONE : detected);
+            auto start = std::chrono::steady_clock::now();
+            for (unsigned int r = 0; r < reps; r++) {
+                filter15.process(x15, y15, streamN);
+                sum += y15[r];
+            }
+            auto end = std::chrono::steady_clock::now();
+            ns[l] = (float)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / (float)(reps * streamN);
+        }
+        simd_set_level(detected);
+    }
+    {
+        FirFilter<f32> filter32(h32, taps, true, history32);
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned int r = 0; r < reps; r++) {
+            filter32.process(x32, y32, streamN);
+            sum += (y32[r] > 0);
+        }
+        auto end = std::chrono::steady_clock::now();
+        ns[2] = (float)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / (float)(reps * streamN);
+    }
+    cout << "FirFilter(47) ns/sample : q15 scalar " << ns[0] << ", q15 simd " << ns[1] 
+        << ", f32 " << ns[2] << " " << (sum & 1) << endl;
+}
+
+/**
+ * @returns The amplitude of a tone in a real signal.
+ */
+static float tone_amplitude(const float* x, unsigned int n, float sampleFreq, float freq) {
+    double r = 0, i = 0;
+    for (unsigned int k = 0; k < n; k++) {
+        const double phi = 2.0 * pi() * freq * (double)k / sampleFreq;
+        r += x[k] * std::cos(phi);
+        i += x[k] * std::sin(phi);
+    }
+    return (float)(2.0 * std::sqrt(r * r + i * i) / (double)n);
+}
+
+// Tests related to the polyphase resamplers
+static void test_set_15() {
+
+    std::mt19937 rng(4);
+    std::uniform_real_distribution<float> unit(-0.5f, 0.5f);
+    const uint16_t tapsPerBranch = 16;
+    const unsigned int inN = 2400;
+
+    // Compare against zero-stuffing, filtering at the high rate and 
+    // decimating, across a few factors and random block sizes.
+    const uint16_t factors[][2] = { { 1, 24 }, { 24, 1 }, { 3, 2 }, { 2, 3 }, { 20, 441 } };
+    for (auto f : factors) {
+        const uint16_t up = f[0], down = f[1];
+        const uint16_t filterN = F32Resampler::filterSpaceSize(up, down, tapsPerBranch);
+        const uint16_t phaseTaps = FixedResampler::phaseTaps(up, down, tapsPerBranch);
+        static float filter[8192], history[1024];
+        static q15 filterQ15[8192], historyQ15[1024];
+        assert(filterN <= 8192);
+        F32Resampler r32(up, down, tapsPerBranch, filter, history);
+        FixedResampler r15(up, down, tapsPerBranch, filterQ15, historyQ15);
+
+        static float x[inN], y[2 * 24 * inN];
+        static q15 x15[inN], y15[2 * 24 * inN];
+        for (unsigned int i = 0; i < inN; i++) {
+            x[i] = unit(rng);
+            x15[i] = f32_to_q15(x[i]);
+        }
+        unsigned int outN = 0, outN15 = 0, i = 0;
+        while (i < inN) {
+            const unsigned int n = std::min(inN - i, (unsigned int)(rng() % 100));
+            const unsigned int a = r32.process(x + i, n, y + outN);
+            const unsigned int b = r15.process(x15 + i, n, y15 + outN15);
+            assert(a <= F32Resampler::maxOutputs(up, down, n));
+            assert(a == b);
+            outN += a;
+            outN15 += b;
+            i += n;
+        }
+        assert(outN == F32Resampler::maxOutputs(up, down, inN));
+
+        float maxError = 0, maxError15 = 0;
+        for (unsigned int n = 0; n < outN; n++) {
+            // Output n is at n * M in the zero-stuffed stream
+            const unsigned int t = n * down;
+            double acc = 0;
+            for (unsigned int k = 0; k < up * phaseTaps && k <= t; k++) {
+                if ((t - k) % up == 0) {
+                    acc += filter[(k % up) * phaseTaps + k / up] * x[(t - k) / up];
+                }
+            }
+            maxError = std::max(maxError, (float)std::abs(y[n] - acc));
+            maxError15 = std::max(maxError15, (float)std::abs(q15_to_f32(y15[n]) - acc));
+        }
+        cout << "  Resample " << up << "/" << down << " : " << outN 
+            << " outputs, max error " << maxError << " (f32) " << maxError15 << " (q15)" << endl;
+        assert(maxError < 1e-5);
+        assert(maxError15 < 0.005);
+    }
+
+    // 48k to 2k: a tone in the passband comes through, one that would 
+    // alias is rejected.
+    {
+        const unsigned int inN = 48000;
+        static float filter[F32Resampler::filterSpaceSize(1, 24, tapsPerBranch)];
+        static float history[F32Resampler::historySpaceSize(1, 24, tapsPerBranch)];
+        static float x[inN], y[inN / 24];
+        for (float freq : { 600.0f, 1500.0f }) {
+            F32Resampler dec(1, 24, tapsPerBranch, filter, history);
+            // The tone is long, so it is built in double precision
+            for (unsigned int i = 0; i < inN; i++) 
+                x[i] = (float)(0.5 * std::cos(2.0 * pi() * freq * (double)i / 48000.0));
+            const unsigned int outN = dec.process(x, inN, y);
+            assert(outN == inN / 24);
+            // Skip the start-up
+            const float amp = tone_amplitude(y + 100, outN - 100, 2000, 
+                freq < 1000 ? freq : 2000 - freq);
+            cout << "  48k -> 2k, " << freq << " Hz : " << 20.0f * std::log10(amp / 0.5f) << " dB" << endl;
+            if (freq < 1000) {
+                assert(std::abs(amp - 0.5f) < 0.01f);
+            } else {
+                assert(amp < 0.5f * 0.003f);
+            }
+        }
+    }
+
+    // 2k to 48k: the tone comes through and the image is rejected
+    {
+        const unsigned int inN = 2000;
+        static float filter[F32Resampler::filterSpaceSize(24, 1, tapsPerBranch)];
+        static float history[F32Resampler::historySpaceSize(24, 1, tapsPerBranch)];
+        static float x[inN], y[inN * 24];
+        F32Resampler interp(24, 1, tapsPerBranch, filter, history);
+        make_real_tone_f32(x, inN, 2000, 400, 0.5);
+        const unsigned int outN = interp.process(x, inN, y);
+        assert(outN == inN * 24);
+        const float amp = tone_amplitude(y + 2400, outN - 2400, 48000, 400);
+        const float image = tone_amplitude(y + 2400, outN - 2400, 48000, 1600);
+        cout << "  2k -> 48k, 400 Hz : " << 20.0f * std::log10(amp / 0.5f) 
+            << " dB, image " << 20.0f * std::log10(image / 0.5f) << " dB" << endl;
+        assert(std::abs(amp - 0.5f) < 0.01f);
+        assert(image < 0.5f * 0.003f);
+    }
+
+    // Throughput at 48k -> 2k on one core
+    {
+        const unsigned int inN = 48000;
+        static q15 filterQ15[FixedResampler::filterSpaceSize(1, 24, tapsPerBranch)];
+        static q15 historyQ15[FixedResampler::historySpaceSize(1, 24, tapsPerBranch)];
+        static float filter[F32Resampler::filterSpaceSize(1, 24, tapsPerBranch)];
+        static float history[F32Resampler::historySpaceSize(1, 24, tapsPerBranch)];
+        static q15 x15[inN], y15[inN / 24];
+        static float x[inN], y[inN / 24];
+        make_real_tone_f32(x, inN, 48000, 600, 0.5);
+        for (unsigned int i = 0; i < inN; i++) 
+            x15[i] = f32_to_q15(x[i]);
+        FixedResampler dec15(1, 24, tapsPerBranch, filterQ15, historyQ15);
+        F32Resampler dec32(1, 24, tapsPerBranch, filter, history);
+
+        const unsigned int reps = 10;
+        unsigned int sum = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned int r = 0; r < reps; r++) 
+            sum += dec15.process(x15, inN, y15);
+        auto end = std::chrono::steady_clock::now();
+        const float ns15 = (float)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / (float)(reps * inN);
+        start = std::chrono::steady_clock::now();
+        for (unsigned int r = 0; r < reps; r++) 
+            sum += dec32.process(x, inN, y);
+        end = std::chrono::steady_clock::now();
+        const float ns32 = (float)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / (float)(reps * inN);
+        // One second of input is 48000 samples
+        cout << "  48k -> 2k (" << FixedResampler::phaseTaps(1, 24, tapsPerBranch) 
+            << " taps) ns/input sample : q15 " << ns15 << " (" << (1.0e9f / (ns15 * 48000.0f)) 
+            << "x real time), f32 " << ns32 << " (" << (1.0e9f / (ns32 * 48000.0f)) 
+            << "x real time) " << (sum & 1) << endl;
+    }
+}
+
+// Tests related to the CIC decimator
+static void test_set_16() {
+
+    // 96 kHz -> 4 kHz (CIC) -> 2 kHz (FIR)
+    const uint16_t order = 4, r = 24, d = 2, taps = 63;
+    const unsigned int inN = 96000;
+    static q15 fir[taps], history[CICDecimator::historySpaceSize(taps)];
+    static q15 x[inN], y[inN / (r * d)];
+    CICDecimator dec(order, r, d, taps, fir, history);
+    cout << "CIC decimator (input shift " << dec.getInputShift() << ")" << endl;
+
+    // Compare against a direct model (N box filters, decimate, FIR, 
+    // decimate) across random block splits.  This must be exact.
+    {
+        std::mt19937 rng(5);
+        std::uniform_int_distribution<int> full(-32768, 32767);
+        const unsigned int testN = 9600;
+        for (unsigned int i = 0; i < testN; i++) 
+            x[i] = full(rng);
+        unsigned int outN = 0, i = 0;
+        while (i < testN) {
+            const unsigned int n = std::min(testN - i, (unsigned int)(rng() % 200));
+            outN += dec.process(x + i, n, y + outN);
+            i += n;
+        }
+        assert(outN == CICDecimator::maxOutputs(r, d, testN));
+
+        static int64_t box[2][testN];
+        for (unsigned int k = 0; k < testN; k++) 
+            box[0][k] = (int64_t)x[k] >> dec.getInputShift();
+        for (uint16_t s = 0; s < order; s++) {
+            const int64_t* a = box[s % 2];
+            int64_t* b = box[(s + 1) % 2];
+            for (unsigned int k = 0; k < testN; k++) {
+                b[k] = 0;
+                for (unsigned int j = 0; j < r && j <= k; j++) 
+                    b[k] += a[k - j];
+            }
+        }
+        const int64_t* cic = box[order % 2];
+        // The CIC output is scaled back to q15 by the growth in bits
+        const uint16_t shift = (uint16_t)std::ceil(order * std::log2((double)r) - 1e-9) - dec.getInputShift();
+        static q15 cic15[testN / r];
+        for (unsigned int m = 0; m < testN / r; m++) {
+            const int64_t v = (cic[m * r + r - 1] + (1 << (shift - 1))) >> shift;
+            cic15[m] = (q15)std::max((int64_t)-32768, std::min((int64_t)32767, v));
+        }
+        for (unsigned int n = 0; n < outN; n++) {
+            const unsigned int m = n * d + d - 1;
+            int64_t acc = 0;
+            for (unsigned int j = 0; j < taps && j <= m; j++) 
+                acc += (int64_t)fir[j] * (int64_t)cic15[m - j];
+            acc = (acc + (1 << 13)) >> 14;
+            assert(y[n] == (q15)std::max((int64_t)-32768, std::min((int64_t)32767, acc)));
+        }
+    }
+
+    // Passband flatness (with the droop that the CIC alone would have)
+    // and the rejection of tones that alias onto 600 Hz.
+    for (float freq : { 100.0f, 200.0f, 300.0f, 400.0f, 500.0f, 600.0f, 700.0f, 
+        1400.0f, 2600.0f, 3400.0f, 4600.0f, 5400.0f }) {
+        for (unsigned int i = 0; i < inN; i++) 
+            x[i] = f32_to_q15((float)(0.5 * std::cos(2.0 * pi() * freq * (double)i / 96000.0)));
+        dec.reset();
+        const unsigned int outN = dec.process(x, inN, y);
+        static float yf[inN / (r * d)];
+        for (unsigned int n = 0; n < outN; n++) 
+            yf[n] = q15_to_f32(y[n]);
+        // Where the tone ends up at 2 kHz
+        const float alias = std::abs(freq - 2000.0f * std::round(freq / 2000.0f));
+        // Skip the start-up
+        const float db = 20.0f * std::log10(tone_amplitude(yf + 100, outN - 100, 2000, alias) / 0.5f);
+        if (freq < 1000) {
+            const float droop = 20.0f * std::log10(CICDecimator::cicResponse(order, r, freq / 4000.0f));
+            cout << "  " << freq << " Hz : " << db << " dB (CIC alone " << droop << " dB)" << endl;
+            assert(std::abs(db) < 0.1f);
+        } else {
+            cout << "  " << freq << " Hz -> " << alias << " Hz : " << db << " dB" << endl;
+            assert(db < -50.0f);
+        }
+    }
+
+    // Speed
+    {
+        const unsigned int reps = 20;
+        unsigned int sum = 0;
+        auto start = std::chrono::steady_clock::now();
+        const uint64_t startCycles = cycles();
+        for (unsigned int r = 0; r < reps; r++) 
+            sum += dec.process(x, inN, y);
+        const uint64_t endCycles = cycles();
+        auto end = std::chrono::steady_clock::now();
+        const float ns = (float)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / (float)(reps * inN);
+        const float cyc = (float)(endCycles - startCycles) / (float)(reps * inN);
+        cout << "  96k -> 2k per input sample : " << ns << " ns, " << cyc << " cycles " << (sum & 1) << endl;
+    }
+}
+
+// Tests related to the NCO
+static void test_set_17() {
+
+    cout << "NCO" << endl;
+
+    // Accuracy across random phases
+    {
+        std::mt19937 rng(6);
+        float maxError = 0, maxErrorNoInterp = 0, maxErrorQ15 = 0;
+        for (unsigned int k = 0; k < 100000; k++) {
+            const uint32_t phase = rng();
+            const double ref = std::sin(2.0 * 3.14159265358979323846 * (double)phase / 4294967296.0);
+            maxError = std::max(maxError, (float)std::abs(NCO::sinF32(phase) - ref));
+            maxErrorNoInterp = std::max(maxErrorNoInterp, (float)std::abs(NCO::sinF32(phase, false) - ref));
+            maxErrorQ15 = std::max(maxErrorQ15, (float)std::abs(q15_to_f32(NCO::sinQ15(phase)) - ref));
+        }
+        cout << "  Max error " << maxError << " (f32) " << maxErrorNoInterp 
+            << " (f32, no interpolation) " << maxErrorQ15 << " (q15)" << endl;
+        assert(maxError < 1e-6);
+        assert(maxErrorNoInterp < 2e-3);
+        assert(maxErrorQ15 < 2.0f / 32768.0f);
+        // The quadrant edges
+        assert(NCO::sinF32(0) == 0);
+        assert(NCO::sinF32(0x40000000) == 1.0f);
+        assert(NCO::sinF32(0x80000000) == 0);
+        assert(NCO::sinF32(0xc0000000) == -1.0f);
+        assert(NCO::sinQ15(0x40000000) == 32767);
+        assert(NCO::sinQ15(0xc0000000) == -32767);
+    }
+
+    // A long transmission stays on the ideal tone.  The float phase 
+    // accumulator that this replaced is shown for comparison.
+    {
+        const float sampleFreq = 2000, freq = 667;
+        const unsigned int n = 10000000;
+        NCO nco(sampleFreq, freq);
+        float phi = 0, y = 0, yOld = 0;
+        const float omega = 2.0f * pi() * freq / sampleFreq;
+        for (unsigned int k = 0; k < n; k++) {
+            y = nco.nextF32();
+            yOld = std::cos(phi);
+            phi += omega;
+        }
+        const double ref = std::cos(2.0 * 3.14159265358979323846 * (double)freq * (double)(n - 1) / (double)sampleFreq);
+        cout << "  After " << n << " samples: error " << std::abs(y - ref) 
+            << " (float phase " << std::abs(yOld - ref) << ")" << endl;
+        assert(std::abs(y - ref) < 0.01);
+    }
+
+    // The tone generators against a double-precision reference
+    {
+        const unsigned int n = 100000;
+        static cf32 tone[n];
+        static cq15 tone15[n];
+        make_complex_tone_cf32(tone, n, 2000, 600, 0.5, 30);
+        make_complex_tone_cq15(tone15, n, 2000, 600, 0.5, 30);
+        float maxError = 0, maxError15 = 0;
+        for (unsigned int k = 0; k < n; k++) {
+            const double phi = 2.0 * 3.14159265358979323846 * (600.0 * (double)k / 2000.0 + 30.0 / 360.0);
+            maxError = std::max(maxError, (float)std::abs(tone[k].r - 0.5 * std::cos(phi)));
+            maxError = std::max(maxError, (float)std::abs(tone[k].i - 0.5 * std::sin(phi)));
+            maxError15 = std::max(maxError15, (float)std::abs(q15_to_f32(tone15[k].r) - 0.5 * std::cos(phi)));
+            maxError15 = std::max(maxError15, (float)std::abs(q15_to_f32(tone15[k].i) - 0.5 * std::sin(phi)));
+        }
+        cout << "  Complex tone max error " << maxError << " (f32) " << maxError15 << " (q15)" << endl;
+        // Most of the error is the frequency resolution (sampleFreq / 2^32)
+        // adding up over the length of the tone.
+        assert(maxError < 5e-5);
+        assert(maxError15 < 3.0f / 32768.0f);
+    }
+
+    // Speed
+    {
+        const unsigned int n = 1000000;
+        static float out[4096];
+        NCO nco(2000, 600);
+        float ns[3];
+        for (uint16_t m = 0; m < 3; m++) {
+            nco.setInterpolationEnabled(m != 1);
+            float phi = 0;
+            const float omega = 2.0f * pi() * 600.0f / 2000.0f;
+            auto start = std::chrono::steady_clock::now();
+            for (unsigned int k = 0; k < n; k++) {
+                if (m == 2) {
+                    out[k & 4095] = std::cos(phi);
+                    phi += omega;
+                } else {
+                    out[k & 4095] = nco.nextF32();
+                }
+            }
+            auto end = std::chrono::steady_clock::now();
+            ns[m] = (float)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / (float)n;
+        }
+        cout << "  ns/sample : NCO " << ns[0] << ", NCO (no interpolation) " << ns[1] 
+            << ", std::cos " << ns[2] << " " << (out[7] > 0) << endl;
+    }
 }
 
 int main(int,const char**) {
     test_set_1();
     test_set_2();
     test_set_3();
+    test_set_4();
+    test_set_5();
+    test_set_6();
+    test_set_7();
+    test_set_8();
+    test_set_9();
+    test_set_10();
+    test_set_11();
+    test_set_12();
+    test_set_13();
+    test_set_14();
+    test_set_15();
+    test_set_16();
+    test_set_17();
 }
@@ -0,0 +1,177 @@
+/*
+Copyright (C) 2024 - Bruce MacKinnon KC1FSZ
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+#include "BandDFT.h"
+
+namespace radlib {
+
+static q15 clamp_q15(int64_t a) {
+    if (a > 32767) {
+        return 32767;
+    } else if (a < -32768) {
+        return -32768;
+    } else {
+        return (q15)a;
+    }
+}
+
+BandDFT::BandDFT(const FixedFFT& fft)
+:   _fft(fft),
+    _N(fft.getN()),
+    _log2N(std::log2(_N)),
+    _trigTable(fft.getTrigTable()),
+    _directBinLimit(defaultDirectBinLimit(_log2N)) {
+    setBand(0, _N / 2);
+}
+
+void BandDFT::setBand(uint16_t firstBin, uint16_t lastBin) {
+    _bandCount = 0;
+    addBand(firstBin, lastBin);
+}
+
+bool BandDFT::addBand(uint16_t firstBin, uint16_t lastBin) {
+    if (_bandCount == MAX_BANDS) {
+        return false;
+    }
+    _firstBin[_bandCount] = firstBin;
+    _lastBin[_bandCount] = lastBin;
+    _bandCount++;
+    _updateDirect();
+    return true;
+}
+
+void BandDFT::setDirectBinLimit(uint16_t bins) {
+    _directBinLimit = (bins > MAX_DIRECT_BINS) ? MAX_DIRECT_BINS : bins;
+    _updateDirect();
+}
+
+void BandDFT::_updateDirect() {
+    uint16_t bins = 0;
+    for (uint16_t b = 0; b < _bandCount; b++) {
+        if (_lastBin[b] >= _firstBin[b]) {
+            bins += _lastBin[b] - _firstBin[b] + 1;
+        }
+    }
+    _direct = bins <= _directBinLimit;
+}
+
+void BandDFT::transformReal(cq15 f[]) const {
+    if (_direct) {
+        _transformDirect(f, false);
+    } else {
+        _fft.transformReal(f);
+    }
+}
+
+uint16_t BandDFT::transformRealBFP(cq15 f[]) const {
+    if (_direct) {
+        return _transformDirect(f, true);
+    } else {
+        return _fft.transformRealBFP(f);
+    }
+}
+
+uint16_t BandDFT::_transformDirect(cq15 f[], bool bfp) const {
+
+    // The input is needed for every bin, so nothing can be written back
+    // until they are all done.
+    int64_t accR[MAX_DIRECT_BINS], accI[MAX_DIRECT_BINS];
+    uint16_t count = 0;
+    int64_t largest = 0;
+    for (uint16_t b = 0; b < _bandCount; b++) {
+        for (uint16_t k = _firstBin[b]; k <= _lastBin[b]; k++, count++) {
+            _bin(f, k, &accR[count], &accI[count]);
+            largest = std::max(largest, std::max(std::abs(accR[count]), std::abs(accI[count])));
+        }
+    }
+
+    // The table holds sin() / 2, so the accumulators are the DFT * 2^14.
+    // The normal exponent is log2(N) (i.e. DFT / N).  For block floating
+    // point the smallest exponent that stays below 0.5 is used, like 
+    // FixedFFT::transformRealBFP().
+    uint16_t exponent = _log2N;
+    if (bfp) {
+        exponent = 0;
+        while (((largest + ((int64_t)1 << (13 + exponent))) >> (14 + exponent)) >= 0x4000) {
+            exponent++;
+        }
+    }
+
+    const unsigned int shift = 14 + exponent;
+    const int64_t round = (int64_t)1 << (shift - 1);
+    count = 0;
+    for (uint16_t b = 0; b < _bandCount; b++) {
+        for (uint16_t k = _firstBin[b]; k <= _lastBin[b]; k++, count++) {
+            f[k].r = clamp_q15((accR[count] + round) >> shift);
+            f[k].i = clamp_q15((accI[count] + round) >> shift);
+        }
+    }
+    return exponent;
+}
+
+void BandDFT::_bin(const cq15 f[], uint16_t k, int64_t* accR, int64_t* accI) const {
+
+    // DC is just the sum (on the same scale as the other bins)
+    if (k == 0) {
+        int32_t sum = 0;
+        for (uint16_t n = 0; n < _N / 2; n++) {
+            sum += (int32_t)f[n].r + (int32_t)f[n].i;
+        }
+        *accR = (int64_t)sum << 14;
+        *accI = 0;
+        return;
+    }
+
+    const uint16_t mask = _N - 1;
+    const uint16_t quarter = _N >> 2;
+
+    // The even samples (in the real parts) and the odd samples (in the 
+    // imaginary parts) are transformed separately (E and O) since they use 
+    // the same twiddles, which halves the table lookups:
+    //
+    //   X[k] = E[k] + e^(-j 2PI k / N) O[k]
+    //
+    // The twiddle index for entry n is (2 * k * n) mod N.
+    const uint16_t step = (2 * k) & mask;
+    uint16_t idx = 0;
+    int64_t er = 0, ei = 0, or_ = 0, oi = 0;
+
+    for (uint16_t n = 0; n < _N / 2; n++) {
+        // Multiply by cos() - j sin()
+        // NOTE: The trig table holds sin() / 2
+        const int32_t c = _trigTable[(idx + quarter) & mask];
+        const int32_t s = _trigTable[idx];
+        er += f[n].r * c;
+        ei -= f[n].r * s;
+        or_ += f[n].i * c;
+        oi -= f[n].i * s;
+        idx = (idx + step) & mask;
+    }
+
+    // The last twiddle (e^(-j 2PI k / N)) is also in the table.  The table 
+    // values are cos() and sin() * 2^14, so the products are shifted back 
+    // down with rounding.
+    const int64_t c = _trigTable[(k + quarter) & mask];
+    const int64_t s = _trigTable[k];
+    const int64_t round = (int64_t)1 << 13;
+    *accR = er + ((c * or_ + s * oi + round) >> 14);
+    *accI = ei + ((c * oi - s * or_ + round) >> 14);
+}
+
+}
@@ -0,0 +1,146 @@
+/*
+Copyright (C) 2024 - Bruce MacKinnon KC1FSZ
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef _BandDFT_h
+#define _BandDFT_h
+
+#include <cstdint>
+
+#include "fixed_math.h"
+#include "fixed_fft.h"
+
+namespace radlib {
+
+/**
+ * Computes a few ranges of bins of a real DFT.  This is a drop-in for 
+ * FixedFFT::transformReal() when only some of the bins are needed (i.e. 
+ * the mark and space of a locked FSK signal).
+ *
+ * When the bands are narrow the bins are evaluated directly, one at a 
+ * time (a bank of single-bin DFTs using the FFT trig table).  That is O(N) 
+ * per bin, so once the bands get wider the full FFT is cheaper and it is 
+ * used instead.  The crossover is picked automatically from the size of 
+ * the transform and can be overridden.
+ *
+ * The direct evaluation uses the same twiddles as the FFT but accumulates
+ * with full precision and only rounds at the end, so it is slightly more 
+ * accurate than the FFT (which truncates at every stage).  The two won't 
+ * match bit-for-bit.  There is no floating point on this path.
+ *
+ * There is no internal memory allocation/deallocation.
+ */
+class BandDFT {
+public:
+
+    /**
+     * The most bins that will ever be evaluated directly.  The results are
+     * held on the stack until the input is no longer needed.
+     */
+    static const uint16_t MAX_DIRECT_BINS = 32;
+    static const uint16_t MAX_BANDS = 3;
+
+    /**
+     * Starts off with all of the bins (i.e. the full FFT).
+     *
+     * @param fft The FFT used for the wide bands.  This also provides the 
+     *   trig table.
+     */
+    BandDFT(const FixedFFT& fft);
+
+    /**
+     * Makes this the only band needed.  The crossover is re-evaluated.
+     *
+     * @param firstBin The first bin needed.
+     * @param lastBin The last bin needed (inclusive, at most N/2).
+     */
+    void setBand(uint16_t firstBin, uint16_t lastBin);
+
+    /**
+     * Adds another band to the bins needed.  The crossover is re-evaluated.
+     *
+     * @returns false if there are already MAX_BANDS bands.
+     */
+    bool addBand(uint16_t firstBin, uint16_t lastBin);
+
+    /**
+     * @param bins The most bins (across all bands) that are evaluated 
+     *   directly, or 0 to always run the full FFT.  Limited to 
+     *   MAX_DIRECT_BINS.
+     */
+    void setDirectBinLimit(uint16_t bins);
+
+    /**
+     * @returns The most bins that are evaluated directly when the limit
+     *   hasn't been overridden.  The real FFT needs about N * (log2(N) + 1)
+     *   multiplies and the direct evaluation needs 2 * N per bin, but the 
+     *   direct loop is much simpler so it breaks even at about 
+     *   log2(N) - 1 bins (i.e. 8 bins for N = 512).
+     */
+    static constexpr uint16_t defaultDirectBinLimit(uint16_t log2N) {
+        return (log2N > 2) ? log2N - 1 : 1;
+    }
+
+    /**
+     * @returns true if the current bands are being evaluated directly.
+     */
+    bool isDirect() const { return _direct; }
+
+    /**
+     * Same as FixedFFT::transformReal(), except that only the bins in the 
+     * bands are valid on output.  The others are undefined.
+     */
+    void transformReal(cq15 f[]) const;
+
+    /**
+     * Same as FixedFFT::transformRealBFP(), except that only the bins in 
+     * the bands are valid on output.
+     *
+     * @returns The exponent s.  The result is DFT / 2^s.
+     */
+    uint16_t transformRealBFP(cq15 f[]) const;
+
+private:
+
+    void _updateDirect();
+
+    /**
+     * Evaluates the bins directly.
+     *
+     * @param bfp Set to true to pick the smallest exponent that leaves 
+     *   one bit of headroom, otherwise the exponent is log2(N).
+     * @returns The exponent.
+     */
+    uint16_t _transformDirect(cq15 f[], bool bfp) const;
+
+    /**
+     * Bin k of the packed real input, before any scaling.  The trig table
+     * holds sin() / 2, so this is the DFT * 2^14.
+     */
+    void _bin(const cq15 f[], uint16_t k, int64_t* accR, int64_t* accI) const;
+
+    const FixedFFT& _fft;
+    const uint16_t _N;
+    const uint16_t _log2N;
+    const q15* _trigTable;
+    uint16_t _firstBin[MAX_BANDS];
+    uint16_t _lastBin[MAX_BANDS];
+    uint16_t _bandCount = 0;
+    uint16_t _directBinLimit;
+    bool _direct = false;
+};
+
+}
+
+#endif
@@ -0,0 +1,148 @@
+/*
+Copyright (C) 2024 - Bruce MacKinnon KC1FSZ
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <cstring>
+#include <cmath>
+
+#include "CICDecimator.h"
+#include "dsp_util.h"
+
+namespace radlib {
+
+float CICDecimator::cicResponse(uint16_t order, uint16_t cicDecimation, float f) {
+    if (f == 0) {
+        return 1.0f;
+    }
+    const float a = std::sin(pi() * f) / 
+        ((float)cicDecimation * std::sin(pi() * f / (float)cicDecimation));
+    return std::pow(std::abs(a), (float)order);
+}
+
+CICDecimator::CICDecimator(uint16_t order, uint16_t cicDecimation, uint16_t firDecimation,
+    uint16_t firTaps, q15* firSpace, q15* historySpace)
+:   _order(order > MAX_ORDER ? MAX_ORDER : order),
+    _r(cicDecimation),
+    _d(firDecimation),
+    _firTaps(firTaps),
+    _fir(firSpace),
+    _history(historySpace) {
+
+    // The CIC gain is R^N, which needs this many bits
+    const double gain = std::pow((double)_r, (double)_order);
+    const uint16_t growth = (uint16_t)std::ceil(std::log2(gain) - 1e-9);
+    _inputShift = (16 + growth > 32) ? 16 + growth - 32 : 0;
+    _outputShift = growth - _inputShift;
+    // What is left after shifting back to q15
+    const float cicGain = (float)(gain / std::pow(2.0, (double)growth));
+
+    // The FIR is built by sampling the desired response (the inverse of 
+    // the CIC droop up to the final Nyquist frequency, zero beyond) and 
+    // applying a Blackman window.  The taps are scaled for unity gain at 
+    // DC, including the CIC gain.
+    float dc = 0;
+    for (uint16_t i = 0; i < _firTaps; i++) {
+        dc += _compensationTap(i);
+    }
+    for (uint16_t i = 0; i < _firTaps; i++) {
+        _fir[i] = (q15)std::round(_compensationTap(i) / (dc * cicGain) * 16384.0f);
+    }
+
+    reset();
+}
+
+float CICDecimator::_compensationTap(uint16_t i) const {
+    // Frequencies are relative to the CIC output rate
+    const float cutoff = 0.5f / (float)_d;
+    const uint16_t gridN = 512;
+    const float t = (float)i - (float)(_firTaps - 1) / 2.0f;
+    float sum = 0;
+    for (uint16_t k = 0; k < gridN; k++) {
+        const float f = cutoff * ((float)k + 0.5f) / (float)gridN;
+        sum += std::cos(2.0f * pi() * f * t) / cicResponse(_order, _r, f);
+    }
+    const float a = 2.0f * pi() * (float)i / (float)(_firTaps - 1);
+    return sum * (2.0f * cutoff / (float)gridN) * 
+        (0.42f - 0.5f * std::cos(a) + 0.08f * std::cos(2.0f * a));
+}
+
+void CICDecimator::reset() {
+    memset((void*)_integrator, 0, sizeof(_integrator));
+    memset((void*)_comb, 0, sizeof(_comb));
+    memset((void*)_history, 0, historySpaceSize(_firTaps) * sizeof(q15));
+    _cicPhase = 0;
+    _firPhase = 0;
+    _historyPtr = 0;
+}
+
+unsigned int CICDecimator::process(const q15* in, unsigned int n, q15* out) {
+
+    unsigned int outN = 0;
+
+    for (unsigned int k = 0; k < n; k++) {
+
+        // The integrators.  Unsigned arithmetic is used so that the wrap 
+        // is well-defined.
+        uint32_t v = (uint32_t)((int32_t)in[k] >> _inputShift);
+        for (uint16_t s = 0; s < _order; s++) {
+            _integrator[s] += v;
+            v = _integrator[s];
+        }
+        if (++_cicPhase < _r) {
+            continue;
+        }
+        _cicPhase = 0;
+
+        // The combs (differential delay of 1) run at the decimated rate
+        for (uint16_t s = 0; s < _order; s++) {
+            const uint32_t prev = _comb[s];
+            _comb[s] = v;
+            v -= prev;
+        }
+        const int32_t cic = (int32_t)v;
+        int32_t x = (_outputShift > 0) ? 
+            ((cic + (1 << (_outputShift - 1))) >> _outputShift) : cic;
+        if (x > 32767) {
+            x = 32767;
+        } else if (x < -32768) {
+            x = -32768;
+        }
+
+        // The history runs backwards and each sample is written twice so 
+        // that the most recent samples are always contiguous, starting 
+        // with the newest.
+        if (_historyPtr-- == 0) {
+            _historyPtr = _firTaps - 1;
+        }
+        _history[_historyPtr] = (q15)x;
+        _history[_historyPtr + _firTaps] = (q15)x;
+        if (++_firPhase < _d) {
+            continue;
+        }
+        _firPhase = 0;
+
+        q31 acc = fir_q15(_fir, _history + _historyPtr, _firTaps);
+        acc = (acc + (1 << 13)) >> 14;
+        if (acc > 32767) {
+            acc = 32767;
+        } else if (acc < -32768) {
+            acc = -32768;
+        }
+        out[outN++] = (q15)acc;
+    }
+
+    return outN;
+}
+
+}
@@ -0,0 +1,135 @@
+/*
+Copyright (C) 2024 - Bruce MacKinnon KC1FSZ
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef _CICDecimator_h
+#define _CICDecimator_h
+
+#include <cstdint>
+
+#include "fixed_math.h"
+
+namespace radlib {
+
+/**
+ * Brings a high input rate down to a low one in two stages: a 
+ * cascaded-integrator-comb (CIC) decimator by R, followed by a short 
+ * compensation FIR that decimates by D.  For example, 96 kHz to 2 kHz is
+ * R = 24 (to 4 kHz) and D = 2.
+ *
+ * The CIC stage has no multiplies at all: N integrators run at the input 
+ * rate and N combs run at the input rate / R.  The registers are 32 bits 
+ * and wrap, which is fine because the combs take the wrap back out.  The 
+ * CIC needs 16 + ceil(N * log2(R)) bits, so if that is more than 32 the 
+ * low bits of the input are dropped.  (A 12-bit ADC can have 4 bits of 
+ * growth for free.)
+ *
+ * The CIC response is (sin(pi f R) / (R sin(pi f))) ^ N, which droops
+ * across the passband.  The FIR undoes the droop up to the final Nyquist
+ * frequency and rejects everything above it before the final decimation.
+ * It is a Blackman windowed design, so its transition band is about 
+ * 5.5 / firTaps of the CIC output rate wide.  Only every D'th FIR output is 
+ * computed.  The FIR also takes care of the CIC gain (which is only a 
+ * power of two when R is), so the overall gain is 1.
+ *
+ * Most of the aliasing protection comes from the CIC nulls at multiples 
+ * of the CIC output rate, so keep D small (2 or 4) and the order up 
+ * (3 to 5).
+ *
+ * There is no internal memory allocation/deallocation.
+ */
+class CICDecimator {
+public:
+
+    static const uint16_t MAX_ORDER = 6;
+
+    /**
+     * @param order The number of CIC stages (N, up to MAX_ORDER).
+     * @param cicDecimation The CIC decimation factor (R).
+     * @param firDecimation The FIR decimation factor (D).
+     * @param firTaps The length of the compensation FIR (odd).
+     * @param firSpace Space for the FIR coefficients (firTaps).
+     * @param historySpace Space for the FIR input history.  See 
+     *   historySpaceSize().
+     */
+    CICDecimator(uint16_t order, uint16_t cicDecimation, uint16_t firDecimation,
+        uint16_t firTaps, q15* firSpace, q15* historySpace);
+
+    static constexpr uint16_t historySpaceSize(uint16_t firTaps) {
+        return 2 * firTaps;
+    }
+
+    /**
+     * @returns The most outputs that process() can produce for n inputs.
+     */
+    static constexpr unsigned int maxOutputs(uint16_t cicDecimation, 
+        uint16_t firDecimation, unsigned int n) {
+        return (n + cicDecimation * firDecimation - 1) / (cicDecimation * firDecimation);
+    }
+
+    /**
+     * @returns The magnitude response of the CIC stage (normalized to 1 at
+     *   DC).
+     * @param f The frequency as a fraction of the CIC output rate.
+     */
+    static float cicResponse(uint16_t order, uint16_t cicDecimation, float f);
+
+    /**
+     * Clears all of the state.
+     */
+    void reset();
+
+    /**
+     * Decimates the next n samples of the stream.  The stream can be 
+     * broken up any way, the result is the same.
+     *
+     * @param out Space for the outputs.  See maxOutputs().
+     * @returns The number of outputs produced.
+     */
+    unsigned int process(const q15* in, unsigned int n, q15* out);
+
+    /**
+     * @returns The number of input bits dropped to avoid overflowing the
+     *   CIC registers.
+     */
+    uint16_t getInputShift() const { return _inputShift; }
+
+private:
+
+    /**
+     * @returns One tap of the compensation FIR before it is scaled.
+     */
+    float _compensationTap(uint16_t i) const;
+
+    const uint16_t _order;
+    const uint16_t _r;
+    const uint16_t _d;
+    const uint16_t _firTaps;
+    // The CIC output is shifted by this much to get back to q15
+    uint16_t _outputShift;
+    uint16_t _inputShift;
+    // The compensation FIR with one integer bit (i.e. 1.0 = 16384)
+    q15* _fir;
+    q15* _history;
+
+    uint32_t _integrator[MAX_ORDER];
+    uint32_t _comb[MAX_ORDER];
+    uint16_t _cicPhase = 0;
+    uint16_t _firPhase = 0;
+    uint16_t _historyPtr = 0;
+};
+
+}
+
+#endif
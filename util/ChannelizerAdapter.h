@@ -0,0 +1,171 @@
+/*
+Copyright (C) 2024 - Bruce MacKinnon KC1FSZ
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef _ChannelizerAdapter_h
+#define _ChannelizerAdapter_h
+
+#include <cstdint>
+#include <cmath>
+
+#include "fixed_math.h"
+#include "dsp_util.h"
+
+namespace radlib {
+
+/**
+ * Connects one channel of a FixedChannelizer/F32Channelizer to a demodulator
+ * that takes real samples (i.e. SCAMPDemodulator or RTTYDemodulator).  The
+ * demodulator runs at the channel output rate (2 * sampleFreq / M).
+ *
+ * The channel's baseband is moved up by a quarter of the output rate and 
+ * the real part is taken.  This is just a sign/swap pattern that repeats 
+ * every four samples.  A tone at f Hz in the input shows up at 
+ * toChannelFreq(f, ...) in the demodulator, which is where the frequency 
+ * lock should be set.  
+ *
+ * This costs half of the channel output's bandwidth: only the channel 
+ * proper (+/- half the channel spacing) fits between DC and Nyquist, and 
+ * anything in the channelizer's transition band beyond that folds back
+ * over the channel edges as an image.  Tones within about 40% of the 
+ * channel spacing of the channel center are clean.  The real path is 
+ * kept because it works with anything that takes real samples 
+ * (FSKSkimmer included) and because the real-input demodulator is 
+ * cheaper (half-size FFT, real correlation).  When the demodulator has 
+ * complex input (see DemodulatorT::setComplexInput()), use 
+ * ComplexChannelizerAdapter instead, which keeps the whole channel output
+ * with no image.
+ *
+ * D is any class with a processSample(q15) function.
+ */
+template <class D> class ChannelizerAdapter {
+public:
+
+    /**
+     * @param demodulator The demodulator that receives the samples.
+     * @param channel The channelizer channel to be demodulated.
+     */
+    ChannelizerAdapter(D& demodulator, uint16_t channel)
+    :   _demodulator(demodulator),
+        _channel(channel) { }
+
+    /**
+     * Call this each time the channelizer has a new set of outputs.
+     */
+    void processOutputs(const cq15* outputs) {
+        _processOutput(outputs[_channel]);
+    }
+
+    /**
+     * The same as above for the F32Channelizer.
+     */
+    void processOutputs(const cf32* outputs) {
+        cq15 y;
+        y.r = f32_to_q15(outputs[_channel].r);
+        y.i = f32_to_q15(outputs[_channel].i);
+        _processOutput(y);
+    }
+
+    void reset() { _phase = 0; }
+
+    /**
+     * @returns The channel that a frequency (in the input) falls into.
+     */
+    static uint16_t freqToChannel(float freqHz, float sampleFreq, uint16_t channelCount) {
+        return (uint16_t)std::round(freqHz * (float)channelCount / sampleFreq);
+    }
+
+    /**
+     * @returns The frequency that the demodulator sees for a frequency in
+     *   the input.
+     */
+    static float toChannelFreq(float freqHz, uint16_t channel, float sampleFreq, 
+        uint16_t channelCount) {
+        const float spacing = sampleFreq / (float)channelCount;
+        return freqHz - (float)channel * spacing + spacing / 2.0f;
+    }
+
+private:
+
+    // Negation saturates (-32768 has no positive q15)
+    static q15 _negate(q15 a) {
+        return (a == -32768) ? 32767 : -a;
+    }
+
+    void _processOutput(cq15 y) {
+        q15 sample;
+        switch (_phase) {
+            case 0: sample = y.r; break;
+            case 1: sample = _negate(y.i); break;
+            case 2: sample = _negate(y.r); break;
+            default: sample = y.i; break;
+        }
+        _phase = (_phase + 1) & 3;
+        _demodulator.processSample(sample);
+    }
+
+    D& _demodulator;
+    const uint16_t _channel;
+    uint16_t _phase = 0;
+};
+
+/**
+ * Connects one channel of a FixedChannelizer/F32Channelizer to a demodulator
+ * with complex input (see DemodulatorT::setComplexInput()).  The channel's 
+ * complex baseband is passed straight through, so the whole channel output
+ * (+/- the channel spacing) is usable and there is no image.  A tone at f 
+ * Hz in the input shows up at toChannelFreq(f, ...) in the demodulator, 
+ * which is negative below the channel center.
+ *
+ * D is any class with a processSample(cq15) function.
+ */
+template <class D> class ComplexChannelizerAdapter {
+public:
+
+    ComplexChannelizerAdapter(D& demodulator, uint16_t channel)
+    :   _demodulator(demodulator),
+        _channel(channel) { }
+
+    /**
+     * Call this each time the channelizer has a new set of outputs.
+     */
+    void processOutputs(const cq15* outputs) {
+        _demodulator.processSample(outputs[_channel]);
+    }
+
+    void processOutputs(const cf32* outputs) {
+        cq15 y;
+        y.r = f32_to_q15(outputs[_channel].r);
+        y.i = f32_to_q15(outputs[_channel].i);
+        _demodulator.processSample(y);
+    }
+
+    /**
+     * @returns The frequency that the demodulator sees for a frequency in
+     *   the input.
+     */
+    static float toChannelFreq(float freqHz, uint16_t channel, float sampleFreq, 
+        uint16_t channelCount) {
+        return freqHz - (float)channel * sampleFreq / (float)channelCount;
+    }
+
+private:
+
+    D& _demodulator;
+    const uint16_t _channel;
+};
+
+}
+
+#endif
@@ -0,0 +1,125 @@
+/*
+Copyright (C) 2024 - Bruce MacKinnon KC1FSZ
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <cstring>
+
+#include "Convolver.h"
+
+namespace radlib {
+
+Convolver::Convolver(const f32* h, uint16_t taps, const F32FFT* fft, 
+    f32* bufferSpace, cf32* filterSpace, cf32* workSpace)
+:   _h(h),
+    _taps(taps),
+    _fft(fft),
+    _buffer(bufferSpace),
+    _filter(filterSpace),
+    _work(workSpace) {
+
+    // The filter spectrum (zero padded to N).  The FFT includes a 1/N 
+    // that is taken back out here, so that the product of the spectra 
+    // gives the convolution after the inverse.
+    if (_fft != 0 && _fft->getN() >= 2 * _taps) {
+        const uint16_t fftN = _fft->getN();
+        f32* packed = (f32*)_filter;
+        for (uint16_t i = 0; i < fftN; i++) {
+            packed[i] = (i < _taps) ? h[i] : 0;
+        }
+        _fft->transformReal(_filter);
+        for (uint16_t k = 0; k <= fftN / 2; k++) {
+            _filter[k].r *= fftN;
+            _filter[k].i *= fftN;
+        }
+    }
+
+    setFFTCrossover(DEFAULT_FFT_CROSSOVER);
+}
+
+void Convolver::setFFTCrossover(uint16_t taps) {
+    _useFFT = _fft != 0 && _fft->getN() >= 2 * _taps && _taps >= taps;
+    reset();
+}
+
+void Convolver::reset() {
+    const uint16_t size = bufferSpaceSize(_taps, _useFFT ? _fft->getN() : 0);
+    memset((void*)_buffer, 0, size * sizeof(f32));
+    _pos = 0;
+}
+
+void Convolver::process(const f32* in, f32* out, unsigned int n) {
+    if (_useFFT) {
+        _processFFT(in, out, n);
+    } else {
+        _processDirect(in, out, n);
+    }
+}
+
+void Convolver::_processDirect(const f32* in, f32* out, unsigned int n) {
+    // The history is stored newest first, twice in a row, so the taps can
+    // always be run across a contiguous part of the buffer without 
+    // wrapping.
+    for (unsigned int i = 0; i < n; i++) {
+        _pos = (_pos == 0) ? _taps - 1 : _pos - 1;
+        _buffer[_pos] = in[i];
+        _buffer[_pos + _taps] = in[i];
+        const f32* x = _buffer + _pos;
+        float sumOfProducts = 0;
+        for (uint16_t k = 0; k < _taps; k++) {
+            sumOfProducts += _h[k] * x[k];
+        }
+        out[i] = sumOfProducts;
+    }
+}
+
+void Convolver::_processFFT(const f32* in, f32* out, unsigned int n) {
+
+    const uint16_t fftN = _fft->getN();
+    const uint16_t history = _taps - 1;
+    // The new samples in each block
+    const uint16_t blockL = fftN - history;
+    f32* packed = (f32*)_work;
+
+    while (n > 0) {
+
+        const uint16_t c = (n < blockL) ? n : blockL;
+
+        // The block is the history followed by the new samples (zero 
+        // padded if there aren't enough).
+        memcpy((void*)(_buffer + history), (const void*)in, c * sizeof(f32));
+        memset((void*)(_buffer + history + c), 0, (blockL - c) * sizeof(f32));
+        memcpy((void*)packed, (const void*)_buffer, fftN * sizeof(f32));
+
+        _fft->transformReal(_work);
+        for (uint16_t k = 0; k <= fftN / 2; k++) {
+            const cf32 x = _work[k];
+            const cf32 h = _filter[k];
+            _work[k] = cf32(x.r * h.r - x.i * h.i, x.r * h.i + x.i * h.r);
+        }
+        _fft->inverseTransformReal(_work);
+
+        // The first taps - 1 results are wrapped around (circular 
+        // convolution) and are discarded.
+        memcpy((void*)out, (const void*)(packed + history), c * sizeof(f32));
+
+        // The end of this block is the history for the next one
+        memmove((void*)_buffer, (const void*)(_buffer + c), history * sizeof(f32));
+
+        in += c;
+        out += c;
+        n -= c;
+    }
+}
+
+}
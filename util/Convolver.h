@@ -0,0 +1,139 @@
+/*
+Copyright (C) 2024 - Bruce MacKinnon KC1FSZ
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef _Convolver_h
+#define _Convolver_h
+
+#include <cstdint>
+
+#include "dsp_util.h"
+#include "f32_fft.h"
+
+namespace radlib {
+
+/**
+ * A streaming FIR filter (convolution) for f32 samples.  The output is the
+ * same as convolve_f32() run across the whole stream, no matter how the 
+ * stream is broken up into calls to process(), and there is no latency.
+ *
+ * Short filters are run in direct form.  Long filters are run using FFT 
+ * convolution (overlap-save): each block of N samples (the last taps - 1 
+ * from the previous block plus L = N - taps + 1 new ones) is transformed, 
+ * multiplied by the transform of the filter and transformed back, which 
+ * gives L outputs.  The cost per sample is O(log N) rather than O(taps).
+ * The switch happens automatically at a tap-count crossover.
+ *
+ * Calls that pass a multiple of L samples are the most efficient.  A 
+ * partial block is padded with zeros, so it costs as much as a full one.
+ *
+ * There is no internal memory allocation/deallocation.
+ */
+class Convolver {
+public:
+
+    /**
+     * The default tap-count crossover between direct form and FFT 
+     * convolution.  See setFFTCrossover().  On x86-64 (release build,
+     * N = fftSize()) the two break even at about 8 taps, and the FFT is 
+     * 3x faster at 64 taps.
+     */
+    static const uint16_t DEFAULT_FFT_CROSSOVER = 16;
+
+    /**
+     * @param h The filter coefficients.  These are copied into the filter
+     *   spectrum, but the direct form uses them in place so they need to 
+     *   stay around.
+     * @param taps The number of filter coefficients.
+     * @param fft The FFT used for the fast convolution, or 0 to always 
+     *   use the direct form.  The size must be at least 2 * taps (see 
+     *   fftSize()).
+     * @param bufferSpace Space for the sample history.  See 
+     *   bufferSpaceSize().
+     * @param filterSpace Space for the filter spectrum (0 if there is no 
+     *   FFT).  See spectrumSpaceSize().
+     * @param workSpace Space for the FFT (0 if there is no FFT).  See 
+     *   spectrumSpaceSize().
+     */
+    Convolver(const f32* h, uint16_t taps, const F32FFT* fft, 
+        f32* bufferSpace, cf32* filterSpace, cf32* workSpace);
+
+    /**
+     * @returns The recommended FFT size for a filter.  This keeps the
+     *   block length L at 3/4 of N or more.
+     */
+    static constexpr uint16_t fftSize(uint16_t taps) {
+        uint16_t n = 2;
+        while (n < 4 * taps) {
+            n <<= 1;
+        }
+        return n;
+    }
+
+    /**
+     * @returns The number of entries needed for the buffer space.
+     */
+    static constexpr uint16_t bufferSpaceSize(uint16_t taps, uint16_t fftN) {
+        return (2 * taps > fftN) ? 2 * taps : fftN;
+    }
+
+    /**
+     * @returns The number of entries needed for the filter/work space.
+     */
+    static constexpr uint16_t spectrumSpaceSize(uint16_t fftN) {
+        return fftN / 2 + 1;
+    }
+
+    /**
+     * @param taps Filters with at least this many taps use the FFT 
+     *   convolution (if possible).  This clears the sample history.
+     */
+    void setFFTCrossover(uint16_t taps);
+
+    /**
+     * @returns true if the FFT convolution is being used.
+     */
+    bool isFFT() const { return _useFFT; }
+
+    /**
+     * Clears the sample history (i.e. back to all zeros).
+     */
+    void reset();
+
+    /**
+     * Filters the next n samples of the stream.
+     *
+     * @param out The filtered samples.  This can't be the same as in.
+     */
+    void process(const f32* in, f32* out, unsigned int n);
+
+private:
+
+    void _processDirect(const f32* in, f32* out, unsigned int n);
+    void _processFFT(const f32* in, f32* out, unsigned int n);
+
+    const f32* _h;
+    const uint16_t _taps;
+    const F32FFT* _fft;
+    f32* _buffer;
+    cf32* _filter;
+    cf32* _work;
+    bool _useFFT = false;
+    // The position of the newest sample in the direct form buffer
+    uint16_t _pos = 0;
+};
+
+}
+
+#endif
@@ -0,0 +1,36 @@
+/*
+Copyright (C) 2024 - Bruce MacKinnon KC1FSZ
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef _DemodulatorDefs_h
+#define _DemodulatorDefs_h
+
+#include <cstdint>
+
+// The default demodulator sizes (see DemodulatorT for a description).  The 
+// FSKSkimmer and its FSKChannels use the same values.
+#define DEMODULATOR_BLOCK_SIZE (32)
+#define DEMODULATOR_LOG2_TONE_N (4)
+#define DEMODULATOR_TONE_N (1 << DEMODULATOR_LOG2_TONE_N)
+#define DEMODULATOR_SAMPLES_PER_SYMBOL (60)
+
+namespace radlib {
+
+// The LPF that is applied to the symbol correlations (see Demodulator.cpp)
+const uint16_t h_lpf_33_size = 47;
+extern const float h_lpf_33[];
+
+}
+
+#endif
@@ -20,8 +20,23 @@ this program. If not, see <https://www.gnu.org/licenses/>.
 #include "../util/fixed_math.h"
 #include "../util/DataListener.h"
 
+#define SYMBOL_COUNT (2)
+
 namespace radlib {
 
+/**
+ * The per-sample demodulator metrics, used when the metrics are 
+ * delivered in batches.
+ */
+struct SampleMetrics {
+    q15 sample;
+    uint8_t activeSymbol;
+    bool isAnySymbolPresent;
+    // Set if a symbol transition was detected on this sample
+    bool symbolTransition;
+    float symbolCorr[SYMBOL_COUNT];
+};
+
 /**
  * An abstract interface used to receive status/events from the demodulator
  */
@@ -31,6 +46,19 @@ public:
     // ----- FSK Demodulator Methods ------------------------------------------
 
     virtual void frequencyLocked(uint16_t markFreq, uint16_t spaceFreq) { }
+    /**
+     * Called instead of frequencyLocked() when the demodulator has complex
+     * input, since the frequencies can be negative.  The default passes 
+     * them on to frequencyLocked() (a negative frequency wraps around).
+     */
+    virtual void frequencyLockedSigned(int16_t markFreq, int16_t spaceFreq) { 
+        frequencyLocked((uint16_t)markFreq, (uint16_t)spaceFreq);
+    }
+    /**
+     * Called when the locked signal has not been seen for a while
+     * and the demodulator is being reset.
+     */
+    virtual void frequencyLockLost() { }
     virtual void symbolTransitionDetected() { }
     //virtual void isSymbolPresent(bool e) { }
 
@@ -40,6 +68,22 @@ public:
      */
     virtual void sampleMetrics(q15 sample, uint8_t activeSymbol, float* symbolCorr, bool isAnySymbolPresent) { }
 
+    /**
+     * Delivers a batch of metrics (oldest first).  This is used instead of 
+     * sampleMetrics() and symbolTransitionDetected() when the demodulator 
+     * has been given a metrics buffer. The default just makes the 
+     * per-sample calls.
+     */
+    virtual void sampleMetricsBatch(SampleMetrics* metrics, uint16_t n) { 
+        for (uint16_t i = 0; i < n; i++) {
+            if (metrics[i].symbolTransition) {
+                symbolTransitionDetected();
+            }
+            sampleMetrics(metrics[i].sample, metrics[i].activeSymbol, 
+                metrics[i].symbolCorr, metrics[i].isAnySymbolPresent);
+        }
+    }
+
     // ----- DataListener Methods ---------------------------------------------
 
     virtual void received(char asciiChar) { }
@@ -0,0 +1,667 @@
+/*
+Copyright (C) 2024 - Bruce MacKinnon KC1FSZ
+
+This program is free software: you can redistribute it and/or modify it under 
+the terms of the GNU General Public License as published by the Free 
+Software Foundation, either version 3 of the License, or (at your option) any 
+later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT 
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS 
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with 
+this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef _DemodulatorT_h
+#define _DemodulatorT_h
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <cmath>
+#include <type_traits>
+#include <algorithm>
+
+#include "../util/fixed_math.h"
+#include "../util/fixed_fft.h"
+#include "../util/fixed_fft31.h"
+#include "../util/dsp_util.h"
+#include "../util/SharedTables.h"
+#include "../util/BandDFT.h"
+#include "../util/FirFilter.h"
+#include "../util/SlidingDFT.h"
+#include "../util/SlidingCorrelator.h"
+#include "DemodulatorListener.h"
+#include "DemodulatorDefs.h"
+
+namespace radlib {
+
+/**
+ * The memory used by a DemodulatorT with a compile-time FFT size.  The
+ * trig table and window are read-only, so they come from SharedTables.
+ */
+template <uint16_t Log2FFT> 
+class DemodulatorSpace {
+protected:
+    // Only the non-negative frequencies (see FixedFFT::transformReal())
+    cq15 _fftResultSpace[(1 << Log2FFT) / 2 + 1];
+    q15 _bufferSpace[1 << Log2FFT];
+};
+
+/**
+ * When the FFT size is set at runtime the caller provides the memory.
+ */
+template <> 
+class DemodulatorSpace<0> {
+};
+
+/**
+ * This contains all of the FSK demodulator logic.  This is a stateful
+ * object that will be called once every sample interval with the latest
+ * available sample.
+ *
+ * The sizes that drive the inner loops are template parameters so that 
+ * they are compile-time constants.  Use the Demodulator typedef (i.e. 
+ * Log2FFT = 0) to set the FFT size at runtime.
+ *
+ * The member functions are defined in DemodulatorTImpl.h.  The runtime 
+ * versions (Log2FFT = 0 with the default sizes, with and without metrics) 
+ * are compiled once in Demodulator.cpp so users of those only need this 
+ * header.  Include DemodulatorTImpl.h to use any other configuration.
+ *
+ * @param Log2FFT The size of the FFT used for spectral analysis in log 
+ *   terms, or 0 if this is passed to the constructor.  When non-zero 
+ *   the demodulator contains all of its own buffers.
+ * @param BlockSize The spectral analysis is run each time this number of 
+ *   samples has been collected.
+ * @param ToneN The length of the symbol correlation (must be a power of 
+ *   two).
+ * @param SamplesPerSymbol The approximate symbol length.  This is only used
+ *   to estimate the length of the "long mark" used for the auto-lock.
+ * @param MetricsEnabled Set to false to compile out the per-sample metrics
+ *   reporting (sampleMetrics()).
+ */
+template <uint16_t Log2FFT, uint16_t BlockSize = DEMODULATOR_BLOCK_SIZE, 
+    uint16_t ToneN = DEMODULATOR_TONE_N, 
+    uint16_t SamplesPerSymbol = DEMODULATOR_SAMPLES_PER_SYMBOL, bool MetricsEnabled = true>
+class DemodulatorT : private DemodulatorSpace<Log2FFT> {
+public:
+
+    /**
+     * Use this constructor when Log2FFT is 0.  The caller provides all 
+     * of the memory.
+     *
+     * @param maxSampleN Controls how many samples are used to maintain the 
+     *   "maximum sample value."  This feature is useful for tuning the 
+     *   gain on the receiver.
+     * @param fftResultSpace Space for the FFT result.  Must have room for
+     *   fftResultSpaceSize() entries.
+     * @param slidingDFTSpace If provided, the spectral analysis is done 
+     *   using a sliding DFT that is updated on every sample instead of 
+     *   running a full FFT every block.  Must have room for 
+     *   slidingDFTSpaceSize() bins.
+    */
+
+    DemodulatorT(uint16_t sampleFreq, uint16_t lowestFreq,
+        uint16_t log2fftN,
+        q15* fftTrigTableSpace, q15* fftWindowSpace, cq15* fftResultSpace, 
+        q15* bufferSpace,
+        uint16_t maxSampleN = 512,
+        SlidingDFT::Bin* slidingDFTSpace = 0);
+
+    /**
+     * Same as above, but the FFT trig table and window have already been 
+     * built (see FixedFFT::makeTrigTable(), make_hann_window_q15() and 
+     * SharedTables).  They are only read, so they can be shared by any 
+     * number of demodulators with the same FFT size.
+     *
+     * @param fftWindow The Hann window, or 0 for none.
+     */
+    DemodulatorT(uint16_t sampleFreq, uint16_t lowestFreq,
+        uint16_t log2fftN,
+        const q15* fftTrigTable, const q15* fftWindow, cq15* fftResultSpace, 
+        q15* bufferSpace,
+        uint16_t maxSampleN = 512,
+        SlidingDFT::Bin* slidingDFTSpace = 0);
+
+    /**
+     * Use this constructor when Log2FFT is non-zero.  The FFT buffers are
+     * contained in the demodulator and a Hann window is always used.  The
+     * trig table and window are shared with the other instances.
+     */
+    template <uint16_t L = Log2FFT, typename = std::enable_if_t<L != 0>>
+    DemodulatorT(uint16_t sampleFreq, uint16_t lowestFreq,
+        uint16_t maxSampleN = 512,
+        SlidingDFT::Bin* slidingDFTSpace = 0)
+    :   DemodulatorT(sampleFreq, lowestFreq, Log2FFT, 
+            SharedTables<Log2FFT>::fixedTrigTable(), 
+            SharedTables<Log2FFT>::hannWindow(), this->_fftResultSpace, 
+            this->_bufferSpace, maxSampleN, slidingDFTSpace) {
+    }
+
+    /**
+     * @returns The number of entries needed for the FFT result space.  The
+     *   spectral analysis uses a real-input FFT, so only the non-negative 
+     *   frequencies are kept.
+     */
+    static constexpr uint16_t fftResultSpaceSize(uint16_t log2fftN) {
+        return (1 << log2fftN) / 2 + 1;
+    }
+
+    /**
+     * @returns The number of bins needed for the sliding DFT space.  This
+     *   is an upper bound that does not depend on the lowest frequency.
+     */
+    static constexpr uint16_t slidingDFTSpaceSize(uint16_t log2fftN) {
+        return SlidingDFT::binSpaceSize(0, (1 << log2fftN) / 2 - 1);
+    }
+
+    virtual void setListener(DemodulatorListener* listener) { _listener = listener; };
+
+    /**
+     * Enables batched delivery of the per-sample metrics.  Instead of 
+     * calling sampleMetrics()/symbolTransitionDetected() on every sample 
+     * the demodulator fills the buffer and hands it to 
+     * DemodulatorListener::sampleMetricsBatch() when it is full and at 
+     * the end of each processSamples() call.
+     *
+     * NOTE: Batched metrics are delivered after any other listener events 
+     * generated by the same samples (i.e. bits, frames, characters).
+     *
+     * @param space The metrics buffer, or 0 to go back to per-sample 
+     *   delivery.  Any pending metrics are flushed first.
+     * @param size The number of entries in the buffer.
+     */
+    void setMetricsBuffer(SampleMetrics* space, uint16_t size);
+
+    /**
+     * Delivers any pending batched metrics to the listener.
+     */
+    void flushMetrics();
+
+    /**
+     * Call this depending on the mode being used.  IMPORTANT: You need
+     * to call setFrequencyLock() after this (or go through an auto-lock
+     * sequence) for this to take effect.
+     */
+    void setSymbolSpread(float spreadHz) { _symbolSpreadHz = spreadHz; };
+
+    /**
+     * Call this function at the rate defined by sampleFreq and pass the latest
+     * sample from the ADC.  Everything happens here!
+     */
+    void processSample(q15 sample);
+
+    /**
+     * Processes a block of samples (typically a DMA buffer) in one call. The 
+     * symbols and listener events produced are identical to calling 
+     * processSample() once for each sample in the block, but the buffer 
+     * bookkeeping is done once per run of samples rather than once per 
+     * sample.
+     *
+     * @param samples The samples, oldest first.
+     * @param n The number of samples in the block.  Any size is allowed.
+     */
+    void processSamples(const q15* samples, size_t n);
+
+    /**
+     * Switches the demodulator to complex (I/Q) input, which is what an SDR
+     * front end produces.  After this the samples must be passed to the 
+     * cq15 versions of processSample()/processSamples().  The buffer, 
+     * spectral analysis and matched filters all work on the complex 
+     * samples, so the negative frequencies are usable: the auto-lock 
+     * searches the whole spectrum (except for the bins closer to DC than 
+     * lowestFreq) and the mark/space can be on either side of DC.  The 
+     * magnitude of the samples must not be more than 1.0.
+     *
+     * A complex tone of amplitude A produces the same correlations as a 
+     * real tone of amplitude 2A, which should be taken into account when 
+     * setting the detection threshold.
+     *
+     * The sliding DFT is not used with complex input.  The sample 
+     * statistics (getMaxSample()/getPosCount()) and the sample reported 
+     * in the metrics are based on the I component.
+     *
+     * This resets the demodulator.
+     *
+     * @param bufferSpace Space for the complex sample buffer (the size of 
+     *   the FFT), or 0 to go back to real input.
+     * @param fftResultSpace Space for the complex FFT result (the size of
+     *   the FFT).  This is used instead of the (half size) result space 
+     *   passed to the constructor.
+     */
+    void setComplexInput(cq15* bufferSpace, cq15* fftResultSpace);
+
+    bool isComplexInput() const { return _iqBuffer != 0; }
+
+    /**
+     * The complex (I/Q) version of processSample().  See setComplexInput().
+     */
+    void processSample(cq15 sample);
+
+    /**
+     * The complex (I/Q) version of processSamples().  See setComplexInput().
+     */
+    void processSamples(const cq15* samples, size_t n);
+
+    /**
+     * Call this function to clear the frequency lock and any other internal
+     * state.
+    */
+    virtual void reset();
+
+    /**
+     * Locks the demodulator on the specified mark frequency.
+     */
+    void setFrequencyLock(float markFreqHz);
+
+    bool isFrequencyLocked() const { return _frequencyLocked; }
+
+    void setAutoLockEnabled(bool en) { _autoLockEnabled = en; }
+
+    /**
+     * Selects the matched filter engine used by the quadrature demodulator.
+     * The default recomputes the complete correlation with each symbol tone 
+     * on every sample.  When enabled, the correlations are maintained 
+     * incrementally in fixed point (see SlidingCorrelator), which avoids 
+     * the per-tap work and the floating point.  The correlations agree to 
+     * within 16 q15 LSBs.
+     */
+    void setIncrementalCorrelationEnabled(bool en) { 
+        _useIncrementalCorrelation = en; 
+        _correlatorPrimed = false;
+    }
+
+    /**
+     * Selects a fixed-point (q15 coefficients, q31 accumulator) version of 
+     * the low-pass filter that is applied to the symbol correlations.  The
+     * default runs the filter in floating point.  This clears the 
+     * correlation history.
+     */
+    void setFixedPointFilterEnabled(bool en) {
+        _useFixedPointFilter = en;
+        _clearCorrelationHistory();
+    }
+
+    /**
+     * Runs the spectral analysis with the block-floating-point FFT (see 
+     * FixedFFT::transformBFP()), which only scales the FFT stages when 
+     * needed.  The power measurements keep the same scale, but weak 
+     * signals are measured far more accurately.  This makes it possible 
+     * to lower the bin power threshold, or to get the same sensitivity 
+     * from a smaller FFT.  This has no effect on the sliding DFT.
+     */
+    void setBlockFloatingPointEnabled(bool en) { _blockFloatingPoint = en; }
+
+    /**
+     * Limits the spectral analysis to the bins that are actually used.
+     * While locked that is just the bins around the locked symbol 
+     * frequencies (see setLockedAnalysisInterval()) and DC, which are 
+     * evaluated directly (see BandDFT) rather than running the full FFT.
+     * The auto-lock search still needs the whole spectrum.  This has no
+     * effect on the sliding DFT or complex input.
+     */
+    void setBandAnalysisEnabled(bool en) { _bandAnalysis = en; }
+
+    /**
+     * Runs the spectral analysis with a q31 FFT.  The windowing and the 
+     * FFT are done with 32-bit data, and the result is scaled to fit the 
+     * q15 spectrum (like the block-floating-point FFT), so weak signals 
+     * get close to the dynamic range of a floating-point FFT without 
+     * needing an FPU.  This takes precedence over the block-floating-point 
+     * and band analysis and has no effect on the sliding DFT or complex 
+     * input.
+     *
+     * @param fft A FixedFFT31 of the same size as the spectral analysis,
+     *   or 0 to go back to the q15 FFT.
+     * @param fftResultSpace Space for the q31 FFT.  Must have room for 
+     *   fftResultSpaceSize() entries.
+     */
+    void setFFT31(const FixedFFT31* fft, cq31* fftResultSpace) {
+        _fft31 = fft;
+        _fft31Result = fftResultSpace;
+    }
+
+    /**
+     * @param th The power (within the peak bin and its two neighbors) 
+     *   needed for the auto-lock and the locked signal check.  The 
+     *   default is 5.0e-4.
+     */
+    void setBinPowerThreshold(float th) { _binPowerThreshold = th; }
+
+    /**
+     * Runs the symbol correlation and low-pass filter at a reduced rate. 
+     * The correlations are only computed on every Dth sample and are 
+     * filtered with an LPF designed for the decimated rate.  The symbol 
+     * decision is held in between, so _processSymbol() (i.e. clock 
+     * recovery) still runs at the full sample rate.  This clears the 
+     * correlation history.
+     *
+     * @param factor The decimation factor D.  1 (the default) means no 
+     *   decimation.
+     */
+    void setDecimation(uint16_t factor);
+
+    /**
+     * Controls the spectral analysis while the demodulator is frequency 
+     * locked.  Nothing in the demodulator needs the spectrum while it is 
+     * locked, so this can be used to save a lot of CPU.  
+     *
+     * @param blockInterval 1 means that the analysis runs on every block 
+     *   (the default), n means that the analysis runs on every nth block, and 
+     *   0 means that the analysis is skipped completely while locked.
+     * @param signalLossLimit If non-zero, each analysis that is run while 
+     *   locked checks for power near the locked symbol frequencies.  After 
+     *   this many consecutive misses the demodulator is reset(), which 
+     *   allows the auto-lock to find a new signal.
+     */
+    void setLockedAnalysis(uint16_t blockInterval, uint16_t signalLossLimit = 0);
+
+    float getMarkFreq() const;
+
+    float getLastDCPower() const { return _lastDCPower; };
+
+    /**
+     * This is a statistical function that is useful for tuning the receiver
+     * gain.
+     * 
+     * @return The maximum sample value seen over the window defined by the  
+     *   maxSampleN parameter passed to the constructor.
+     */    
+    q15 getMaxSample() const { return _maxSample; }
+
+    /**
+     * This is a statistical function that is useful for tuning the receiver
+     * DC bias and gain.
+     * 
+     * @return The number of above zero samples seen over the window defined by the  
+     *   maxSampleN parameter passed to the constructor.
+     */    
+    uint16_t getPosCount() const { return _posCount; }
+
+    /**
+     * Sets the threshold value that determines whether a symbol is being 
+     * heard vs noise.
+    */
+    void setDetectionCorrelationThreshold(float t) {
+        _detectionCorrelationThreshold = t;
+    }
+
+    float getDetectionCorrelationThreshold() const { return _detectionCorrelationThreshold; }
+
+protected:
+
+    /**
+     * This is called on every sample and indicates which symbol (if any) has been
+     * detected.
+     */
+    virtual void _processSymbol(bool symbolValid, uint8_t symbol) = 0;
+
+    DemodulatorListener* _listener;
+
+private: 
+
+    // Used for batched metrics delivery
+    SampleMetrics* _metrics = 0;
+    uint16_t _metricsSize = 0;
+    uint16_t _metricsCount = 0;
+    // Set when a transition is detected on the current sample
+    bool _transitionPending = false;
+
+    void _clearCorrelationHistory();
+
+    /**
+     * Updates the max sample/positive count statistics.
+     */
+    void _trackSamples(const q15* samples, uint16_t n);
+
+    /**
+     * Runs the spectral analysis/auto-lock logic.  Called each time a 
+     * block has been completed.
+     *
+     * @param readBufferPtr The buffer location of the most recent sample.
+     */
+    void _analyzeBlock(uint16_t readBufferPtr);
+
+    /**
+     * Runs the quadrature demodulator for one sample.  Only called when
+     * frequency locked.
+     *
+     * @param readBufferPtr The buffer location of the sample.
+     */
+    template <typename S>
+    void _demodulate(S sample, uint16_t readBufferPtr);
+
+    /**
+     * Computes the symbol correlations, filters them, and looks for 
+     * symbol transitions.  The result is left in _filteredSymbolCorr.
+     */
+    template <typename S>
+    void _filterSymbolCorr(S sample, uint16_t demodulatorStart);
+
+    /**
+     * Runs the FFT on the complex buffer.
+     */
+    void _transformComplex(uint16_t readBufferPtr);
+
+    /**
+     * Builds the LPF coefficients for the current decimation factor.
+     */
+    void _buildFilter();
+
+    /**
+     * Used to stop/start the sliding DFT updates while locked.  The 
+     * sliding DFT is resynchronized with the buffer when it is restarted.
+     */
+    void _setSlidingDFTSuspended(bool suspended);
+
+    /**
+     * @returns true if there is still power near one of the locked 
+     *   symbol frequencies in the most recent spectral analysis.
+     */
+    bool _isLockedSignalPresent() const;
+
+    /**
+     * @returns The power in the bin and its two neighbors (only counting 
+     *   the bins that are being searched).
+     */
+    float _binPower(int32_t bin) const;
+
+    /**
+     * @returns The power in a bin of the most recent spectrum, on the 
+     *   DFT / N scale.
+     */
+    float _binMagSquared(uint16_t bin) const { 
+        return _fftResult[bin].mag_f32_squared() * _fftPowerScale;
+    }
+
+    /**
+     * Picks the bins that the next real-input spectral analysis needs to
+     * compute.
+     */
+    void _updateBand();
+
+    /**
+     * The real-input spectral analysis using the q31 FFT.
+     *
+     * @param readBufferPtr The buffer location of the most recent sample.
+     * @param avg The value being removed from every sample (DC).
+     */
+    void _transformReal31(uint16_t readBufferPtr, q15 avg);
+
+    /**
+     * Records the exponent of the most recent block-floating-point FFT 
+     * (i.e. the spectrum is DFT / 2^exponent).
+     */
+    void _setFFTExponent(int exponent) {
+        _fftPowerScale = std::ldexp(1.0f, 2 * (exponent - (int)_log2fftN()));
+    }
+
+    /**
+     * @returns The end (exclusive) of the bins searched by the auto-lock.
+     *   For complex input this includes the negative frequencies, which 
+     *   are in the top half of the FFT.
+     */
+    uint16_t _searchEndBin() const { 
+        return (_iqBuffer == 0) ? _fftN() / 2 : 
+            ((_firstBin == 0) ? _fftN() : _fftN() - _firstBin + 1);
+    }
+
+    float _binToFreq(uint16_t bin) const {
+        const int32_t signedBin = (bin < _fftN() / 2) ? bin : (int32_t)bin - _fftN();
+        return (float)signedBin * (float)_sampleFreq / (float)_fftN();
+    }
+
+    // The sample reported in the metrics
+    static q15 _metricsSample(q15 sample) { return sample; }
+    static q15 _metricsSample(cq15 sample) { return sample.r; }
+
+    // The FFT size is a compile-time constant unless Log2FFT is zero
+    uint16_t _log2fftN() const { return (Log2FFT != 0) ? Log2FFT : _runtimeLog2fftN; }
+    uint16_t _fftN() const { return 1 << _log2fftN(); }
+
+    const uint16_t _sampleFreq;
+    const uint16_t _runtimeLog2fftN;
+    // This is the first bin that we pay attention to
+    uint16_t _firstBin;
+    // Optional window passed in by user
+    const q15* _fftWindow;
+    cq15* _fftResult;
+    // The space passed to the constructor (for real input)
+    cq15* const _realFftResult;
+    FixedFFT _fft;
+    // Computes the bins needed by the spectral analysis (see _updateBand())
+    BandDFT _bandDFT;
+    // The optional q31 FFT (see setFFT31())
+    const FixedFFT31* _fft31 = 0;
+    cq31* _fft31Result = 0;
+    // Used as an alternative to the FFT (if space is provided)
+    SlidingDFT _slidingDFT;
+    const bool _useSlidingDFT;
+    bool _slidingDFTSuspended = false;
+  
+    // FFT is performed every time this number of samples is collected
+    static const uint16_t _blockSize = BlockSize;
+    // This is the approximate symbol rate for SCAMP FSK.  This is used
+    // only to estimate the length of the "long mark"    
+    static const unsigned int _samplesPerSymbol = SamplesPerSymbol;
+    // Calculate the duration of the block in seconds
+    const float _blockDuration = (float)_blockSize / (float)_sampleFreq;
+    // Calculate the symbol duration in seconds
+    const float _symbolDuration = (float)_samplesPerSymbol / (float)_sampleFreq;
+    // Calculate the duration of the "long mark"
+    const float _longMarkDuration = 24.0 * _symbolDuration;
+    // Calculate the number of blocks that make up the long mark and
+    // round down.  We give this a slight haircut to improve robustness.
+    const uint16_t _longMarkBlocks = ((_longMarkDuration / _blockDuration) * 0.70);
+
+    // Controls whether auto-lock is enabled
+    bool _autoLockEnabled = true;
+
+    // The distance between the two symbols in positive HZ. The
+    // default here is relevant to the SCAMP FSK mode.
+    float _symbolSpreadHz = 66.6666666666;
+
+    uint32_t _sampleCount = 0;
+
+    // Here's where we put the recent sample history in order to build
+    // up enough to run the spectral analysis.
+    uint16_t _bufferPtr = 0;
+    q15* _buffer; 
+    // Used instead of _buffer for complex input
+    cq15* _iqBuffer = 0;
+    // The total of the samples in the buffer. This is only maintained
+    // in sliding DFT mode.
+    int32_t _bufferTotal = 0;
+
+    float _lastDCPower = 0;
+
+    // This is where we store the recent history of the loudest bin 
+    const uint16_t _maxBinHistorySize = 64;
+    //const uint16_t _maxBinHistoryBins = 4;
+    uint16_t _maxBinHistory[64];
+    // The power threshold used for detecting a valid signal
+    // Power of 0.002 was measured with Vpp = 1.5v
+    float _binPowerThreshold = 5.0e-4;
+
+    // Indicates whether the demodulator is locked onto a specific frequency
+    // or whether it is in frequency acquisition mode.
+    bool _frequencyLocked = false;
+
+    // The frequency that has been selected to represent "mark"
+    float _lockedMarkFreq = 0;
+
+    uint16_t _blockCount = 0;
+
+    // Controls the spectral analysis while locked
+    uint16_t _lockedAnalysisInterval = 1;
+    uint16_t _lockedBlockCount = 0;
+    uint16_t _signalLossLimit = 0;
+    uint16_t _signalLossCount = 0;
+    uint8_t _activeSymbol = 0;
+
+    // These buffers are loaded based on the frequency that the decoder
+    // decides to lock onto. The signal is convolved with these tones
+    // for demodulation.
+    static const uint16_t _symbolCount = SYMBOL_COUNT;
+    static const uint16_t _demodulatorToneN = ToneN;
+    static const uint16_t _log2DemodulatorToneN = log2_u16(ToneN);
+    cq15 _demodulatorTone[_symbolCount][_demodulatorToneN];
+
+    // Used as an alternative to the full correlation with the tones above
+    SlidingCorrelator::Product _correlatorHistory[_symbolCount][_demodulatorToneN];
+    SlidingCorrelator _correlator[_symbolCount];
+    bool _useIncrementalCorrelation = false;
+    // The correlators are loaded from the buffer on the first sample 
+    // after the lock.
+    bool _correlatorPrimed = false;
+
+    // The LPF coefficients in use (depends on the decimation)
+    static const uint16_t _lpfN = h_lpf_33_size;
+    uint16_t _lpfTaps = _lpfN;
+    float _lpfF32[_lpfN];
+
+    // The recent correlation history for each symbol and the LPF that 
+    // runs over it.
+    float _symbolCorr[_symbolCount][FirFilter<f32>::historySpaceSize(_lpfN)];
+    FirFilter<f32> _symbolLPF[_symbolCount];
+
+    // The fixed-point version of the correlation history/LPF
+    bool _useFixedPointFilter = false;
+    bool _blockFloatingPoint = false;
+    bool _bandAnalysis = false;
+    // Converts the squared magnitudes of the most recent spectrum to the
+    // DFT / N scale (used by the block-floating-point FFT)
+    float _fftPowerScale = 1.0f;
+    q15 _lpfQ15[_lpfN / 2 + 1];
+    q15 _symbolCorrQ15[_symbolCount][FirFilter<q15>::historySpaceSize(_lpfN)];
+    FirFilter<q15> _symbolLPFQ15[_symbolCount];
+
+    // Controls the decimation of the correlation/LPF
+    uint16_t _decimation = 1;
+    uint16_t _decimationCount = 0;
+    // The most recent filtered correlations.  These are held between 
+    // decimated samples.
+    float _filteredSymbolCorr[_symbolCount];
+
+    static_assert((ToneN & (ToneN - 1)) == 0, "ToneN must be a power of two");
+    static_assert(Log2FFT == 0 || ((1 << Log2FFT) % BlockSize) == 0, 
+        "BlockSize must divide the FFT size");
+
+    float _detectionCorrelationThreshold = 0;
+    float _lastCorrDiff = 0;
+
+    const uint16_t _maxSampleN;
+    uint16_t _maxSampleCtr = 0;
+    q15 _maxSampleAcc = 0;
+    q15 _maxSample = 0;
+    // Used to keep track of the number of samples above zero.
+    // This is helpful for adjusting DC bias.
+    int16_t _posCountAcc = 0;
+    int16_t _posCount = 0;
+};
+
+}
+
+#endif
@@ -0,0 +1,911 @@
+/*
+Copyright (C) 2024 - Bruce MacKinnon KC1FSZ
+
+This program is free software: you can redistribute it and/or modify it under 
+the terms of the GNU General Public License as published by the Free 
+Software Foundation, either version 3 of the License, or (at your option) any 
+later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT 
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS 
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with 
+this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef _DemodulatorTImpl_h
+#define _DemodulatorTImpl_h
+
+#include "DemodulatorT.h"
+
+namespace radlib {
+
+template <uint16_t Log2FFT, uint16_t BlockSize, uint16_t ToneN, uint16_t SamplesPerSymbol, 
+    bool MetricsEnabled>
+DemodulatorT<Log2FFT, BlockSize, ToneN, SamplesPerSymbol, MetricsEnabled>::DemodulatorT(uint16_t sampleFreq, uint16_t lowestFreq, uint16_t log2fftN,
+    q15* fftTrigTableSpace, q15* fftWindowSpace,
+    cq15* fftResultSpace, q15* bufferSpace, uint16_t maxSampleN,
+    SlidingDFT::Bin* slidingDFTSpace)
+:   DemodulatorT(sampleFreq, lowestFreq, log2fftN,
+        FixedFFT::makeTrigTable(1 << log2fftN, fftTrigTableSpace),
+        // Build the Hann window for the FFT (raised cosine) if a space has 
+        // been provided for it.
+        make_hann_window_q15(fftWindowSpace, 1 << log2fftN),
+        fftResultSpace, bufferSpace, maxSampleN, slidingDFTSpace) {
+}
+
+template <uint16_t Log2FFT, uint16_t BlockSize, uint16_t ToneN, uint16_t SamplesPerSymbol, 
+    bool MetricsEnabled>
+DemodulatorT<Log2FFT, BlockSize, ToneN, SamplesPerSymbol, MetricsEnabled>::DemodulatorT(uint16_t sampleFreq, uint16_t lowestFreq, uint16_t log2fftN,
+    const q15* fftTrigTable, const q15* fftWindow,
+    cq15* fftResultSpace, q15* bufferSpace, uint16_t maxSampleN,
+    SlidingDFT::Bin* slidingDFTSpace)
+:   _sampleFreq(sampleFreq),
+    _runtimeLog2fftN(log2fftN),
+    _firstBin((_fftN() * lowestFreq) / sampleFreq),
+    _fftWindow(fftWindow),
+    _fftResult(fftResultSpace),
+    _realFftResult(fftResultSpace),
+    _fft(_fftN(), fftTrigTable),
+    _bandDFT(_fft),
+    // Bins are computed starting one below the first bin since the auto-lock
+    // looks at the neighbors of the loudest bin.
+    _slidingDFT(_log2fftN(), (_firstBin > 0) ? _firstBin - 1 : 0, _fftN() / 2 - 1, 
+        fftTrigTable, slidingDFTSpace),
+    _useSlidingDFT(slidingDFTSpace != 0),
+    _buffer(bufferSpace),
+    _correlator { 
+        SlidingCorrelator(_log2DemodulatorToneN, _log2fftN(), fftTrigTable, _correlatorHistory[0]),
+        SlidingCorrelator(_log2DemodulatorToneN, _log2fftN(), fftTrigTable, _correlatorHistory[1]) 
+    },
+    // The real taps are set by _buildFilter()
+    _symbolLPF {
+        FirFilter<f32>(_lpfF32, _lpfN, false, _symbolCorr[0]),
+        FirFilter<f32>(_lpfF32, _lpfN, false, _symbolCorr[1])
+    },
+    _symbolLPFQ15 {
+        FirFilter<q15>(_lpfQ15, _lpfN, true, _symbolCorrQ15[0]),
+        FirFilter<q15>(_lpfQ15, _lpfN, true, _symbolCorrQ15[1])
+    },
+    _maxSampleN(maxSampleN),
+    _maxSampleAcc(0),
+    _maxSample(0),
+    _posCountAcc(0),
+    _posCount(0) { 
+
+    // NOTE: The sliding DFT (if used) starts off consistent with an 
+    // all-zero buffer.
+    memset((void*)_buffer, 0, _fftN() * sizeof(q15));
+    memset((void*)_maxBinHistory, 0, sizeof(_maxBinHistory));
+    memset((void*)_demodulatorTone, 0, sizeof(_demodulatorTone));
+
+    _buildFilter();
+
+    _clearCorrelationHistory();
+}
+
+template <uint16_t Log2FFT, uint16_t BlockSize, uint16_t ToneN, uint16_t SamplesPerSymbol, 
+    bool MetricsEnabled>
+void DemodulatorT<Log2FFT, BlockSize, ToneN, SamplesPerSymbol, MetricsEnabled>::_clearCorrelationHistory() {
+    for (uint16_t s = 0; s < _symbolCount; s++) {
+        _symbolLPF[s].reset();
+        _symbolLPFQ15[s].reset();
+    }
+    _decimationCount = 0;
+    for (uint16_t s = 0; s < _symbolCount; s++)
+        _filteredSymbolCorr[s] = 0;
+}
+
+template <uint16_t Log2FFT, uint16_t BlockSize, uint16_t ToneN, uint16_t SamplesPerSymbol, 
+    bool MetricsEnabled>
+void DemodulatorT<Log2FFT, BlockSize, ToneN, SamplesPerSymbol, MetricsEnabled>::setDecimation(uint16_t factor) {
+    _decimation = (factor == 0) ? 1 : factor;
+    _buildFilter();
+    _clearCorrelationHistory();
+}
+
+template <uint16_t Log2FFT, uint16_t BlockSize, uint16_t ToneN, uint16_t SamplesPerSymbol, 
+    bool MetricsEnabled>
+void DemodulatorT<Log2FFT, BlockSize, ToneN, SamplesPerSymbol, MetricsEnabled>::_buildFilter() {
+
+    // The full-rate filter is h_lpf_33 exactly as designed.  When 
+    // decimating, the correlations are only seen every Dth sample, so a 
+    // filter is designed for the decimated rate with the same cut-off (33 Hz 
+    // at 2 kHz, i.e. D times higher relative to the new rate) and the same 
+    // time span.  Like h_lpf_33 this is a Blackman-windowed sinc.  The 
+    // window is stretched by one tap on each side so that the short 
+    // filters don't waste their end taps on zeros.  There is no separate 
+    // anti-aliasing filter ahead of the decimation: the ToneN-sample 
+    // correlation window already smooths the correlations.
+    const uint16_t center = h_lpf_33_size / 2;
+    const uint16_t side = center / _decimation;
+    _lpfTaps = 2 * side + 1;
+
+    if (_decimation == 1) {
+        for (uint16_t i = 0; i < _lpfTaps; i++) {
+            _lpfF32[i] = h_lpf_33[i];
+        }
+    } else {
+        const float fc = (33.0f / 2000.0f) * (float)_decimation;
+        float total = 0;
+        for (uint16_t i = 0; i < _lpfTaps; i++) {
+            const float t = (float)i - (float)side;
+            const float x = 2.0f * fc * t;
+            const float sinc = (t == 0) ? 1.0f : std::sin(pi() * x) / (pi() * x);
+            const float a = 2.0f * pi() * (float)(i + 1) / (float)(_lpfTaps + 1);
+            _lpfF32[i] = sinc * (0.42f - 0.5f * std::cos(a) + 0.08f * std::cos(2.0f * a));
+            total += _lpfF32[i];
+        }
+        // Unity gain
+        for (uint16_t i = 0; i < _lpfTaps; i++) {
+            _lpfF32[i] /= total;
+        }
+    }
+
+    // Build the q15 version of the LPF.  Only the first half (plus the 
+    // center tap) is needed since the filter is symmetric.  The values are
+    // rounded since they are all small.
+    for (uint16_t i = 0; i <= _lpfTaps / 2; i++) {
+        _lpfQ15[i] = (q15)(_lpfF32[i] * 32768.0f + 0.5f);
+    }
+
+    // The float filter doesn't use the symmetry so that the result is 
+    // the same as the plain convolution.  The correlations are magnitudes 
+    // (<= 0.5), so the fixed-point sums can't overflow.
+    for (uint16_t s = 0; s < _symbolCount; s++) {
+        _symbolLPF[s].setCoefficients(_lpfF32, _lpfTaps, false);
+        _symbolLPFQ15[s].setCoefficients(_lpfQ15, _lpfTaps, true);
+    }
+}
+
+template <uint16_t Log2FFT, uint16_t BlockSize, uint16_t ToneN, uint16_t SamplesPerSymbol, 
+    bool MetricsEnabled>
+void DemodulatorT<Log2FFT, BlockSize, ToneN, SamplesPerSymbol, MetricsEnabled>::setFrequencyLock(float lockedMarkHz) {
+
+    _frequencyLocked = true;
+    _lockedMarkFreq = lockedMarkHz;
+
+    // NOTE: These tones are scaled by 0.5 to avoid overflow issues
+    make_complex_tone_cq15(_demodulatorTone[0], _demodulatorToneN, 
+        _sampleFreq, lockedMarkHz - _symbolSpreadHz, 0.5);
+    make_complex_tone_cq15(_demodulatorTone[1], _demodulatorToneN, 
+        _sampleFreq, lockedMarkHz, 0.5);
+    _correlator[0].setTone(_sampleFreq, lockedMarkHz - _symbolSpreadHz);
+    _correlator[1].setTone(_sampleFreq, lockedMarkHz);
+    _correlatorPrimed = false;
+
+    _lockedBlockCount = 0;
+    _signalLossCount = 0;
+    // The sliding DFT doesn't need to be kept up to date if the analysis 
+    // isn't running on every block
+    if (_useSlidingDFT && _lockedAnalysisInterval != 1) {
+        _setSlidingDFTSuspended(true);
+    }
+
+    if (_iqBuffer != 0) {
+        _listener->frequencyLockedSigned((int16_t)lockedMarkHz, 
+            (int16_t)(lockedMarkHz - _symbolSpreadHz));
+    } else {
+        _listener->frequencyLocked(lockedMarkHz, lockedMarkHz - _symbolSpreadHz);                    
+    }
+}
+
+template <uint16_t Log2FFT, uint16_t BlockSize, uint16_t ToneN, uint16_t SamplesPerSymbol, 
+    bool MetricsEnabled>
+void DemodulatorT<Log2FFT, BlockSize, ToneN, SamplesPerSymbol, MetricsEnabled>::setLockedAnalysis(uint16_t blockInterval, uint16_t signalLossLimit) {
+    _lockedAnalysisInterval = blockInterval;
+    _signalLossLimit = signalLossLimit;
+    _lockedBlockCount = 0;
+    _signalLossCount = 0;
+    if (_useSlidingDFT && _frequencyLocked) {
+        _setSlidingDFTSuspended(_lockedAnalysisInterval != 1);
+    }
+}
+
+template <uint16_t Log2FFT, uint16_t BlockSize, uint16_t ToneN, uint16_t SamplesPerSymbol, 
+    bool MetricsEnabled>
+void DemodulatorT<Log2FFT, BlockSize, ToneN, SamplesPerSymbol, MetricsEnabled>::_setSlidingDFTSuspended(bool suspended) {
+    if (_slidingDFTSuspended && !suspended) {
+        // Catch up on what was missed
+        _slidingDFT.resync(_buffer);
+        _bufferTotal = 0;
+        for (uint16_t i = 0; i < _fftN(); i++) {
+            _bufferTotal += _buffer[i];
+        }
+    }
+    _slidingDFTSuspended = suspended;
+}
+
+template <uint16_t Log2FFT, uint16_t BlockSize, uint16_t ToneN, uint16_t SamplesPerSymbol, 
+    bool MetricsEnabled>
+void DemodulatorT<Log2FFT, BlockSize, ToneN, SamplesPerSymbol, MetricsEnabled>::reset() {
+    _frequencyLocked = false;
+    _setSlidingDFTSuspended(false);
+    _clearCorrelationHistory();
+    _maxSample = 0;
+    _maxSampleAcc = 0;
+    _posCountAcc = 0;
+    _posCount = 0;
+}
+
+template <uint16_t Log2FFT, uint16_t BlockSize, uint16_t ToneN, uint16_t SamplesPerSymbol, 
+    bool MetricsEnabled>
+void DemodulatorT<Log2FFT, BlockSize, ToneN, SamplesPerSymbol, MetricsEnabled>::processSample(q15 sample) {
+
+    // Keep the sliding DFT up to date with the buffer changes
+    if (_useSlidingDFT && !_slidingDFTSuspended) {
+        _slidingDFT.update(sample, _buffer[_bufferPtr], _bufferPtr);
+        _bufferTotal += sample - _buffer[_bufferPtr];
+    }
+
+    // Capture the sample in the circular buffer            
+    _buffer[_bufferPtr] = sample;
+    // Remember where the reading starts
+    const uint16_t readBufferPtr = _bufferPtr;
+    // Increment the write pointer and wrap if needed
+    if (++_bufferPtr == _fftN()) {
+        _bufferPtr = 0;
+    }
+    _sampleCount++;
+
+    _trackSamples(&sample, 1);
+
+    // Did we just finish a new block?  If so, run the FFT
+    if (_bufferPtr % _blockSize == 0) {
+        _analyzeBlock(readBufferPtr);
+    }
+
+    if (_frequencyLocked) {
+        _demodulate(sample, readBufferPtr);
+    }
+}
+
+template <uint16_t Log2FFT, uint16_t BlockSize, uint16_t ToneN, uint16_t SamplesPerSymbol, 
+    bool MetricsEnabled>
+void DemodulatorT<Log2FFT, BlockSize, ToneN, SamplesPerSymbol, MetricsEnabled>::processSamples(const q15* samples, size_t n) {
+
+    while (n > 0) {
+
+        // Work in runs that end no later than the next block boundary (or 
+        // the end of the circular buffer).  This guarantees that the spectral 
+        // analysis sees exactly the same buffer contents that it would see 
+        // in the sample-by-sample case.
+        uint16_t run = _blockSize - (_bufferPtr % _blockSize);
+        if (run > _fftN() - _bufferPtr) {
+            run = _fftN() - _bufferPtr;
+        }
+        if (run > n) {
+            run = n;
+        }
+
+        // Capture the whole run in the circular buffer at once.  This is 
+        // safe because the demodulator only looks backwards from the sample 
+        // being processed.
+        const uint16_t runStart = _bufferPtr;
+        if (_useSlidingDFT && !_slidingDFTSuspended) {
+            for (uint16_t i = 0; i < run; i++) {
+                _slidingDFT.update(samples[i], _buffer[runStart + i], runStart + i);
+                _bufferTotal += samples[i] - _buffer[runStart + i];
+            }
+        }
+        memcpy((void*)(_buffer + runStart), (const void*)samples, run * sizeof(q15));
+        _bufferPtr += run;
+        if (_bufferPtr == _fftN()) {
+            _bufferPtr = 0;
+        }
+        _sampleCount += run;
+
+        _trackSamples(samples, run);
+
+        // If this run completes a block then the last sample needs to be 
+        // demodulated after the spectral analysis (which may change the lock).
+        const bool blockComplete = (_bufferPtr % _blockSize == 0);
+        const uint16_t preRun = blockComplete ? run - 1 : run;
+
+        for (uint16_t i = 0; i < preRun; i++) {
+            if (_frequencyLocked) {
+                _demodulate(samples[i], runStart + i);
+            }
+        }
+
+        if (blockComplete) {
+            const uint16_t readBufferPtr = runStart + run - 1;
+            _analyzeBlock(readBufferPtr);
+            if (_frequencyLocked) {
+                _demodulate(samples[run - 1], readBufferPtr);
+            }
+        }
+
+        samples += run;
+        n -= run;
+    }
+
+    flushMetrics();
+}
+
+template <uint16_t Log2FFT, uint16_t BlockSize, uint16_t ToneN, uint16_t SamplesPerSymbol, 
+    bool MetricsEnabled>
+void DemodulatorT<Log2FFT, BlockSize, ToneN, SamplesPerSymbol, MetricsEnabled>::setComplexInput(cq15* bufferSpace, cq15* fftResultSpace) {
+    _iqBuffer = bufferSpace;
+    if (_iqBuffer != 0) {
+        memset((void*)_iqBuffer, 0, _fftN() * sizeof(cq15));
+        _fftResult = fftResultSpace;
+    } else {
+        _fftResult = _realFftResult;
+    }
+    _correlatorPrimed = false;
+    reset();
+}
+
+template <uint16_t Log2FFT, uint16_t BlockSize, uint16_t ToneN, uint16_t SamplesPerSymbol, 
+    bool MetricsEnabled>
+void DemodulatorT<Log2FFT, BlockSize, ToneN, SamplesPerSymbol, MetricsEnabled>::processSample(cq15 sample) {
+
+    // Same as the real version, except that there's no sliding DFT
+    _iqBuffer[_bufferPtr] = sample;
+    const uint16_t readBufferPtr = _bufferPtr;
+    if (++_bufferPtr == _fftN()) {
+        _bufferPtr = 0;
+    }
+    _sampleCount++;
+
+    _trackSamples(&sample.r, 1);
+
+    if (_bufferPtr % _blockSize == 0) {
+        _analyzeBlock(readBufferPtr);
+    }
+
+    if (_frequencyLocked) {
+        _demodulate(sample, readBufferPtr);
+    }
+}
+
+template <uint16_t Log2FFT, uint16_t BlockSize, uint16_t ToneN, uint16_t SamplesPerSymbol, 
+    bool MetricsEnabled>
+void DemodulatorT<Log2FFT, BlockSize, ToneN, SamplesPerSymbol, MetricsEnabled>::processSamples(const cq15* samples, size_t n) {
+
+    // See the real version for the details
+    while (n > 0) {
+
+        uint16_t run = _blockSize - (_bufferPtr % _blockSize);
+        if (run > _fftN() - _bufferPtr) {
+            run = _fftN() - _bufferPtr;
+        }
+        if (run > n) {
+            run = n;
+        }
+
+        const uint16_t runStart = _bufferPtr;
+        memcpy((void*)(_iqBuffer + runStart), (const void*)samples, run * sizeof(cq15));
+        _bufferPtr += run;
+        if (_bufferPtr == _fftN()) {
+            _bufferPtr = 0;
+        }
+        _sampleCount += run;
+
+        for (uint16_t i = 0; i < run; i++) {
+            _trackSamples(&samples[i].r, 1);
+        }
+
+        const bool blockComplete = (_bufferPtr % _blockSize == 0);
+        const uint16_t preRun = blockComplete ? run - 1 : run;
+
+        for (uint16_t i = 0; i < preRun; i++) {
+            if (_frequencyLocked) {
+                _demodulate(samples[i], runStart + i);
+            }
+        }
+
+        if (blockComplete) {
+            const uint16_t readBufferPtr = runStart + run - 1;
+            _analyzeBlock(readBufferPtr);
+            if (_frequencyLocked) {
+                _demodulate(samples[run - 1], readBufferPtr);
+            }
+        }
+
+        samples += run;
+        n -= run;
+    }
+
+    flushMetrics();
+}
+
+template <uint16_t Log2FFT, uint16_t BlockSize, uint16_t ToneN, uint16_t SamplesPerSymbol, 
+    bool MetricsEnabled>
+void DemodulatorT<Log2FFT, BlockSize, ToneN, SamplesPerSymbol, MetricsEnabled>::setMetricsBuffer(SampleMetrics* space, uint16_t size) {
+    flushMetrics();
+    _metrics = size > 0 ? space : 0;
+    _metricsSize = size;
+    _transitionPending = false;
+}
+
+template <uint16_t Log2FFT, uint16_t BlockSize, uint16_t ToneN, uint16_t SamplesPerSymbol, 
+    bool MetricsEnabled>
+void DemodulatorT<Log2FFT, BlockSize, ToneN, SamplesPerSymbol, MetricsEnabled>::flushMetrics() {
+    if (_metricsCount > 0) {
+        _listener->sampleMetricsBatch(_metrics, _metricsCount);
+        _metricsCount = 0;
+    }
+}
+
+template <uint16_t Log2FFT, uint16_t BlockSize, uint16_t ToneN, uint16_t SamplesPerSymbol, 
+    bool MetricsEnabled>
+void DemodulatorT<Log2FFT, BlockSize, ToneN, SamplesPerSymbol, MetricsEnabled>::_trackSamples(const q15* samples, uint16_t n) {
+    for (uint16_t i = 0; i < n; i++) {
+        const q15 sample = samples[i];
+        // Deal with the max sample tracker
+        if (sample >= _maxSampleAcc) {
+            _maxSampleAcc = sample;
+        }
+        // Deal with the positive sample tracker
+        if (sample > 0) {
+            _posCountAcc += 1;
+        } else if (sample < 0) {
+            _posCountAcc -= 1;
+        }
+        // Resets
+        if (++_maxSampleCtr == _maxSampleN) {
+            _maxSample = _maxSampleAcc;
+            _maxSampleAcc = 0;
+            _posCount = _posCountAcc;
+            _posCountAcc = 0;
+            _maxSampleCtr = 0;
+        }
+    }
+}
+
+template <uint16_t Log2FFT, uint16_t BlockSize, uint16_t ToneN, uint16_t SamplesPerSymbol, 
+    bool MetricsEnabled>
+void DemodulatorT<Log2FFT, BlockSize, ToneN, SamplesPerSymbol, MetricsEnabled>::_analyzeBlock(uint16_t readBufferPtr) {
+        
+    _blockCount++;
+
+    // While locked the analysis is only run as often as requested
+    if (_frequencyLocked) {
+        if (_lockedAnalysisInterval == 0) {
+            return;
+        }
+        if (++_lockedBlockCount < _lockedAnalysisInterval) {
+            return;
+        }
+        _lockedBlockCount = 0;
+    }
+
+    if (_iqBuffer != 0) {
+
+        _transformComplex(readBufferPtr);
+
+    } else if (_useSlidingDFT && !_slidingDFTSuspended) {
+
+        // The sliding DFT has been kept up to date on every sample, so 
+        // all that is needed is to read out the bins of interest (applying 
+        // the window as needed).  The mean is not removed since it only 
+        // impacts the bins that are ignored.
+        _slidingDFT.getSpectrum(_fftResult, readBufferPtr, _fftWindow != 0);
+        _fftPowerScale = 1.0f;
+
+        // Capture DC magnitude for diagnostics. This is the part of 
+        // the DC that would be left after removing the (truncated) average.
+        const q15 avg = _bufferTotal >> _log2fftN();
+        const float dc = 0.5f * ((float)(_bufferTotal - ((int32_t)avg << _log2fftN())) / 
+            (32768.0f * (float)_fftN()));
+        _lastDCPower = dc * dc;
+
+    } else {
+
+        // Compute the average across the FFT buffer for the purposes of DC
+        // bias removal
+        q15 avg = mean_q15(_buffer, _log2fftN());
+
+        if (_fft31 != 0) {
+            _transformReal31(readBufferPtr, avg);
+        } else {
+
+            // Do the FFT in the result buffer, including the window
+            load_real_fft_q15(_fftResult, _buffer, readBufferPtr, _fftN(), 
+                avg, _fftWindow);
+
+            _updateBand();
+            if (_blockFloatingPoint) {
+                _setFFTExponent(_bandDFT.transformRealBFP(_fftResult));
+            } else {
+                _bandDFT.transformReal(_fftResult);
+                _fftPowerScale = 1.0f;
+            }
+        }
+
+        // Capture DC magnitude for diagnostics
+        _lastDCPower = _binMagSquared(0);
+    }
+
+    // If requested, make sure that the locked signal is still there
+    if (_frequencyLocked && _signalLossLimit > 0) {
+        if (_isLockedSignalPresent()) {
+            _signalLossCount = 0;
+        } else if (++_signalLossCount >= _signalLossLimit) {
+            _listener->frequencyLockLost();
+            reset();
+            return;
+        }
+    }
+
+    // If we are not yet frequency locked, try to lock
+    if (!_frequencyLocked && _autoLockEnabled) {
+
+        // Find the largest power. Notice that we ignore some low bins (DC)
+        // since that's not relevant to the spectral analysis.  This is 
+        // only needed here: while locked with band analysis the bins 
+        // outside of the bands are undefined.
+        const uint16_t maxBin = max_idx_2(_fftResult, _firstBin, _searchEndBin());
+
+        // Find the total power
+        float totalPower = 0;
+        for (uint16_t i = _firstBin; i < _searchEndBin(); i++) {
+            totalPower += _binMagSquared(i);
+        }
+        // Find the percentage of power at the max (and two adjacent)
+        float maxBinPower = _binMagSquared(maxBin);
+        if (_iqBuffer != 0) {
+            // The spectrum wraps around
+            const uint16_t mask = _fftN() - 1;
+            maxBinPower += _binMagSquared((maxBin - 1) & mask);
+            maxBinPower += _binMagSquared((maxBin + 1) & mask);
+        } else {
+            if (maxBin > 1) {
+                maxBinPower += _binMagSquared(maxBin - 1);
+            }
+            if (maxBin < (_fftN() / 2) - 1) {
+                maxBinPower += _binMagSquared(maxBin + 1);
+            }
+        }
+        const float maxBinPowerFract = maxBinPower / totalPower;
+
+        // Shift the history collection area and accumulate the new 
+        // observation.
+        for (uint16_t i = 0; i < _maxBinHistorySize - 1; i++) {
+            _maxBinHistory[i] = _maxBinHistory[i + 1];
+        }
+        _maxBinHistory[_maxBinHistorySize - 1] = maxBin;
+
+        // Find the variance of the max bin across the recent observations
+        // to see if we have stability.  We are only looking 
+        uint16_t binHistoryStart;
+        uint16_t binHistoryLength;
+        if (_longMarkBlocks > _maxBinHistorySize) {
+            binHistoryStart = 0;
+            binHistoryLength = _maxBinHistorySize;
+        } else {
+            binHistoryStart = _maxBinHistorySize - _longMarkBlocks;
+            binHistoryLength = _longMarkBlocks;
+        }
+
+        // The locking logic only works when the history is full
+        if (_blockCount >= binHistoryLength) {
+
+            // Calculate the percentage of the recent history that is 
+            // within a few bins of the current max.  We are only looking at 
+            // the training section of the history here.
+            uint16_t hitCount = 0;
+            for (uint16_t i = binHistoryStart; i < _maxBinHistorySize; i++) {
+                if (_maxBinHistory[i] >= maxBin - 1 &&
+                    _maxBinHistory[i] <= maxBin + 1) {
+                    hitCount++;
+                }
+            }
+
+            // TODO: REMOVE FLOATING POINT 
+            float hitPct = (float)hitCount / (float)binHistoryLength;
+
+            // If one bin is dominating then perform a lock
+            if (maxBinPower > _binPowerThreshold && 
+                hitPct > 0.75 && 
+                maxBinPowerFract > 0.20) {
+
+                // Convert the bin number to a frequency in Hz
+                float lockedMarkHz = _binToFreq(maxBin);
+
+                setFrequencyLock(lockedMarkHz);
+            }
+        }
+    }
+}
+
+template <uint16_t Log2FFT, uint16_t BlockSize, uint16_t ToneN, uint16_t SamplesPerSymbol, 
+    bool MetricsEnabled>
+template <typename S>
+void DemodulatorT<Log2FFT, BlockSize, ToneN, SamplesPerSymbol, MetricsEnabled>::_demodulate(S sample, uint16_t readBufferPtr) {
+
+    // ----- Quadrature Demodulation -----------------------------------------
+
+    // Figure out the detection starting point. Back up the length of the 
+    // demodulator series, wrapping as necessary.
+    // 
+    // TEST CASE 2: fftN = 512, demodToneN = 16, readBufferPtr = 15
+    // We need to start at 511.  Gap = 16-15 = 1, start = 512 - 1
+    //
+    uint16_t demodulatorStart = 0;
+    if (readBufferPtr >= _demodulatorToneN) {
+        demodulatorStart = readBufferPtr - _demodulatorToneN;
+    } else {
+        uint16_t gap = _demodulatorToneN - readBufferPtr;
+        demodulatorStart = _fftN() - gap;
+    }
+
+    // ----- Matched Filter Implementation --------------------------------
+    //
+    // Correlate recent history with each of the symbol models to look 
+    // for matches.
+
+    // The incremental correlators need to be loaded with the window that
+    // precedes this sample.  After that they just slide along.
+    if (_useIncrementalCorrelation && !_correlatorPrimed) {
+        for (uint16_t s = 0; s < _symbolCount; s++) {
+            _correlator[s].reset();
+            for (uint16_t i = 0; i < _demodulatorToneN; i++) {
+                const uint16_t k = (demodulatorStart + i) & (_fftN() - 1);
+                if (_iqBuffer != 0) {
+                    _correlator[s].update(_iqBuffer[k]);
+                } else {
+                    _correlator[s].update(_buffer[k]);
+                }
+            }
+        }
+        _correlatorPrimed = true;
+    }
+
+    // When decimating, the correlation/filter only runs on every Dth 
+    // sample.  The other samples just keep the incremental correlators
+    // moving and repeat the most recent result.
+    if (++_decimationCount < _decimation) {
+        if (_useIncrementalCorrelation) {
+            for (uint16_t s = 0; s < _symbolCount; s++) {
+                _correlator[s].update(sample);
+            }
+        }
+    } else {
+        _decimationCount = 0;
+        _filterSymbolCorr(sample, demodulatorStart);
+    }
+
+    bool aboveCorrelationThreshold = 
+        _filteredSymbolCorr[_activeSymbol] > _detectionCorrelationThreshold;
+
+    // Report out all of the key parameters
+    if (MetricsEnabled) {
+        if (_metrics) {
+            SampleMetrics& m = _metrics[_metricsCount];
+            m.sample = _metricsSample(sample);
+            m.activeSymbol = _activeSymbol;
+            m.isAnySymbolPresent = aboveCorrelationThreshold;
+            m.symbolTransition = _transitionPending;
+            for (uint16_t s = 0; s < _symbolCount; s++) {
+                m.symbolCorr[s] = _filteredSymbolCorr[s];
+            }
+            _transitionPending = false;
+            if (++_metricsCount == _metricsSize) {
+                flushMetrics();
+            }
+        } else {
+            _listener->sampleMetrics(_metricsSample(sample), _activeSymbol, _filteredSymbolCorr, aboveCorrelationThreshold);
+        }
+    }
+
+    // Hand off a demodulated symbol to the decoder
+    _processSymbol(aboveCorrelationThreshold, _activeSymbol);
+}
+
+template <uint16_t Log2FFT, uint16_t BlockSize, uint16_t ToneN, uint16_t SamplesPerSymbol, 
+    bool MetricsEnabled>
+template <typename S>
+void DemodulatorT<Log2FFT, BlockSize, ToneN, SamplesPerSymbol, MetricsEnabled>::_filterSymbolCorr(S sample, uint16_t demodulatorStart) {
+
+    
+    for (uint16_t s = 0; s < _symbolCount; s++) {
+
+        float corr;
+        if (_useIncrementalCorrelation) {
+            corr = q15_to_f32(_correlator[s].getMagnitude());
+            // Move the window forward for the next sample
+            _correlator[s].update(sample);
+        } else {
+            // Correlate the received data with the model symbol.
+            // Here we have automatic wrapping in the _buffer space, so don't
+            // worry if demodulatorStart is close to the end.
+            corr = (_iqBuffer != 0) ?
+                corr_cq15_cq15_2(_iqBuffer, demodulatorStart, _fftN(), 
+                    _demodulatorTone[s], _demodulatorToneN) :
+                corr_q15_cq15_2(_buffer, demodulatorStart, _fftN(), 
+                    _demodulatorTone[s], _demodulatorToneN);
+        }
+
+        // Apply a low-pass filter to the recent history of the correlations
+        // so that we can properly identify the transitions.  The cut-off of this
+        // filter is determined by the baud rate of the data being recovered.
+        if (_useFixedPointFilter) {
+            _filteredSymbolCorr[s] = q15_to_f32(_symbolLPFQ15[s].process(f32_to_q15(corr)));
+        } else {
+            _filteredSymbolCorr[s] = _symbolLPF[s].process(corr);
+        }
+    }
+
+    // The difference is adjusted so that a symbol transition is always an 
+    // increasing difference in correlations.
+    float corrDiff;
+    if (_activeSymbol == 0) {
+        corrDiff = _filteredSymbolCorr[1] - _filteredSymbolCorr[0];
+    } else {
+        corrDiff = _filteredSymbolCorr[0] - _filteredSymbolCorr[1];
+    }
+
+    // Once we cross 0 we have detected a transition
+    if (corrDiff > 0) {
+        // Reverse the active symbol
+        if (_activeSymbol == 0) {
+            _activeSymbol = 1;
+        } else {
+            _activeSymbol = 0;
+        }
+        // The batched metrics carry the transition along with the sample
+        if (MetricsEnabled && _metrics) {
+            _transitionPending = true;
+        } else {
+            _listener->symbolTransitionDetected();
+        }
+    }
+
+    _lastCorrDiff = corrDiff;
+}
+
+template <uint16_t Log2FFT, uint16_t BlockSize, uint16_t ToneN, uint16_t SamplesPerSymbol, 
+    bool MetricsEnabled>
+bool DemodulatorT<Log2FFT, BlockSize, ToneN, SamplesPerSymbol, MetricsEnabled>::_isLockedSignalPresent() const {
+    const float symbolFreqs[_symbolCount] = { _lockedMarkFreq - _symbolSpreadHz, _lockedMarkFreq };
+    for (uint16_t s = 0; s < _symbolCount; s++) {
+        // Convert the frequency to the nearest bin
+        const int32_t bin = (int32_t)std::floor(symbolFreqs[s] * (float)_fftN() / (float)_sampleFreq + 0.5f);
+        // Use the same power measurement as the auto-lock: the bin and its
+        // two neighbors.
+        if (_binPower(bin) > _binPowerThreshold) {
+            return true;
+        }
+    }
+    return false;
+}
+
+template <uint16_t Log2FFT, uint16_t BlockSize, uint16_t ToneN, uint16_t SamplesPerSymbol, 
+    bool MetricsEnabled>
+void DemodulatorT<Log2FFT, BlockSize, ToneN, SamplesPerSymbol, MetricsEnabled>::_transformReal31(
+    uint16_t readBufferPtr, q15 avg) {
+
+    // The samples are packed two per entry and windowed with full 
+    // precision (q15 x q15 = q30, which is shifted up to q31).
+    for (uint16_t i = 0; i < _fftN() / 2; i++) {
+        const uint16_t n = 2 * i;
+        const q15 x0 = _buffer[wrapIndex(readBufferPtr, n, _fftN())] - avg;
+        const q15 x1 = _buffer[wrapIndex(readBufferPtr, n + 1, _fftN())] - avg;
+        if (_fftWindow != 0) {
+            _fft31Result[i].r = ((q31)x0 * (q31)_fftWindow[n]) << 1;
+            _fft31Result[i].i = ((q31)x1 * (q31)_fftWindow[n + 1]) << 1;
+        } else {
+            _fft31Result[i].r = (q31)x0 << 16;
+            _fft31Result[i].i = (q31)x1 << 16;
+        }
+    }
+
+    _fft31->transformReal(_fft31Result);
+
+    // Scale the result down to q15, keeping as many bits as possible 
+    // while leaving one bit of headroom (like the block-floating-point 
+    // FFT).  A shift of 16 gives DFT / N.  The magnitudes are built 
+    // unsigned (|x| for positive x, |x| - 1 for negative x) since 
+    // std::abs(INT32_MIN) is undefined.
+    uint32_t largest = 0;
+    for (uint16_t i = 0; i <= _fftN() / 2; i++) {
+        const q31 r = _fft31Result[i].r;
+        const q31 im = _fft31Result[i].i;
+        largest |= ((uint32_t)r ^ (uint32_t)(r >> 31)) | 
+            ((uint32_t)im ^ (uint32_t)(im >> 31));
+    }
+    uint16_t shift = 0;
+    while (shift < 16 && (largest >> shift) >= 0x4000) {
+        shift++;
+    }
+    for (uint16_t i = 0; i <= _fftN() / 2; i++) {
+        _fftResult[i].r = _fft31Result[i].r >> shift;
+        _fftResult[i].i = _fft31Result[i].i >> shift;
+    }
+    // The result is DFT / 2^(log2(N) - 16 + shift)
+    _setFFTExponent((int)_log2fftN() + shift - 16);
+}
+
+template <uint16_t Log2FFT, uint16_t BlockSize, uint16_t ToneN, uint16_t SamplesPerSymbol, 
+    bool MetricsEnabled>
+void DemodulatorT<Log2FFT, BlockSize, ToneN, SamplesPerSymbol, MetricsEnabled>::_updateBand() {
+
+    if (!_bandAnalysis || !_frequencyLocked) {
+        _bandDFT.setBand(0, _fftN() / 2);
+        return;
+    }
+
+    // DC is always reported (see getLastDCPower())
+    _bandDFT.setBand(0, 0);
+
+    // The bins used by _isLockedSignalPresent()
+    if (_signalLossLimit > 0) {
+        const float symbolFreqs[_symbolCount] = { _lockedMarkFreq - _symbolSpreadHz, _lockedMarkFreq };
+        for (uint16_t s = 0; s < _symbolCount; s++) {
+            const int32_t bin = (int32_t)std::floor(symbolFreqs[s] * (float)_fftN() / (float)_sampleFreq + 0.5f);
+            // Same limits as _binPower()
+            const int32_t first = std::max(bin - 1, (int32_t)_firstBin);
+            const int32_t last = std::min(bin + 1, (int32_t)(_fftN() / 2) - 1);
+            if (first <= last) {
+                _bandDFT.addBand(first, last);
+            }
+        }
+    }
+}
+
+template <uint16_t Log2FFT, uint16_t BlockSize, uint16_t ToneN, uint16_t SamplesPerSymbol, 
+    bool MetricsEnabled>
+float DemodulatorT<Log2FFT, BlockSize, ToneN, SamplesPerSymbol, MetricsEnabled>::_binPower(int32_t bin) const {
+    float power = 0;
+    for (int32_t i = bin - 1; i <= bin + 1; i++) {
+        if (_iqBuffer != 0) {
+            // Negative frequencies are in the top half
+            const uint16_t k = i & (_fftN() - 1);
+            if (k >= _firstBin && k < _searchEndBin()) {
+                power += _binMagSquared(k);
+            }
+        } else if (i >= _firstBin && i < _fftN() / 2) {
+            power += _binMagSquared(i);
+        }
+    }
+    return power;
+}
+
+template <uint16_t Log2FFT, uint16_t BlockSize, uint16_t ToneN, uint16_t SamplesPerSymbol, 
+    bool MetricsEnabled>
+void DemodulatorT<Log2FFT, BlockSize, ToneN, SamplesPerSymbol, MetricsEnabled>::_transformComplex(uint16_t readBufferPtr) {
+
+    // DC bias removal on each component
+    int32_t totalR = 0;
+    int32_t totalI = 0;
+    for (uint16_t i = 0; i < _fftN(); i++) {
+        totalR += _iqBuffer[i].r;
+        totalI += _iqBuffer[i].i;
+    }
+    const q15 avgR = totalR >> _log2fftN();
+    const q15 avgI = totalI >> _log2fftN();
+
+    // Same layout as the real FFT
+    for (uint16_t i = 0; i < _fftN(); i++) {
+        const cq15& sample = _iqBuffer[wrapIndex(readBufferPtr, i, _fftN())];
+        if (_fftWindow != 0) {
+            _fftResult[i].r = mult_q15(sample.r - avgR, _fftWindow[i]);
+            _fftResult[i].i = mult_q15(sample.i - avgI, _fftWindow[i]);
+        } else {
+            _fftResult[i].r = sample.r - avgR;
+            _fftResult[i].i = sample.i - avgI;
+        }
+    }
+
+    if (_blockFloatingPoint) {
+        _setFFTExponent(_fft.transformBFP(_fftResult));
+    } else {
+        _fft.transform(_fftResult);
+        _fftPowerScale = 1.0f;
+    }
+
+    _lastDCPower = _binMagSquared(0);
+}
+
+template <uint16_t Log2FFT, uint16_t BlockSize, uint16_t ToneN, uint16_t SamplesPerSymbol, 
+    bool MetricsEnabled>
+float DemodulatorT<Log2FFT, BlockSize, ToneN, SamplesPerSymbol, MetricsEnabled>::getMarkFreq() const {
+    return _lockedMarkFreq;
+}
+
+}
+
+#endif
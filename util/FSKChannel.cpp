@@ -0,0 +1,124 @@
+/*
+Copyright (C) 2024 - Bruce MacKinnon KC1FSZ
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <cstring>
+
+#include "FSKChannel.h"
+#include "Demodulator.h"
+
+namespace radlib {
+
+FSKChannel::FSKChannel(uint16_t sampleFreq, uint16_t log2fftN,
+    const q15* fftTrigTable, float symbolSpreadHz)
+:   _sampleFreq(sampleFreq),
+    _symbolSpreadHz(symbolSpreadHz),
+    _correlator {
+        SlidingCorrelator(_log2ToneN, log2fftN, fftTrigTable, _correlatorHistory[0]),
+        SlidingCorrelator(_log2ToneN, log2fftN, fftTrigTable, _correlatorHistory[1])
+    },
+    _lpf {
+        FirFilter<q15>(_lpfQ15, _lpfN, true, _symbolCorr[0]),
+        FirFilter<q15>(_lpfQ15, _lpfN, true, _symbolCorr[1])
+    } {
+
+    // The q15 version of the full-rate LPF.  Only the first half (plus
+    // the center tap) is needed since the filter is symmetric.
+    for (uint16_t i = 0; i <= _lpfN / 2; i++) {
+        _lpfQ15[i] = (q15)(h_lpf_33[i] * 32768.0f + 0.5f);
+    }
+
+    reset();
+}
+
+void FSKChannel::reset() {
+    _active = false;
+    _markFreq = 0;
+    _signalLossCount = 0;
+    _activeSymbol = 0;
+    for (uint16_t s = 0; s < _symbolCount; s++) {
+        _lpf[s].reset();
+        _correlator[s].reset();
+    }
+}
+
+void FSKChannel::start(float markFreqHz, const q15* buffer, uint16_t bufferN,
+    uint16_t bufferPtr) {
+
+    reset();
+    _active = true;
+    _markFreq = markFreqHz;
+
+    _correlator[0].setTone(_sampleFreq, markFreqHz - _symbolSpreadHz);
+    _correlator[1].setTone(_sampleFreq, markFreqHz);
+
+    // Load the matched filters with the window that precedes the next
+    // sample, wrapping as needed.
+    const uint16_t mask = bufferN - 1;
+    for (uint16_t s = 0; s < _symbolCount; s++) {
+        for (uint16_t i = 0; i < _toneN; i++) {
+            _correlator[s].update(buffer[(bufferPtr - _toneN + i) & mask]);
+        }
+    }
+
+    _listener->frequencyLocked(markFreqHz, markFreqHz - _symbolSpreadHz);
+}
+
+void FSKChannel::stop() {
+    _listener->frequencyLockLost();
+    reset();
+}
+
+bool FSKChannel::isSignalLost(bool isSignalPresent, uint16_t lossLimit) {
+    if (isSignalPresent) {
+        _signalLossCount = 0;
+        return false;
+    } 
+    return lossLimit > 0 && ++_signalLossCount >= lossLimit;
+}
+
+void FSKChannel::processPendingSamples(const q15* samples, size_t end) {
+    processSamples(samples + _pendingSample, end - _pendingSample);
+    _pendingSample = end;
+}
+
+void FSKChannel::processSamples(const q15* samples, size_t n) {
+
+    for (size_t k = 0; k < n; k++) {
+
+        q15 filteredCorr[_symbolCount];
+        for (uint16_t s = 0; s < _symbolCount; s++) {
+            const q15 corr = _correlator[s].getMagnitude();
+            _correlator[s].update(samples[k]);
+            filteredCorr[s] = _lpf[s].process(corr);
+        }
+
+        // The difference is adjusted so that a symbol transition is always an
+        // increasing difference in correlations.
+        const int16_t corrDiff = (_activeSymbol == 0) ?
+            filteredCorr[1] - filteredCorr[0] :
+            filteredCorr[0] - filteredCorr[1];
+
+        // Once we cross 0 we have detected a transition
+        if (corrDiff > 0) {
+            _activeSymbol = (_activeSymbol == 0) ? 1 : 0;
+            _listener->symbolTransitionDetected();
+        }
+
+        _processSymbol(filteredCorr[_activeSymbol] > _detectionCorrelationThreshold,
+            _activeSymbol);
+    }
+}
+
+}
@@ -0,0 +1,162 @@
+/*
+Copyright (C) 2024 - Bruce MacKinnon KC1FSZ
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef _FSKChannel_h
+#define _FSKChannel_h
+
+#include <cstdint>
+#include <cstddef>
+
+#include "fixed_math.h"
+#include "SlidingCorrelator.h"
+#include "FirFilter.h"
+#include "DemodulatorListener.h"
+#include "DemodulatorDefs.h"
+
+namespace radlib {
+
+/**
+ * One channel of an FSKSkimmer.  This is the matched filter/LPF/transition
+ * logic of the Demodulator (in its incremental, fixed-point form) without
+ * any of the spectral analysis or sample buffering - those are shared
+ * across all of the channels by the skimmer.
+ *
+ * The symbols are handed to _processSymbol(), which is where the
+ * protocol-specific decoder is connected (see SCAMPChannel/RTTYChannel).
+ *
+ * The per-sample metrics are not reported by the channels.
+ *
+ * There is no internal memory allocation/deallocation.
+ */
+class FSKChannel {
+public:
+
+    /**
+     * @param sampleFreq The sample rate (must match the skimmer).
+     * @param log2fftN The size of the skimmer's FFT in log terms.
+     * @param fftTrigTable The trig table space that is passed to the
+     *   skimmer.  It is only read when the channel is started, after the
+     *   skimmer has built it.
+     * @param symbolSpreadHz The distance from the mark down to the space,
+     *   as in Demodulator::setSymbolSpread().
+     */
+    FSKChannel(uint16_t sampleFreq, uint16_t log2fftN, const q15* fftTrigTable,
+        float symbolSpreadHz);
+    virtual ~FSKChannel() { }
+
+    /**
+     * A listener must be provided before the channel is started.
+     */
+    virtual void setListener(DemodulatorListener* listener) { _listener = listener; }
+
+    DemodulatorListener* getListener() const { return _listener; }
+
+    void setDetectionCorrelationThreshold(float th) { _detectionCorrelationThreshold = f32_to_q15(th); }
+
+    void setSymbolSpread(float spreadHz) { _symbolSpreadHz = spreadHz; }
+
+    float getSymbolSpread() const { return _symbolSpreadHz; }
+
+    /**
+     * Starts demodulating a signal.  The matched filters are loaded with
+     * the samples that come before bufferPtr in the circular buffer, so
+     * the next sample processed should be the one at bufferPtr.
+     *
+     * @param markFreqHz The mark frequency.
+     * @param buffer The skimmer's sample buffer.
+     * @param bufferN The size of the buffer (a power of 2).
+     * @param bufferPtr The buffer location of the next sample.
+     */
+    void start(float markFreqHz, const q15* buffer, uint16_t bufferN, uint16_t bufferPtr);
+
+    /**
+     * Stops the channel because the signal has gone away.  The listener
+     * is notified.
+     */
+    void stop();
+
+    /**
+     * Clears all state and makes the channel idle.
+     */
+    virtual void reset();
+
+    bool isActive() const { return _active; }
+
+    float getMarkFreq() const { return _markFreq; }
+
+    /**
+     * Called by the skimmer after each spectral analysis.
+     *
+     * @returns true if the signal has been missing for the number of
+     *   consecutive analyses given by lossLimit (0 means never).
+     */
+    bool isSignalLost(bool isSignalPresent, uint16_t lossLimit);
+
+    /**
+     * Demodulates a run of samples.  Only call this when the channel
+     * is active.
+     */
+    void processSamples(const q15* samples, size_t n);
+
+    /**
+     * Used by the skimmer to keep track of the first sample in the current
+     * input block that this channel has not demodulated yet.
+     */
+    void setPendingSample(size_t i) { _pendingSample = i; }
+
+    /**
+     * Demodulates the samples from the pending sample up to (but not 
+     * including) end and makes end the pending sample.
+     */
+    void processPendingSamples(const q15* samples, size_t end);
+
+protected:
+
+    /**
+     * This is called on every sample and indicates which symbol (if any) has been
+     * detected.
+     */
+    virtual void _processSymbol(bool symbolValid, uint8_t symbol) = 0;
+
+    DemodulatorListener* _listener = 0;
+
+private:
+
+    const uint16_t _sampleFreq;
+    float _symbolSpreadHz;
+    bool _active = false;
+    float _markFreq = 0;
+    uint16_t _signalLossCount = 0;
+    size_t _pendingSample = 0;
+    q15 _detectionCorrelationThreshold = 0;
+    uint8_t _activeSymbol = 0;
+
+    // Same as the Demodulator defaults
+    static const uint16_t _symbolCount = SYMBOL_COUNT;
+    static const uint16_t _log2ToneN = DEMODULATOR_LOG2_TONE_N;
+    static const uint16_t _toneN = DEMODULATOR_TONE_N;
+    SlidingCorrelator::Product _correlatorHistory[_symbolCount][_toneN];
+    SlidingCorrelator _correlator[_symbolCount];
+
+    // The LPF (full rate, symmetric) that runs over the correlations
+    static const uint16_t _lpfN = h_lpf_33_size;
+    q15 _lpfQ15[_lpfN / 2 + 1];
+    q15 _symbolCorr[_symbolCount][FirFilter<q15>::historySpaceSize(_lpfN)];
+    FirFilter<q15> _lpf[_symbolCount];
+};
+
+}
+
+#endif
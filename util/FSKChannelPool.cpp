@@ -0,0 +1,200 @@
+/*
+Copyright (C) 2024 - Bruce MacKinnon KC1FSZ
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "FSKChannelPool.h"
+
+namespace radlib {
+
+// ===== DemodulatorEventBuffer ================================================
+
+void DemodulatorEventBuffer::_add(Type type, int32_t a, int32_t b, int32_t c) {
+    Event e;
+    e.type = type;
+    e.a = a;
+    e.b = b;
+    e.c = c;
+    _events.push_back(e);
+}
+
+void DemodulatorEventBuffer::frequencyLocked(uint16_t markFreq, uint16_t spaceFreq) {
+    _add(FREQUENCY_LOCKED, markFreq, spaceFreq);
+}
+
+void DemodulatorEventBuffer::frequencyLockedSigned(int16_t markFreq, int16_t spaceFreq) {
+    _add(FREQUENCY_LOCKED_SIGNED, markFreq, spaceFreq);
+}
+
+void DemodulatorEventBuffer::frequencyLockLost() {
+    _add(FREQUENCY_LOCK_LOST);
+}
+
+void DemodulatorEventBuffer::symbolTransitionDetected() {
+    _add(SYMBOL_TRANSITION);
+}
+
+void DemodulatorEventBuffer::sampleMetrics(q15 sample, uint8_t activeSymbol, 
+    float* symbolCorr, bool isAnySymbolPresent) {
+    _add(SAMPLE_METRICS, sample, activeSymbol, isAnySymbolPresent);
+    for (uint16_t s = 0; s < SYMBOL_COUNT; s++) {
+        _events.back().symbolCorr[s] = symbolCorr[s];
+    }
+}
+
+void DemodulatorEventBuffer::received(char asciiChar) {
+    _add(RECEIVED, asciiChar);
+}
+
+void DemodulatorEventBuffer::receivedBit(bool bit, uint16_t frameBitPos, int syncFrameCorr) {
+    _add(RECEIVED_BIT, bit, frameBitPos, syncFrameCorr);
+}
+
+void DemodulatorEventBuffer::goodFrameReceived() {
+    _add(GOOD_FRAME);
+}
+
+void DemodulatorEventBuffer::badFrameReceived(uint32_t rawFrame) {
+    _add(BAD_FRAME, (int32_t)rawFrame);
+}
+
+void DemodulatorEventBuffer::dataSyncAcquired() {
+    _add(DATA_SYNC);
+}
+
+void DemodulatorEventBuffer::discardedDuplicate() {
+    _add(DISCARDED_DUPLICATE);
+}
+
+void DemodulatorEventBuffer::replay(DemodulatorListener* l) {
+    for (Event& e : _events) {
+        switch (e.type) {
+        case FREQUENCY_LOCKED: l->frequencyLocked(e.a, e.b); break;
+        case FREQUENCY_LOCKED_SIGNED: l->frequencyLockedSigned(e.a, e.b); break;
+        case FREQUENCY_LOCK_LOST: l->frequencyLockLost(); break;
+        case SYMBOL_TRANSITION: l->symbolTransitionDetected(); break;
+        case SAMPLE_METRICS: l->sampleMetrics(e.a, e.b, e.symbolCorr, e.c != 0); break;
+        case RECEIVED: l->received((char)e.a); break;
+        case RECEIVED_BIT: l->receivedBit(e.a != 0, e.b, e.c); break;
+        case GOOD_FRAME: l->goodFrameReceived(); break;
+        case BAD_FRAME: l->badFrameReceived((uint32_t)e.a); break;
+        case DATA_SYNC: l->dataSyncAcquired(); break;
+        case DISCARDED_DUPLICATE: l->discardedDuplicate(); break;
+        }
+    }
+    _events.clear();
+}
+
+// ===== FSKChannelPool ========================================================
+
+FSKChannelPool::FSKChannelPool(uint16_t threadCount) 
+:   _nextChannel(0) {
+    for (uint16_t i = 1; i < threadCount; i++) {
+        _workers.emplace_back(&FSKChannelPool::_runWorker, this);
+    }
+}
+
+FSKChannelPool::~FSKChannelPool() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _shutdown = true;
+    }
+    _startCondition.notify_all();
+    for (std::thread& worker : _workers) {
+        worker.join();
+    }
+}
+
+void FSKChannelPool::processChannels(FSKChannel** channels, uint16_t channelCount,
+    const q15* samples, size_t n) {
+
+    // Point the active channels at their event buffers for this block
+    if (_eventBuffers.size() < channelCount) {
+        _eventBuffers.resize(channelCount);
+        _listeners.resize(channelCount);
+    }
+    for (uint16_t c = 0; c < channelCount; c++) {
+        _listeners[c] = 0;
+        if (channels[c]->isActive()) {
+            _listeners[c] = channels[c]->getListener();
+            channels[c]->setListener(&_eventBuffers[c]);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _channels = channels;
+        _channelCount = channelCount;
+        _samples = samples;
+        _sampleCount = n;
+        _nextChannel = 0;
+        _busyCount = _workers.size();
+        _generation++;
+    }
+    _startCondition.notify_all();
+
+    _processAvailableChannels();
+
+    // Wait for the workers to finish up.  The lock also makes the channel
+    // state that the workers changed visible to this thread.
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _doneCondition.wait(lock, [this] { return _busyCount == 0; });
+    }
+
+    // Deliver the events in channel order (the same order as running the
+    // channels one after the other on this thread)
+    for (uint16_t c = 0; c < channelCount; c++) {
+        if (_listeners[c] != 0) {
+            channels[c]->setListener(_listeners[c]);
+            _eventBuffers[c].replay(_listeners[c]);
+        }
+    }
+}
+
+void FSKChannelPool::_processAvailableChannels() {
+    while (true) {
+        const uint16_t c = _nextChannel.fetch_add(1);
+        if (c >= _channelCount) {
+            break;
+        }
+        if (_channels[c]->isActive()) {
+            _channels[c]->processPendingSamples(_samples, _sampleCount);
+        }
+    }
+}
+
+void FSKChannelPool::_runWorker() {
+    uint32_t lastGeneration = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _startCondition.wait(lock, [this, lastGeneration] { 
+                return _shutdown || _generation != lastGeneration; 
+            });
+            if (_shutdown) {
+                return;
+            }
+            lastGeneration = _generation;
+        }
+        _processAvailableChannels();
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (--_busyCount == 0) {
+                _doneCondition.notify_one();
+            }
+        }
+    }
+}
+
+}
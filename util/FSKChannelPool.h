@@ -0,0 +1,143 @@
+/*
+Copyright (C) 2024 - Bruce MacKinnon KC1FSZ
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef _FSKChannelPool_h
+#define _FSKChannelPool_h
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+
+#include "FSKSkimmer.h"
+
+namespace radlib {
+
+/**
+ * A listener that records the events it receives so that they can be 
+ * passed on to another listener later (on another thread).  The per-sample
+ * metrics are recorded one sample at a time.
+ *
+ * NOTE: This allocates memory as the events arrive.
+ */
+class DemodulatorEventBuffer : public DemodulatorListener {
+public:
+
+    virtual void frequencyLocked(uint16_t markFreq, uint16_t spaceFreq);
+    virtual void frequencyLockedSigned(int16_t markFreq, int16_t spaceFreq);
+    virtual void frequencyLockLost();
+    virtual void symbolTransitionDetected();
+    virtual void sampleMetrics(q15 sample, uint8_t activeSymbol, float* symbolCorr, bool isAnySymbolPresent);
+    virtual void received(char asciiChar);
+    virtual void receivedBit(bool bit, uint16_t frameBitPos, int syncFrameCorr);
+    virtual void goodFrameReceived();
+    virtual void badFrameReceived(uint32_t rawFrame);
+    virtual void dataSyncAcquired();
+    virtual void discardedDuplicate();
+
+    /**
+     * Delivers the recorded events to the listener (in the order they 
+     * were received) and clears the buffer.
+     */
+    void replay(DemodulatorListener* listener);
+
+private:
+
+    enum Type : uint8_t { 
+        FREQUENCY_LOCKED, FREQUENCY_LOCKED_SIGNED, FREQUENCY_LOCK_LOST,
+        SYMBOL_TRANSITION, SAMPLE_METRICS, RECEIVED, RECEIVED_BIT, 
+        GOOD_FRAME, BAD_FRAME, DATA_SYNC, DISCARDED_DUPLICATE 
+    };
+
+    struct Event {
+        Type type;
+        int32_t a;
+        int32_t b;
+        int32_t c;
+        float symbolCorr[SYMBOL_COUNT];
+    };
+
+    void _add(Type type, int32_t a = 0, int32_t b = 0, int32_t c = 0);
+
+    std::vector<Event> _events;
+};
+
+/**
+ * Runs the skimmer channels on a pool of threads.  The calling thread 
+ * takes part, so a pool of N threads starts N - 1 workers.  The channels 
+ * are handed out one at a time from a shared counter so that a thread 
+ * that finishes early picks up more of the work.  
+ * 
+ * The listener events from each channel are buffered while the block
+ * is being processed.  Once all of the threads are done the events are
+ * delivered on the calling thread in channel order, so the listeners 
+ * see exactly what they would see without the pool (and they don't 
+ * need to be thread-safe).
+ *
+ * NOTE: This is for desktop/server use only - it needs std::thread and 
+ * it allocates memory.  
+ */
+class FSKChannelPool : public FSKChannelExecutor {
+public:
+
+    /**
+     * @param threadCount The total number of threads, including the caller.
+     */
+    FSKChannelPool(uint16_t threadCount);
+    virtual ~FSKChannelPool();
+
+    virtual void processChannels(FSKChannel** channels, uint16_t channelCount,
+        const q15* samples, size_t n);
+
+    uint16_t getThreadCount() const { return _workers.size() + 1; }
+
+private:
+
+    void _runWorker();
+
+    /**
+     * Processes channels until there are none left.
+     */
+    void _processAvailableChannels();
+
+    std::vector<std::thread> _workers;
+
+    std::mutex _mutex;
+    std::condition_variable _startCondition;
+    std::condition_variable _doneCondition;
+    // Incremented for each new block of work
+    uint32_t _generation = 0;
+    // The number of workers that haven't finished the current block
+    uint16_t _busyCount = 0;
+    bool _shutdown = false;
+
+    // The current block of work
+    FSKChannel** _channels = 0;
+    uint16_t _channelCount = 0;
+    const q15* _samples = 0;
+    size_t _sampleCount = 0;
+    std::atomic<uint16_t> _nextChannel;
+
+    // One for each channel, used for the duration of a block
+    std::vector<DemodulatorEventBuffer> _eventBuffers;
+    std::vector<DemodulatorListener*> _listeners;
+};
+
+}
+
+#endif
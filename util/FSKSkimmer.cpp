@@ -0,0 +1,246 @@
+/*
+Copyright (C) 2024 - Bruce MacKinnon KC1FSZ
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <cstring>
+#include <cassert>
+#include <cmath>
+#include <algorithm>
+
+#include "FSKSkimmer.h"
+#include "dsp_util.h"
+
+namespace radlib {
+
+FSKSkimmer::FSKSkimmer(uint16_t sampleFreq, uint16_t lowestFreq, uint16_t log2fftN,
+    q15* fftTrigTableSpace, q15* fftWindowSpace, cq15* fftResultSpace,
+    q15* bufferSpace, uint8_t* binScoreSpace,
+    FSKChannel** channels, uint16_t channelCount)
+:   _sampleFreq(sampleFreq),
+    _log2fftN(log2fftN),
+    _fftN(1 << log2fftN),
+    _firstBin((_fftN * lowestFreq) / sampleFreq),
+    // The Hann window for the FFT (if a space has been provided for it)
+    _fftWindow(make_hann_window_q15(fftWindowSpace, _fftN)),
+    _fftResult(fftResultSpace),
+    _fft(_fftN, fftTrigTableSpace),
+    _buffer(bufferSpace),
+    _binScore(binScoreSpace),
+    _channels(channels),
+    _channelCount(channelCount) {
+
+    // processSamples() relies on this so that a block never crosses the 
+    // end of the circular buffer
+    assert((_fftN % _blockSize) == 0);
+
+    memset((void*)_buffer, 0, _fftN * sizeof(q15));
+    memset((void*)_binScore, 0, binScoreSpaceSize(_log2fftN));
+}
+
+void FSKSkimmer::reset() {
+    for (uint16_t c = 0; c < _channelCount; c++) {
+        _channels[c]->reset();
+    }
+    memset((void*)_binScore, 0, binScoreSpaceSize(_log2fftN));
+}
+
+uint16_t FSKSkimmer::getActiveChannelCount() const {
+    uint16_t count = 0;
+    for (uint16_t c = 0; c < _channelCount; c++) {
+        if (_channels[c]->isActive()) {
+            count++;
+        }
+    }
+    return count;
+}
+
+bool FSKSkimmer::startChannel(float markFreqHz) {
+    for (uint16_t c = 0; c < _channelCount; c++) {
+        if (!_channels[c]->isActive()) {
+            _channels[c]->start(markFreqHz, _buffer, _fftN, _bufferPtr);
+            return true;
+        }
+    }
+    return false;
+}
+
+void FSKSkimmer::processSample(q15 sample) {
+    processSamples(&sample, 1);
+}
+
+void FSKSkimmer::processSamples(const q15* samples, size_t n) {
+
+    // ----- Phase 1: Buffering and spectral analysis ------------------------
+
+    size_t i = 0;
+    while (i < n) {
+
+        // Work in runs that end no later than the next block boundary.  The
+        // FFT size is a multiple of the block size, so this never crosses
+        // the end of the circular buffer.
+        uint16_t run = _blockSize - (_bufferPtr % _blockSize);
+        if (run > n - i) {
+            run = n - i;
+        }
+
+        const uint16_t runStart = _bufferPtr;
+        memcpy((void*)(_buffer + runStart), (const void*)(samples + i), run * sizeof(q15));
+        _bufferPtr += run;
+        if (_bufferPtr == _fftN) {
+            _bufferPtr = 0;
+        }
+        i += run;
+
+        if (_bufferPtr % _blockSize == 0) {
+            _analyzeBlock(samples, i - 1, runStart + run - 1);
+        }
+    }
+
+    // ----- Phase 2: Demodulation -------------------------------------------
+
+    if (_executor != 0) {
+        _executor->processChannels(_channels, _channelCount, samples, n);
+    } else {
+        for (uint16_t c = 0; c < _channelCount; c++) {
+            if (_channels[c]->isActive()) {
+                _channels[c]->processPendingSamples(samples, n);
+            }
+        }
+    }
+
+    // Everything has been seen
+    for (uint16_t c = 0; c < _channelCount; c++) {
+        _channels[c]->setPendingSample(0);
+    }
+}
+
+float FSKSkimmer::_binPower(int32_t bin) const {
+    float power = 0;
+    for (int32_t i = bin - 1; i <= bin + 1; i++) {
+        if (i >= _firstBin && i < _fftN / 2) {
+            power += _fftResult[i].mag_f32_squared();
+        }
+    }
+    return power;
+}
+
+int32_t FSKSkimmer::_freqToBin(float freqHz) const {
+    return (int32_t)(freqHz * (float)_fftN / (float)_sampleFreq + 0.5f);
+}
+
+bool FSKSkimmer::_isClaimed(uint16_t bin) const {
+    for (uint16_t c = 0; c < _channelCount; c++) {
+        const FSKChannel* channel = _channels[c];
+        if (channel->isActive()) {
+            const float markFreq = channel->getMarkFreq();
+            const int32_t markBin = _freqToBin(markFreq);
+            const int32_t spaceBin = _freqToBin(markFreq - channel->getSymbolSpread());
+            // The space can be on either side of the mark
+            const int32_t low = std::min(markBin, spaceBin) - 2;
+            const int32_t high = std::max(markBin, spaceBin) + 2;
+            if ((int32_t)bin >= low && (int32_t)bin <= high) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void FSKSkimmer::_analyzeBlock(const q15* samples, size_t sampleIndex, 
+    uint16_t readBufferPtr) {
+
+    _blockCount++;
+
+    // Compute the average across the FFT buffer for the purposes of DC
+    // bias removal
+    q15 avg = mean_q15(_buffer, _log2fftN);
+
+    // Do the FFT in the result buffer, including the window (the same 
+    // as the Demodulator)
+    load_real_fft_q15(_fftResult, _buffer, readBufferPtr, _fftN, avg, 
+        _fftWindow);
+
+    _fft.transformReal(_fftResult);
+
+    // Make sure that the signals being demodulated are still there
+    for (uint16_t c = 0; c < _channelCount; c++) {
+        FSKChannel* channel = _channels[c];
+        if (channel->isActive()) {
+            const float markFreq = channel->getMarkFreq();
+            const bool present =
+                _binPower(_freqToBin(markFreq)) > _binPowerThreshold ||
+                _binPower(_freqToBin(markFreq - channel->getSymbolSpread())) > _binPowerThreshold;
+            if (channel->isSignalLost(present, _channelLossLimit)) {
+                // The channel needs to see everything before this block's 
+                // last sample (which is where it would have been stopped
+                // when running sample by sample).
+                channel->processPendingSamples(samples, sampleIndex);
+                channel->stop();
+            }
+        }
+    }
+
+    // Find the peaks (in ascending order)
+    uint16_t peaks[_maxPeakCount];
+    uint16_t peakCount = 0;
+    for (uint16_t k = _firstBin + 1; k < (_fftN / 2) - 1 && peakCount < _maxPeakCount; k++) {
+        const float p = _fftResult[k].mag_f32_squared();
+        if (p >= _fftResult[k - 1].mag_f32_squared() &&
+            p > _fftResult[k + 1].mag_f32_squared() &&
+            _binPower(k) > _binPowerThreshold) {
+            peaks[peakCount++] = k;
+        }
+    }
+
+    // Score every bin.  A bin is hit if it is within one of a peak.
+    uint16_t p = 0;
+    for (uint16_t k = _firstBin; k < _fftN / 2; k++) {
+        // Skip the peaks that are too far below this bin
+        while (p < peakCount && peaks[p] + 1 < k) {
+            p++;
+        }
+        if (p < peakCount && peaks[p] <= k + 1) {
+            if (_binScore[k] < 255) {
+                _binScore[k]++;
+            }
+        } else {
+            _binScore[k] = (_binScore[k] > 3) ? _binScore[k] - 3 : 0;
+        }
+    }
+
+    // Start a channel on each peak that has been stable for long enough
+    // and isn't already being demodulated
+    for (uint16_t i = 0; i < peakCount; i++) {
+        const uint16_t bin = peaks[i];
+        if (_binScore[bin] >= _startScore && !_isClaimed(bin)) {
+            // Convert the bin number to a frequency in Hz.  NOTE: The 
+            // channel demodulation starts with this block's last sample.
+            const float markHz = (float)bin * (float)_sampleFreq / (float)_fftN;
+            bool started = false;
+            for (uint16_t c = 0; c < _channelCount && !started; c++) {
+                if (!_channels[c]->isActive()) {
+                    _channels[c]->start(markHz, _buffer, _fftN, readBufferPtr);
+                    _channels[c]->setPendingSample(sampleIndex);
+                    started = true;
+                }
+            }
+            // No point in looking further if all channels are busy
+            if (!started) {
+                break;
+            }
+        }
+    }
+}
+
+}
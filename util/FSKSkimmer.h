@@ -0,0 +1,210 @@
+/*
+Copyright (C) 2024 - Bruce MacKinnon KC1FSZ
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef _FSKSkimmer_h
+#define _FSKSkimmer_h
+
+#include <cstdint>
+#include <cstddef>
+
+#include "fixed_math.h"
+#include "fixed_fft.h"
+#include "FSKChannel.h"
+
+namespace radlib {
+
+/**
+ * Controls how the skimmer channels are run (i.e. on other threads).
+ */
+class FSKChannelExecutor {
+public:
+
+    virtual ~FSKChannelExecutor() { }
+
+    /**
+     * Calls processPendingSamples(samples, n) on each of the active 
+     * channels and returns when they are all done.  Each channel must 
+     * be handled by one thread, but different channels can run at 
+     * the same time.  The listener events must be delivered on the 
+     * calling thread, one channel at a time in channel order (see 
+     * FSKChannelPool).
+     */
+    virtual void processChannels(FSKChannel** channels, uint16_t channelCount,
+        const q15* samples, size_t n) = 0;
+};
+
+/**
+ * Demodulates every FSK signal in the passband at the same time.  There
+ * is one sample buffer and one FFT (the same spectral analysis that the
+ * Demodulator uses for its auto-lock).  Each stable carrier that shows up
+ * in the bin history is assigned to an idle FSKChannel, and the channel
+ * runs its own matched filters/decoder on the shared sample stream.
+ *
+ * Carrier detection: a bin is a peak when it is a local maximum and the
+ * power in it and its two neighbors is above the threshold.  Every bin
+ * within one of a peak scores a hit.  Each bin keeps a score that goes
+ * up by one on a hit and down by three on a miss, so the score only
+ * grows when the bin is hit more than 75% of the time.  This is the
+ * same stability test as the Demodulator auto-lock (75% of the "long
+ * mark"), but it is applied to every bin rather than just the loudest.
+ * Bins that are close to the mark/space of an active channel are
+ * ignored.
+ *
+ * A channel is released when there is no power near its mark or space
+ * for a number of consecutive analysis blocks.
+ *
+ * Each call to processSamples() works in two phases.  First the samples
+ * are buffered and analyzed block by block, which is when channels are
+ * started and stopped.  Then every active channel demodulates all of the 
+ * samples it hasn't seen yet in one go.  The channels are independent
+ * so this second phase can be handed to an FSKChannelExecutor that 
+ * uses multiple threads.
+ *
+ * There is no internal memory allocation/deallocation.
+ */
+class FSKSkimmer {
+public:
+
+    /**
+     * @param sampleFreq The sample rate.
+     * @param lowestFreq Carriers below this frequency are ignored.
+     * @param log2fftN The size of the FFT in log terms.
+     * @param fftTrigTableSpace Space for the FFT trig table.  This is
+     *   shared with the channels.
+     * @param fftWindowSpace Space for the Hann window, or 0 for none.
+     * @param fftResultSpace Space for the FFT result (N/2 + 1 entries).
+     * @param bufferSpace Space for the sample buffer.
+     * @param binScoreSpace Space for the carrier detection.  See
+     *   binScoreSpaceSize().
+     * @param channels The channels that are available for use.
+     * @param channelCount The number of channels.
+     */
+    FSKSkimmer(uint16_t sampleFreq, uint16_t lowestFreq, uint16_t log2fftN,
+        q15* fftTrigTableSpace, q15* fftWindowSpace, cq15* fftResultSpace,
+        q15* bufferSpace, uint8_t* binScoreSpace,
+        FSKChannel** channels, uint16_t channelCount);
+
+    static constexpr uint16_t binScoreSpaceSize(uint16_t log2fftN) {
+        return (1 << log2fftN) / 2;
+    }
+
+    /**
+     * Call this function at the rate defined by sampleFreq and pass the latest
+     * sample from the ADC.
+     */
+    void processSample(q15 sample);
+
+    /**
+     * Processes a block of samples.  Each channel produces the same events
+     * that it would if processSample() were called for each sample, but
+     * the events from different channels may be interleaved differently.
+     * Larger blocks are more efficient, particularly when an executor 
+     * is being used.
+     */
+    void processSamples(const q15* samples, size_t n);
+
+    /**
+     * @param executor Used to run the channels, or 0 to run them on the
+     *   caller's thread.  The executor delivers the listener events on 
+     *   the caller's thread in the same order as running without it (see
+     *   FSKChannelExecutor), so the listeners don't need to be 
+     *   thread-safe.
+     */
+    void setExecutor(FSKChannelExecutor* executor) { _executor = executor; }
+
+    /**
+     * Stops all channels and clears the carrier detection.
+     */
+    void reset();
+
+    /**
+     * Starts an idle channel on the specified mark frequency.
+     *
+     * @returns false if there were no idle channels.
+     */
+    bool startChannel(float markFreqHz);
+
+    /**
+     * @param blocks The number of consecutive analysis blocks without any
+     *   signal before a channel is released, or 0 to never release.
+     */
+    void setChannelLossLimit(uint16_t blocks) { _channelLossLimit = blocks; }
+
+    uint16_t getActiveChannelCount() const;
+
+    uint32_t getBlockCount() const { return _blockCount; }
+
+private:
+
+    /**
+     * Runs the spectral analysis/carrier detection.  Called each time a
+     * block has been completed.
+     *
+     * @param samples The input block being processed.
+     * @param sampleIndex The location of the most recent sample in the 
+     *   input block.
+     * @param readBufferPtr The buffer location of the most recent sample.
+     */
+    void _analyzeBlock(const q15* samples, size_t sampleIndex, uint16_t readBufferPtr);
+
+    /**
+     * @returns The power in the bin and its two neighbors.
+     */
+    float _binPower(int32_t bin) const;
+
+    /**
+     * @returns The bin closest to the frequency.
+     */
+    int32_t _freqToBin(float freqHz) const;
+
+    /**
+     * @returns true if the bin is close to the mark/space of an active
+     *   channel.
+     */
+    bool _isClaimed(uint16_t bin) const;
+
+    const uint16_t _sampleFreq;
+    const uint16_t _log2fftN;
+    const uint16_t _fftN;
+    const uint16_t _firstBin;
+    const q15* _fftWindow;
+    cq15* _fftResult;
+    FixedFFT _fft;
+    q15* _buffer;
+    uint16_t _bufferPtr = 0;
+    uint8_t* _binScore;
+    FSKChannel** _channels;
+    const uint16_t _channelCount;
+    FSKChannelExecutor* _executor = 0;
+
+    // Same as the Demodulator
+    static const uint16_t _blockSize = DEMODULATOR_BLOCK_SIZE;
+    static const uint16_t _samplesPerSymbol = DEMODULATOR_SAMPLES_PER_SYMBOL;
+    // The number of analysis blocks in the "long mark" with a slight
+    // haircut (see Demodulator)
+    const uint16_t _longMarkBlocks = ((24 * _samplesPerSymbol) / _blockSize) * 0.70;
+    // The score needed to start a channel
+    const uint8_t _startScore = (_longMarkBlocks * 3) / 4;
+    // Peaks beyond this number are ignored in each analysis
+    static const uint16_t _maxPeakCount = 64;
+    float _binPowerThreshold = 5.0e-4;
+
+    uint16_t _channelLossLimit = 32;
+    uint32_t _blockCount = 0;
+};
+
+}
+
+#endif
@@ -25,7 +25,7 @@ FileModulator::FileModulator(std::ostream& str, unsigned int sampleRate, unsigne
     _symbolLength(symbolLength),
     _markFreq(markFreq),
     _spaceFreq(spaceFreq),
-    _phi(0)
+    _nco(sampleRate)
 {
 }
 
@@ -47,12 +47,11 @@ void FileModulator::sendSilence() {
 void FileModulator::_send(unsigned int freq) {
 
     const float scale = 32760;
-    const float omega = 2.0 * 3.14159 * (float)freq / (float)_sampleRate;
+    _nco.setFrequency(freq);
 
     for (unsigned int i = 0; i < _symbolLength; i++) {
-        float s = std::cos(_phi) * scale;
+        float s = _nco.nextF32() * scale;
         _str << (int)s << "\n";
-        _phi += omega;
     }
 
     _str.flush();
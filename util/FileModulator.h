@@ -18,6 +18,7 @@ this program. If not, see <https://www.gnu.org/licenses/>.
 
 #include <iostream>
 #include "FSKModulator.h"
+#include "NCO.h"
 
 namespace radlib {
 
@@ -43,9 +44,9 @@ namespace radlib {
         unsigned int _symbolLength;
         unsigned int _markFreq;
         unsigned int _spaceFreq;
-        // In order to maintain phase continuity we keep the phase
+        // In order to maintain phase continuity the oscillator is kept
         // between tones.
-        float _phi;
+        NCO _nco;
     };
 }
 
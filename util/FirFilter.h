@@ -0,0 +1,160 @@
+/*
+Copyright (C) 2024 - Bruce MacKinnon KC1FSZ
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef _FirFilter_h
+#define _FirFilter_h
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+#include "fixed_math.h"
+#include "dsp_util.h"
+
+namespace radlib {
+
+/**
+ * The multiply-accumulate kernels used by FirFilter.  The q15 kernels use
+ * SIMD when it is available (see simd_q15.h).
+ */
+template <class T> struct FirKernel { };
+
+template <> struct FirKernel<q15> {
+    static q15 fir(const q15* h, const q15* x, uint16_t taps) {
+        return _round(fir_q15(h, x, taps));
+    }
+    static q15 firSym(const q15* h, const q15* x, uint16_t taps) {
+        return _round(fir_sym_q15(h, x, taps));
+    }
+    // Round back to q15
+    static q15 _round(q31 acc) {
+        return (q15)((acc + (1 << 14)) >> 15);
+    }
+};
+
+template <> struct FirKernel<f32> {
+    static f32 fir(const f32* h, const f32* x, uint16_t taps) {
+        return fir_f32(h, x, taps);
+    }
+    static f32 firSym(const f32* h, const f32* x, uint16_t taps) {
+        return fir_sym_f32(h, x, taps);
+    }
+};
+
+/**
+ * A streaming FIR filter for q15 or f32 samples.  The state is kept 
+ * between calls, so a continuous stream can be processed a sample or a 
+ * block at a time with the same result.
+ *
+ * The delay line is double length: each sample is written twice (taps 
+ * apart), so the most recent taps samples are always contiguous, newest
+ * first.  The dot product never has to wrap or check for the ends.
+ *
+ * When the coefficients are symmetric (h[i] = h[taps - 1 - i], with an 
+ * odd number of taps) only the first half are needed and the samples that
+ * share a coefficient are added first, which halves the multiplies.
+ *
+ * For q15, the accumulation is q30 in 32 bits and the output is rounded.
+ * The sum of the products must fit (i.e. sum(|h|) * max(|x|) < 1 for 
+ * a q15 result).
+ *
+ * There is no internal memory allocation/deallocation.
+ *
+ * @param T The sample/coefficient type (q15 or f32).
+ */
+template <class T>
+class FirFilter {
+public:
+
+    /**
+     * @param h The coefficients.  For a symmetric filter only the first 
+     *   taps / 2 + 1 are used.  These are not copied.
+     * @param taps The number of coefficients (must be odd if symmetric).
+     * @param symmetric Set to true to use the symmetric kernel.
+     * @param historySpace Space for the delay line.  See 
+     *   historySpaceSize().
+     */
+    FirFilter(const T* h, uint16_t taps, bool symmetric, T* historySpace)
+    :   _history(historySpace) {
+        setCoefficients(h, taps, symmetric);
+    }
+
+    /**
+     * @returns The number of entries needed for the history space.
+     */
+    static constexpr uint16_t historySpaceSize(uint16_t taps) {
+        return 2 * taps;
+    }
+
+    /**
+     * Changes the filter.  The history space must be large enough for 
+     * the new number of taps.  This clears the history.
+     */
+    void setCoefficients(const T* h, uint16_t taps, bool symmetric) {
+        _h = h;
+        _taps = taps;
+        _symmetric = symmetric;
+        reset();
+    }
+
+    /**
+     * Clears the history (i.e. back to all zeros).
+     */
+    void reset() {
+        memset((void*)_history, 0, historySpaceSize(_taps) * sizeof(T));
+        _ptr = 0;
+    }
+
+    /**
+     * Filters the next sample of the stream.
+     *
+     * @returns The filter output.
+     */
+    T process(T x) {
+        // The history runs backwards
+        _ptr = (_ptr == 0) ? _taps - 1 : _ptr - 1;
+        T* h = _history + _ptr;
+        h[0] = x;
+        h[_taps] = x;
+        return _symmetric ? FirKernel<T>::firSym(_h, h, _taps) : 
+            FirKernel<T>::fir(_h, h, _taps);
+    }
+
+    /**
+     * Filters the next n samples of the stream.
+     *
+     * @param out The filtered samples.  This can be the same as in.
+     */
+    void process(const T* in, T* out, size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            out[i] = process(in[i]);
+        }
+    }
+
+    uint16_t getTaps() const { return _taps; }
+
+private:
+
+    const T* _h;
+    uint16_t _taps;
+    bool _symmetric;
+    T* _history;
+    // The position of the newest sample
+    uint16_t _ptr = 0;
+};
+
+}
+
+#endif
@@ -0,0 +1,90 @@
+/*
+Copyright (C) 2024 - Bruce MacKinnon KC1FSZ
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <cmath>
+
+#include "NCO.h"
+
+namespace radlib {
+
+static const uint16_t TABLE_N = 1 << NCO::LOG2_TABLE_N;
+
+/**
+ * The quarter-wave tables.  There are two extra entries so that the 
+ * interpolation never has to check for the end (the entry past the top 
+ * is never weighted).
+ */
+struct NCOTables {
+    q15 q15Table[TABLE_N + 2];
+    float f32Table[TABLE_N + 2];
+    NCOTables() {
+        for (uint16_t i = 0; i <= TABLE_N + 1; i++) {
+            const double s = std::sin((double)i * 3.14159265358979323846 / (2.0 * (double)TABLE_N));
+            const long v = std::lround(s * 32768.0);
+            q15Table[i] = (q15)(v > 32767 ? 32767 : v);
+            f32Table[i] = (float)s;
+        }
+    }
+};
+
+static const NCOTables& nco_tables() {
+    static const NCOTables tables;
+    return tables;
+}
+
+NCO::NCO(float sampleFreq, float toneFreq, float phaseDegrees) 
+:   _sampleFreq(sampleFreq),
+    _f32Table(_getF32Table()),
+    _q15Table(_getQ15Table()) {
+    setFrequency(toneFreq);
+    setPhase(phaseDegrees);
+}
+
+void NCO::setFrequency(float toneFreq) {
+    _increment = phaseIncrement(_sampleFreq, toneFreq);
+}
+
+void NCO::setPhase(float phaseDegrees) {
+    _phase = phaseFromDegrees(phaseDegrees);
+}
+
+uint32_t NCO::phaseIncrement(float sampleFreq, float toneFreq) {
+    // Negative frequencies wrap around to the top of the range
+    const double cycles = std::fmod((double)toneFreq / (double)sampleFreq, 1.0);
+    return (uint32_t)(int64_t)std::llround(cycles * 4294967296.0);
+}
+
+uint32_t NCO::phaseFromDegrees(float degrees) {
+    const double cycles = std::fmod((double)degrees / 360.0, 1.0);
+    return (uint32_t)(int64_t)std::llround(cycles * 4294967296.0);
+}
+
+const float* NCO::_getF32Table() {
+    return nco_tables().f32Table;
+}
+
+const q15* NCO::_getQ15Table() {
+    return nco_tables().q15Table;
+}
+
+float NCO::sinF32(uint32_t phase, bool interpolate) {
+    return _sinF32(_getF32Table(), phase, interpolate);
+}
+
+q15 NCO::sinQ15(uint32_t phase, bool interpolate) {
+    return _sinQ15(_getQ15Table(), phase, interpolate);
+}
+
+}
@@ -0,0 +1,182 @@
+/*
+Copyright (C) 2024 - Bruce MacKinnon KC1FSZ
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef _NCO_h
+#define _NCO_h
+
+#include <cstdint>
+
+#include "fixed_math.h"
+#include "dsp_util.h"
+
+namespace radlib {
+
+/**
+ * A numerically-controlled oscillator: a 32-bit phase accumulator and a
+ * quarter-wave sine table.  A full cycle is 2^32, so the phase wraps 
+ * exactly and the output stays continuous and accurate no matter how 
+ * long it runs.  The frequency resolution is sampleFreq / 2^32.
+ *
+ * The table has 2^LOG2_TABLE_N entries per quarter wave (in both q15 and
+ * f32).  By itself that is good to about 1.5e-3 (spurs around -56 dB).
+ * Linear interpolation between the entries (the default) brings the
+ * error down to about 3e-7, which is as good as float std::cos() for 
+ * tones, at about the same cost as the plain lookup.
+ *
+ * Frequency changes keep the phase, so FSK transmissions are 
+ * continuous-phase.
+ *
+ * There is no internal memory allocation/deallocation.  The tables are 
+ * shared by all instances.
+ */
+class NCO {
+public:
+
+    static const uint16_t LOG2_TABLE_N = 10;
+
+    /**
+     * @param sampleFreq The output sample rate.
+     * @param toneFreq The tone frequency (can be negative).
+     * @param phaseDegrees The starting phase.
+     */
+    NCO(float sampleFreq, float toneFreq = 0, float phaseDegrees = 0);
+
+    /**
+     * Changes the frequency without disturbing the phase.
+     */
+    void setFrequency(float toneFreq);
+
+    void setPhase(float phaseDegrees);
+
+    /**
+     * Controls the linear interpolation between the table entries.  This
+     * is on by default.
+     */
+    void setInterpolationEnabled(bool en) { _interpolate = en; }
+
+    uint32_t getPhase() const { return _phase; }
+
+    uint32_t getPhaseIncrement() const { return _increment; }
+
+    /**
+     * @returns The cosine at the current phase and then moves to the 
+     *   next sample.
+     */
+    float nextF32() {
+        const float r = _sinF32(_f32Table, _phase + QUARTER, _interpolate);
+        _phase += _increment;
+        return r;
+    }
+
+    q15 nextQ15() {
+        const q15 r = _sinQ15(_q15Table, _phase + QUARTER, _interpolate);
+        _phase += _increment;
+        return r;
+    }
+
+    /**
+     * @returns cos + j sin at the current phase and then moves to the next
+     *   sample.
+     */
+    cf32 nextComplexF32() {
+        const cf32 r(_sinF32(_f32Table, _phase + QUARTER, _interpolate), 
+            _sinF32(_f32Table, _phase, _interpolate));
+        _phase += _increment;
+        return r;
+    }
+
+    cq15 nextComplexQ15() {
+        cq15 r;
+        r.r = _sinQ15(_q15Table, _phase + QUARTER, _interpolate);
+        r.i = _sinQ15(_q15Table, _phase, _interpolate);
+        _phase += _increment;
+        return r;
+    }
+
+    /**
+     * @param phase The phase, where 2^32 is a full cycle.
+     */
+    static float sinF32(uint32_t phase, bool interpolate = true);
+
+    /**
+     * @param phase The phase, where 2^32 is a full cycle.
+     * @returns The sine, limited to 32767 at the top.
+     */
+    static q15 sinQ15(uint32_t phase, bool interpolate = true);
+
+    /**
+     * @returns The phase increment (2^32 = a full cycle) for a frequency.
+     */
+    static uint32_t phaseIncrement(float sampleFreq, float toneFreq);
+
+    /**
+     * @returns The phase (2^32 = a full cycle) for an angle.
+     */
+    static uint32_t phaseFromDegrees(float degrees);
+
+private:
+
+    static const uint32_t QUARTER = 0x40000000;
+    // The bits of a quarter-wave phase below the table index
+    static const uint16_t FRAC_BITS = 30 - LOG2_TABLE_N;
+
+    static const float* _getF32Table();
+    static const q15* _getQ15Table();
+
+    /**
+     * The second and fourth quadrants run backwards through the table, 
+     * the third and fourth are negative.  The table has an extra entry 
+     * at the end so that the interpolation never has to check.
+     */
+    static float _sinF32(const float* table, uint32_t phase, bool interpolate) {
+        uint32_t p = phase & (QUARTER - 1);
+        if (phase & QUARTER) {
+            p = QUARTER - p;
+        }
+        const float* t = table + (p >> FRAC_BITS);
+        float r = t[0];
+        if (interpolate) {
+            const float frac = (float)(p & ((1 << FRAC_BITS) - 1)) * (1.0f / (float)(1 << FRAC_BITS));
+            r += (t[1] - t[0]) * frac;
+        }
+        return (phase & (2 * QUARTER)) ? -r : r;
+    }
+
+    static q15 _sinQ15(const q15* table, uint32_t phase, bool interpolate) {
+        uint32_t p = phase & (QUARTER - 1);
+        if (phase & QUARTER) {
+            p = QUARTER - p;
+        }
+        const q15* t = table + (p >> FRAC_BITS);
+        int32_t r = t[0];
+        if (interpolate) {
+            // The fraction is cut to 15 bits so that the product fits
+            const int32_t frac = (int32_t)((p & ((1 << FRAC_BITS) - 1)) >> (FRAC_BITS - 15));
+            r += ((int32_t)(t[1] - t[0]) * frac + (1 << 14)) >> 15;
+        }
+        return (phase & (2 * QUARTER)) ? (q15)-r : (q15)r;
+    }
+
+    const float _sampleFreq;
+    const float* _f32Table;
+    const q15* _q15Table;
+    uint32_t _phase = 0;
+    uint32_t _increment = 0;
+    bool _interpolate = true;
+};
+
+}
+
+#endif
@@ -0,0 +1,193 @@
+/*
+Copyright (C) 2024 - Bruce MacKinnon KC1FSZ
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <cstring>
+#include <cmath>
+
+#include "PolyphaseChannelizer.h"
+
+namespace radlib {
+
+/**
+ * @returns One tap of the prototype filter before it is scaled.
+ */
+static float channelizer_tap(uint16_t i, uint16_t m, uint16_t l) {
+    // Sinc with a cutoff of half the channel spacing
+    const float t = ((float)i - (float)(l - 1) / 2.0f) / (float)m;
+    const float sinc = (t == 0) ? 1.0f : std::sin(pi() * t) / (pi() * t);
+    // Blackman window
+    const float a = 2.0f * pi() * (float)i / (float)(l - 1);
+    return sinc * (0.42f - 0.5f * std::cos(a) + 0.08f * std::cos(2.0f * a));
+}
+
+/**
+ * @returns The scale that gives the prototype filter a DC gain of m.  This
+ *   cancels the 1/m of the FFT, and the remaining 1/2 comes from the real
+ *   input's negative frequency being rejected.
+ */
+static float channelizer_scale(uint16_t m, uint16_t l) {
+    float sum = 0;
+    for (uint16_t i = 0; i < l; i++) {
+        sum += channelizer_tap(i, m, l);
+    }
+    return (float)m / sum;
+}
+
+void make_channelizer_filter(float* h, uint16_t m, uint16_t tapsPerBranch) {
+    const uint16_t l = m * tapsPerBranch;
+    const float scale = channelizer_scale(m, l);
+    for (uint16_t i = 0; i < l; i++) {
+        h[i] = channelizer_tap(i, m, l) * scale;
+    }
+}
+
+// ===== FixedChannelizer ======================================================
+
+FixedChannelizer::FixedChannelizer(uint16_t log2ChannelN, uint16_t tapsPerBranch, 
+    q15* fftTrigTableSpace, q15* filterSpace, q15* historySpace, cq15* outputSpace)
+:   _m(1 << log2ChannelN),
+    _l(_m * tapsPerBranch),
+    _filter(filterSpace),
+    _history(historySpace),
+    _output(outputSpace),
+    _fft(_m, fftTrigTableSpace) {
+
+    // The peak tap is close to 1.0, so one integer bit is used
+    const float scale = channelizer_scale(_m, _l);
+    for (uint16_t i = 0; i < _l; i++) {
+        _filter[i] = (q15)std::round(channelizer_tap(i, _m, _l) * scale * 16384.0f);
+    }
+
+    reset();
+}
+
+void FixedChannelizer::reset() {
+    memset((void*)_history, 0, 2 * _l * sizeof(q15));
+    _historyPtr = 0;
+    _phase = 0;
+    _oddOutput = false;
+}
+
+bool FixedChannelizer::processSample(q15 sample) {
+
+    // The history runs backwards and each sample is written twice so that 
+    // the most recent _l samples are always contiguous, starting with the
+    // newest.
+    if (_historyPtr-- == 0) {
+        _historyPtr = _l - 1;
+    }
+    _history[_historyPtr] = sample;
+    _history[_historyPtr + _l] = sample;
+
+    if (++_phase < _m / 2) {
+        return false;
+    }
+    _phase = 0;
+
+    // Each FFT input is the output of one branch of the filter bank.  Branch
+    // p sees every M'th tap starting at p.
+    const q15* x = _history + _historyPtr;
+    for (uint16_t p = 0; p < _m; p++) {
+        q31 acc = 0;
+        for (uint16_t i = p; i < _l; i += _m) {
+            acc += (q31)_filter[i] * (q31)x[i];
+        }
+        acc = (acc + (1 << 13)) >> 14;
+        if (acc > 32767) {
+            acc = 32767;
+        } else if (acc < -32768) {
+            acc = -32768;
+        }
+        _output[p].r = (q15)acc;
+        _output[p].i = 0;
+    }
+
+    _fft.transform(_output);
+
+    // The FFT runs in the opposite direction of the mixing, so the results 
+    // are conjugated.  The decimation by M/2 also leaves the odd channels 
+    // with a phase that flips on every other output.
+    for (uint16_t k = 0; k < _m; k++) {
+        if (_oddOutput && (k & 1)) {
+            _output[k].r = -_output[k].r;
+        } else {
+            _output[k].i = -_output[k].i;
+        }
+    }
+    _oddOutput = !_oddOutput;
+
+    return true;
+}
+
+// ===== F32Channelizer ========================================================
+
+F32Channelizer::F32Channelizer(uint16_t log2ChannelN, uint16_t tapsPerBranch, 
+    float* fftTrigTableSpace, float* filterSpace, float* historySpace, cf32* outputSpace)
+:   _m(1 << log2ChannelN),
+    _l(_m * tapsPerBranch),
+    _filter(filterSpace),
+    _history(historySpace),
+    _output(outputSpace),
+    _fft(_m, fftTrigTableSpace) {
+    make_channelizer_filter(_filter, _m, tapsPerBranch);
+    reset();
+}
+
+void F32Channelizer::reset() {
+    memset((void*)_history, 0, 2 * _l * sizeof(float));
+    _historyPtr = 0;
+    _phase = 0;
+    _oddOutput = false;
+}
+
+bool F32Channelizer::processSample(float sample) {
+
+    // Same layout as the FixedChannelizer
+    if (_historyPtr-- == 0) {
+        _historyPtr = _l - 1;
+    }
+    _history[_historyPtr] = sample;
+    _history[_historyPtr + _l] = sample;
+
+    if (++_phase < _m / 2) {
+        return false;
+    }
+    _phase = 0;
+
+    const float* x = _history + _historyPtr;
+    for (uint16_t p = 0; p < _m; p++) {
+        float acc = 0;
+        for (uint16_t i = p; i < _l; i += _m) {
+            acc += _filter[i] * x[i];
+        }
+        _output[p].r = acc;
+        _output[p].i = 0;
+    }
+
+    _fft.transform(_output);
+
+    for (uint16_t k = 0; k < _m; k++) {
+        if (_oddOutput && (k & 1)) {
+            _output[k].r = -_output[k].r;
+        } else {
+            _output[k].i = -_output[k].i;
+        }
+    }
+    _oddOutput = !_oddOutput;
+
+    return true;
+}
+
+}
@@ -0,0 +1,169 @@
+/*
+Copyright (C) 2024 - Bruce MacKinnon KC1FSZ
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef _PolyphaseChannelizer_h
+#define _PolyphaseChannelizer_h
+
+#include <cstdint>
+
+#include "fixed_math.h"
+#include "fixed_fft.h"
+#include "f32_fft.h"
+#include "dsp_util.h"
+
+namespace radlib {
+
+/**
+ * Splits a real input signal into M equally-spaced channels (M a power of 
+ * 2) using a polyphase filter bank and one M-point FFT per output.  Channel 
+ * k is centered on k * sampleFreq / M and comes out as complex baseband 
+ * (i.e. the channel center is moved to 0 Hz).
+ *
+ * The outputs are decimated by M/2, so each channel is sampled at 
+ * 2 * sampleFreq / M.  That is twice the channel spacing, which leaves
+ * room for a signal that isn't right in the middle of a channel.  For 
+ * example, with an 8 kHz input and M = 8 the channels are 1 kHz apart
+ * and each one is sampled at 2 kHz (the Demodulator's design rate).
+ *
+ * The prototype filter is a Blackman windowed-sinc low-pass with a cutoff 
+ * of half the channel spacing and M * tapsPerBranch taps.  It is scaled 
+ * so that a real tone of amplitude A shows up as a complex tone of 
+ * amplitude A/2 in its channel.
+ *
+ * Only channels 0 to M/2 carry any information for a real input.  The
+ * rest are the mirror images (complex conjugates) of those.
+ *
+ * This is the fixed-point version.  See F32Channelizer for floating-point.
+ *
+ * There is no internal memory allocation/deallocation.
+ */
+class FixedChannelizer {
+public:
+
+    /**
+     * @param log2ChannelN The number of channels (M) in log terms.
+     * @param tapsPerBranch The length of each branch of the filter bank. 
+     *   Longer branches give sharper channel edges.
+     * @param fftTrigTableSpace Space for the FFT trig table (M).
+     * @param filterSpace Space for the prototype filter.  See 
+     *   filterSpaceSize().
+     * @param historySpace Space for the input history.  See 
+     *   historySpaceSize().
+     * @param outputSpace Space for the channel outputs (M).
+     */
+    FixedChannelizer(uint16_t log2ChannelN, uint16_t tapsPerBranch, 
+        q15* fftTrigTableSpace, q15* filterSpace, q15* historySpace, 
+        cq15* outputSpace);
+
+    static constexpr uint16_t filterSpaceSize(uint16_t log2ChannelN, uint16_t tapsPerBranch) {
+        return (1 << log2ChannelN) * tapsPerBranch;
+    }
+
+    static constexpr uint16_t historySpaceSize(uint16_t log2ChannelN, uint16_t tapsPerBranch) {
+        return 2 * (1 << log2ChannelN) * tapsPerBranch;
+    }
+
+    /**
+     * Clears the input history.
+     */
+    void reset();
+
+    /**
+     * Call this function at the input sample rate.
+     *
+     * @returns true when a new set of channel outputs is ready (every 
+     *   M/2 samples).
+     */
+    bool processSample(q15 sample);
+
+    /**
+     * @returns The latest output of every channel, indexed by channel 
+     *   number.  The values are only valid right after processSample()
+     *   has returned true.
+     */
+    const cq15* getOutputs() const { return _output; }
+
+    uint16_t getChannelCount() const { return _m; }
+
+    uint16_t getDecimation() const { return _m / 2; }
+
+private:
+
+    const uint16_t _m;
+    const uint16_t _l;
+    // The prototype filter with one integer bit (i.e. 1.0 = 16384)
+    q15* _filter;
+    q15* _history;
+    cq15* _output;
+    FixedFFT _fft;
+    uint16_t _historyPtr = 0;
+    uint16_t _phase = 0;
+    bool _oddOutput = false;
+};
+
+/**
+ * The floating-point version of the FixedChannelizer.  The outputs are 
+ * in the same form.
+ *
+ * There is no internal memory allocation/deallocation.
+ */
+class F32Channelizer {
+public:
+
+    F32Channelizer(uint16_t log2ChannelN, uint16_t tapsPerBranch, 
+        float* fftTrigTableSpace, float* filterSpace, float* historySpace, 
+        cf32* outputSpace);
+
+    static constexpr uint16_t filterSpaceSize(uint16_t log2ChannelN, uint16_t tapsPerBranch) {
+        return (1 << log2ChannelN) * tapsPerBranch;
+    }
+
+    static constexpr uint16_t historySpaceSize(uint16_t log2ChannelN, uint16_t tapsPerBranch) {
+        return 2 * (1 << log2ChannelN) * tapsPerBranch;
+    }
+
+    void reset();
+
+    bool processSample(float sample);
+
+    const cf32* getOutputs() const { return _output; }
+
+    uint16_t getChannelCount() const { return _m; }
+
+    uint16_t getDecimation() const { return _m / 2; }
+
+private:
+
+    const uint16_t _m;
+    const uint16_t _l;
+    float* _filter;
+    float* _history;
+    cf32* _output;
+    F32FFT _fft;
+    uint16_t _historyPtr = 0;
+    uint16_t _phase = 0;
+    bool _oddOutput = false;
+};
+
+/**
+ * Fills in the prototype filter that is used by both channelizers.
+ * 
+ * @param h Space for m * tapsPerBranch taps.
+ */
+void make_channelizer_filter(float* h, uint16_t m, uint16_t tapsPerBranch);
+
+}
+
+#endif
@@ -0,0 +1,168 @@
+/*
+Copyright (C) 2024 - Bruce MacKinnon KC1FSZ
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <cstring>
+#include <cmath>
+
+#include "Resampler.h"
+
+namespace radlib {
+
+/**
+ * @returns One tap of the prototype filter before it is scaled.
+ */
+static float resampler_tap(uint16_t i, uint16_t r, uint16_t l) {
+    // Sinc with a cutoff of half the lower sample rate (at L times the 
+    // input rate)
+    const float t = ((float)i - (float)(l - 1) / 2.0f) / (float)r;
+    const float sinc = (t == 0) ? 1.0f : std::sin(pi() * t) / (pi() * t);
+    // Blackman window
+    const float a = 2.0f * pi() * (float)i / (float)(l - 1);
+    return sinc * (0.42f - 0.5f * std::cos(a) + 0.08f * std::cos(2.0f * a));
+}
+
+/**
+ * @returns The scale that gives the prototype filter a DC gain of L.  Only
+ *   one of every L samples going into the filter is real, so that gives 
+ *   unity gain overall.
+ */
+static float resampler_scale(uint16_t up, uint16_t r, uint16_t l) {
+    float sum = 0;
+    for (uint16_t i = 0; i < l; i++) {
+        sum += resampler_tap(i, r, l);
+    }
+    return (float)up / sum;
+}
+
+void make_resampler_filter(float* h, uint16_t up, uint16_t down, uint16_t tapsPerBranch) {
+    const uint16_t r = (up > down) ? up : down;
+    const uint16_t l = r * tapsPerBranch;
+    const uint16_t phaseTaps = FixedResampler::phaseTaps(up, down, tapsPerBranch);
+    const float scale = resampler_scale(up, r, l);
+    // The last phases may be one tap short
+    memset((void*)h, 0, up * phaseTaps * sizeof(float));
+    for (uint16_t i = 0; i < l; i++) {
+        h[(i % up) * phaseTaps + i / up] = resampler_tap(i, r, l) * scale;
+    }
+}
+
+// ===== FixedResampler ========================================================
+
+FixedResampler::FixedResampler(uint16_t up, uint16_t down, uint16_t tapsPerBranch,
+    q15* filterSpace, q15* historySpace)
+:   _up(up),
+    _down(down),
+    _phaseTaps(phaseTaps(up, down, tapsPerBranch)),
+    _filter(filterSpace),
+    _history(historySpace) {
+
+    // The center tap of an interpolator is close to 1.0, so one integer 
+    // bit is used
+    const uint16_t r = (up > down) ? up : down;
+    const uint16_t l = r * tapsPerBranch;
+    const float scale = resampler_scale(up, r, l);
+    memset((void*)_filter, 0, _up * _phaseTaps * sizeof(q15));
+    for (uint16_t i = 0; i < l; i++) {
+        _filter[(i % up) * _phaseTaps + i / up] = 
+            (q15)std::round(resampler_tap(i, r, l) * scale * 16384.0f);
+    }
+
+    reset();
+}
+
+void FixedResampler::reset() {
+    memset((void*)_history, 0, 2 * _phaseTaps * sizeof(q15));
+    _historyPtr = 0;
+    _nextPhase = 0;
+}
+
+unsigned int FixedResampler::process(const q15* in, unsigned int n, q15* out) {
+
+    unsigned int outN = 0;
+
+    for (unsigned int k = 0; k < n; k++) {
+
+        // The history runs backwards and each sample is written twice so 
+        // that the most recent samples are always contiguous, starting 
+        // with the newest.
+        if (_historyPtr-- == 0) {
+            _historyPtr = _phaseTaps - 1;
+        }
+        _history[_historyPtr] = in[k];
+        _history[_historyPtr + _phaseTaps] = in[k];
+
+        // Produce all of the outputs that fall between this input and 
+        // the next one.  For a decimator most inputs produce nothing.
+        const q15* x = _history + _historyPtr;
+        while (_nextPhase < _up) {
+            q31 acc = fir_q15(_filter + _nextPhase * _phaseTaps, x, _phaseTaps);
+            acc = (acc + (1 << 13)) >> 14;
+            if (acc > 32767) {
+                acc = 32767;
+            } else if (acc < -32768) {
+                acc = -32768;
+            }
+            out[outN++] = (q15)acc;
+            _nextPhase += _down;
+        }
+        _nextPhase -= _up;
+    }
+
+    return outN;
+}
+
+// ===== F32Resampler ==========================================================
+
+F32Resampler::F32Resampler(uint16_t up, uint16_t down, uint16_t tapsPerBranch,
+    float* filterSpace, float* historySpace)
+:   _up(up),
+    _down(down),
+    _phaseTaps(FixedResampler::phaseTaps(up, down, tapsPerBranch)),
+    _filter(filterSpace),
+    _history(historySpace) {
+    make_resampler_filter(_filter, up, down, tapsPerBranch);
+    reset();
+}
+
+void F32Resampler::reset() {
+    memset((void*)_history, 0, 2 * _phaseTaps * sizeof(float));
+    _historyPtr = 0;
+    _nextPhase = 0;
+}
+
+unsigned int F32Resampler::process(const float* in, unsigned int n, float* out) {
+
+    unsigned int outN = 0;
+
+    // Same layout as the FixedResampler
+    for (unsigned int k = 0; k < n; k++) {
+        if (_historyPtr-- == 0) {
+            _historyPtr = _phaseTaps - 1;
+        }
+        _history[_historyPtr] = in[k];
+        _history[_historyPtr + _phaseTaps] = in[k];
+
+        const float* x = _history + _historyPtr;
+        while (_nextPhase < _up) {
+            out[outN++] = fir_f32(_filter + _nextPhase * _phaseTaps, x, _phaseTaps);
+            _nextPhase += _down;
+        }
+        _nextPhase -= _up;
+    }
+
+    return outN;
+}
+
+}
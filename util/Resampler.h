@@ -0,0 +1,173 @@
+/*
+Copyright (C) 2024 - Bruce MacKinnon KC1FSZ
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef _Resampler_h
+#define _Resampler_h
+
+#include <cstdint>
+
+#include "fixed_math.h"
+#include "dsp_util.h"
+
+namespace radlib {
+
+/**
+ * Changes the sample rate of a real signal by a rational factor L/M 
+ * (interpolate by L, then decimate by M) using a polyphase filter.  For 
+ * example, 48 kHz to 2 kHz is L = 1, M = 24 and 2 kHz to 48 kHz is 
+ * L = 24, M = 1.  Reduce the factors first: 44.1 kHz to 2 kHz is L = 20,
+ * M = 441.
+ *
+ * The anti-alias/anti-image filter runs at L times the input rate, but 
+ * only the outputs that are kept are computed, and only the taps that line
+ * up with real (non-zero-stuffed) input samples are used.  So each output 
+ * costs taps / L multiplies, whatever M is.
+ *
+ * The prototype filter is a Blackman windowed-sinc low-pass with a cutoff
+ * of half the lower of the two sample rates and max(L, M) * tapsPerBranch
+ * taps.  The transition band is about 11 / tapsPerBranch of the cutoff 
+ * wide, so 16 is a reasonable place to start.  The gain is 1.
+ *
+ * The delay is (taps - 1) / 2 samples at L times the input rate.
+ *
+ * This is the fixed-point version.  See F32Resampler for floating-point.
+ *
+ * There is no internal memory allocation/deallocation.
+ */
+class FixedResampler {
+public:
+
+    /**
+     * @param up The interpolation factor (L).
+     * @param down The decimation factor (M).
+     * @param tapsPerBranch Controls the length of the filter.  Longer
+     *   filters give sharper edges.
+     * @param filterSpace Space for the polyphase filter.  See 
+     *   filterSpaceSize().
+     * @param historySpace Space for the input history.  See 
+     *   historySpaceSize().
+     */
+    FixedResampler(uint16_t up, uint16_t down, uint16_t tapsPerBranch,
+        q15* filterSpace, q15* historySpace);
+
+    /**
+     * @returns The number of taps in each phase of the filter.
+     */
+    static constexpr uint16_t phaseTaps(uint16_t up, uint16_t down, uint16_t tapsPerBranch) {
+        return ((up > down ? up : down) * tapsPerBranch + up - 1) / up;
+    }
+
+    static constexpr uint16_t filterSpaceSize(uint16_t up, uint16_t down, uint16_t tapsPerBranch) {
+        return up * phaseTaps(up, down, tapsPerBranch);
+    }
+
+    static constexpr uint16_t historySpaceSize(uint16_t up, uint16_t down, uint16_t tapsPerBranch) {
+        return 2 * phaseTaps(up, down, tapsPerBranch);
+    }
+
+    /**
+     * @returns The most outputs that process() can produce for n inputs.
+     */
+    static constexpr unsigned int maxOutputs(uint16_t up, uint16_t down, unsigned int n) {
+        return (n * up + down - 1) / down;
+    }
+
+    /**
+     * Clears the input history.
+     */
+    void reset();
+
+    /**
+     * Resamples the next n samples of the stream.  The stream can be broken
+     * up any way, the result is the same.
+     *
+     * @param out Space for the outputs.  See maxOutputs().
+     * @returns The number of outputs produced.
+     */
+    unsigned int process(const q15* in, unsigned int n, q15* out);
+
+    uint16_t getUp() const { return _up; }
+
+    uint16_t getDown() const { return _down; }
+
+private:
+
+    const uint16_t _up;
+    const uint16_t _down;
+    const uint16_t _phaseTaps;
+    // The filter with one integer bit (i.e. 1.0 = 16384), grouped by 
+    // phase.
+    q15* _filter;
+    q15* _history;
+    uint16_t _historyPtr = 0;
+    // The phase of the next output relative to the newest input (in 
+    // 1/L input samples).
+    uint32_t _nextPhase = 0;
+};
+
+/**
+ * The floating-point version of the FixedResampler.
+ *
+ * There is no internal memory allocation/deallocation.
+ */
+class F32Resampler {
+public:
+
+    F32Resampler(uint16_t up, uint16_t down, uint16_t tapsPerBranch,
+        float* filterSpace, float* historySpace);
+
+    static constexpr uint16_t filterSpaceSize(uint16_t up, uint16_t down, uint16_t tapsPerBranch) {
+        return FixedResampler::filterSpaceSize(up, down, tapsPerBranch);
+    }
+
+    static constexpr uint16_t historySpaceSize(uint16_t up, uint16_t down, uint16_t tapsPerBranch) {
+        return FixedResampler::historySpaceSize(up, down, tapsPerBranch);
+    }
+
+    static constexpr unsigned int maxOutputs(uint16_t up, uint16_t down, unsigned int n) {
+        return FixedResampler::maxOutputs(up, down, n);
+    }
+
+    void reset();
+
+    unsigned int process(const float* in, unsigned int n, float* out);
+
+    uint16_t getUp() const { return _up; }
+
+    uint16_t getDown() const { return _down; }
+
+private:
+
+    const uint16_t _up;
+    const uint16_t _down;
+    const uint16_t _phaseTaps;
+    float* _filter;
+    float* _history;
+    uint16_t _historyPtr = 0;
+    uint32_t _nextPhase = 0;
+};
+
+/**
+ * Fills in the polyphase filter that is used by both resamplers.  Phase p
+ * is at h[p * phaseTaps], and tap j of that phase applies to the input 
+ * j samples back from the newest.
+ * 
+ * @param h Space for FixedResampler::filterSpaceSize() taps.
+ */
+void make_resampler_filter(float* h, uint16_t up, uint16_t down, uint16_t tapsPerBranch);
+
+}
+
+#endif
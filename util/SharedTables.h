@@ -0,0 +1,103 @@
+/*
+Copyright (C) 2024 - Bruce MacKinnon KC1FSZ
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef _SharedTables_h
+#define _SharedTables_h
+
+#include <cstdint>
+
+#include "fixed_math.h"
+#include "fixed_fft.h"
+#include "fixed_fft31.h"
+#include "f32_fft.h"
+#include "dsp_util.h"
+
+namespace radlib {
+
+/**
+ * The read-only tables used by the FFTs and the spectral analysis.  There
+ * is one copy of each table per size, shared by every instance that asks 
+ * for it.  A table is built the first time it is used (this is thread-safe) 
+ * so only the sizes that are actually used take up any memory.
+ *
+ * On a platform where RAM is tight a pre-generated const table (i.e. in 
+ * flash) can be passed to the const constructors instead.
+ *
+ * @param Log2N The size of the tables in log terms.
+ */
+template <uint16_t Log2N>
+class SharedTables {
+public:
+
+    static constexpr uint16_t N = 1 << Log2N;
+
+    /**
+     * @returns The FixedFFT trig table.
+     */
+    static const q15* fixedTrigTable() {
+        static const q15* table = FixedFFT::makeTrigTable(N, _fixedTrigSpace());
+        return table;
+    }
+
+    /**
+     * @returns The FixedFFT31 trig table.
+     */
+    static const q31* fixed31TrigTable() {
+        static const q31* table = FixedFFT31::makeTrigTable(N, _fixed31TrigSpace());
+        return table;
+    }
+
+    /**
+     * @returns The F32FFT trig table.
+     */
+    static const float* f32TrigTable() {
+        static const float* table = F32FFT::makeTrigTable(N, _f32TrigSpace());
+        return table;
+    }
+
+    /**
+     * @returns The Hann window.
+     */
+    static const q15* hannWindow() {
+        static const q15* table = make_hann_window_q15(_hannSpace(), N);
+        return table;
+    }
+
+private:
+
+    static q15* _fixedTrigSpace() {
+        static q15 space[N];
+        return space;
+    }
+
+    static q31* _fixed31TrigSpace() {
+        static q31 space[N];
+        return space;
+    }
+
+    static float* _f32TrigSpace() {
+        static float space[N];
+        return space;
+    }
+
+    static q15* _hannSpace() {
+        static q15 space[N];
+        return space;
+    }
+};
+
+}
+
+#endif
@@ -0,0 +1,99 @@
+/*
+Copyright (C) 2024 - Bruce MacKinnon KC1FSZ
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "SlidingCorrelator.h"
+
+namespace radlib {
+
+SlidingCorrelator::SlidingCorrelator(uint16_t log2WindowN, uint16_t log2TableN, 
+    const q15* trigTable, Product* historySpace)
+:   _log2WindowN(log2WindowN),
+    _log2TableN(log2TableN),
+    _trigTable(trigTable),
+    _history(historySpace) {
+    reset();
+}
+
+void SlidingCorrelator::setTone(uint16_t sampleFreq, float toneFreq) {
+    // Convert the frequency to a fraction of a cycle per sample
+    _phaseStep = (uint32_t)(int64_t)((double)toneFreq / (double)sampleFreq * 4294967296.0);
+    reset();
+}
+
+void SlidingCorrelator::reset() {
+    const uint16_t windowN = 1 << _log2WindowN;
+    for (uint16_t i = 0; i < windowN; i++) {
+        _history[i].r = 0;
+        _history[i].i = 0;
+    }
+    _historyPtr = 0;
+    _phase = 0;
+    _sumR = 0;
+    _sumI = 0;
+}
+
+void SlidingCorrelator::update(q15 sample) {
+
+    // Multiply by e^(-j phase) = cos() - j sin()
+    // NOTE: The trig table holds sin() / 2
+    const uint16_t idx = _nextIndex();
+    Product p;
+    p.r = (int32_t)sample * (int32_t)_trigTable[(idx + _quarter()) & _tableMask()];
+    p.i = -(int32_t)sample * (int32_t)_trigTable[idx];
+    _slide(p);
+}
+
+void SlidingCorrelator::update(cq15 sample) {
+
+    // (r + j i) * (cos() - j sin())
+    const uint16_t idx = _nextIndex();
+    const int32_t c = _trigTable[(idx + _quarter()) & _tableMask()];
+    const int32_t s = _trigTable[idx];
+    Product p;
+    p.r = (int32_t)sample.r * c + (int32_t)sample.i * s;
+    p.i = (int32_t)sample.i * c - (int32_t)sample.r * s;
+    _slide(p);
+}
+
+uint16_t SlidingCorrelator::_nextIndex() {
+    // Round the phase to the nearest table entry
+    const uint16_t idx = ((_phase + ((uint32_t)1 << (31 - _log2TableN))) 
+        >> (32 - _log2TableN)) & _tableMask();
+    _phase += _phaseStep;
+    return idx;
+}
+
+void SlidingCorrelator::_slide(Product p) {
+    // Swap the oldest product for the newest one
+    Product& old = _history[_historyPtr];
+    _sumR += p.r - old.r;
+    _sumI += p.i - old.i;
+    old = p;
+    _historyPtr = (_historyPtr + 1) & ((1 << _log2WindowN) - 1);
+}
+
+q15 SlidingCorrelator::getMagnitude() const {
+    // Each product is sample * (trig / 2), so after dividing by the window
+    // length the values are scaled by 2^30.  Bring them down to 2^16 (one 
+    // bit more than q15) so that the magnitude can be computed in 32 bits.
+    // The magnitude is at most 0.5, so the squares can't overflow.
+    const int32_t r = (int32_t)(_sumR >> (_log2WindowN + 14));
+    const int32_t i = (int32_t)(_sumI >> (_log2WindowN + 14));
+    const uint16_t mag = isqrt_u32((uint32_t)(r * r) + (uint32_t)(i * i));
+    // Round to q15
+    return (q15)((mag + 1) >> 1);
+}
+
+}
@@ -0,0 +1,128 @@
+/*
+Copyright (C) 2024 - Bruce MacKinnon KC1FSZ
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef _SlidingCorrelator_h
+#define _SlidingCorrelator_h
+
+#include <cstdint>
+
+#include "fixed_math.h"
+
+namespace radlib {
+
+/**
+ * An incremental matched filter that correlates the most recent samples of 
+ * a real (or complex) input stream with a complex tone.  This produces the 
+ * same magnitude as corr_q15_cq15_2() (or corr_cq15_cq15_2()) run against 
+ * a tone of amplitude 0.5, but 
+ * the work per sample is constant instead of being proportional to the 
+ * window length.
+ *
+ * Since the tone is a pure complex exponential, the correlation over 
+ * a window can be written as a fixed phase rotation (which doesn't change
+ * the magnitude) times the sum of each sample multiplied by a twiddle that 
+ * depends only on the sample's absolute position in the stream.  That sum 
+ * is maintained by adding the newest product and subtracting the oldest.  
+ * The products are kept in a history so the value that is subtracted is 
+ * exactly the value that was added - the sum can't drift.
+ *
+ * The twiddles are read from a trig table in the FixedFFT format using a
+ * 32-bit phase accumulator.  Everything is fixed point.
+ *
+ * There is no internal memory allocation/deallocation.
+ */
+class SlidingCorrelator {
+public:
+
+    /**
+     * One sample multiplied by its twiddle.
+     */
+    struct Product {
+        int32_t r = 0;
+        int32_t i = 0;
+    };
+
+    /**
+     * @param log2WindowN The length of the correlation window in log terms
+     *   (i.e. 4 for a 16 sample window).
+     * @param log2TableN The size of the trig table in log terms.
+     * @param trigTable A trig table in the format built by FixedFFT
+     *   (i.e. sin() scaled by 0.5). This can be shared with a FixedFFT
+     *   instance.
+     * @param historySpace Space for (1 << log2WindowN) products.
+     */
+    SlidingCorrelator(uint16_t log2WindowN, uint16_t log2TableN, 
+        const q15* trigTable, Product* historySpace);
+
+    /**
+     * Sets the tone frequency and clears the correlation window.
+     */
+    void setTone(uint16_t sampleFreq, float toneFreq);
+
+    /**
+     * Clears the correlation window.  This is consistent with a window
+     * full of zero samples.
+     */
+    void reset();
+
+    /**
+     * Slides the window forward by one sample.
+     */
+    void update(q15 sample);
+
+    /**
+     * Slides the window forward by one complex (I/Q) sample.  The sample
+     * magnitude must not be more than 1.0.
+     */
+    void update(cq15 sample);
+
+    /**
+     * @returns The magnitude of the correlation over the current window,
+     *   normalized by the window length.
+     */
+    q15 getMagnitude() const;
+
+private:
+
+    /**
+     * @returns The trig table index for the next sample's phase and moves
+     *   the phase forward.
+     */
+    uint16_t _nextIndex();
+
+    /**
+     * Adds the newest product to the window and drops the oldest.
+     */
+    void _slide(Product p);
+
+    uint16_t _tableMask() const { return (1 << _log2TableN) - 1; }
+    uint16_t _quarter() const { return 1 << (_log2TableN - 2); }
+
+    const uint16_t _log2WindowN;
+    const uint16_t _log2TableN;
+    const q15* _trigTable;
+    Product* _history;
+    uint16_t _historyPtr = 0;
+    // Phase of the next sample, where 2^32 is a full cycle
+    uint32_t _phase = 0;
+    uint32_t _phaseStep = 0;
+    // Running sum of the products in the window
+    int64_t _sumR = 0;
+    int64_t _sumI = 0;
+};
+
+}
+
+#endif
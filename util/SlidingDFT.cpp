@@ -0,0 +1,149 @@
+/*
+Copyright (C) 2024 - Bruce MacKinnon KC1FSZ
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "SlidingDFT.h"
+
+namespace radlib {
+
+static q15 clamp_q15(int64_t a) {
+    if (a > 32767) {
+        return 32767;
+    } else if (a < -32768) {
+        return -32768;
+    } else {
+        return (q15)a;
+    }
+}
+
+SlidingDFT::SlidingDFT(uint16_t log2N, uint16_t firstBin, uint16_t lastBin,
+    const q15* fftTrigTable, Bin* binSpace)
+:   _N(1 << log2N),
+    _log2N(log2N),
+    _firstBin(firstBin),
+    _lastBin(lastBin),
+    _trackFirstBin(firstBin > 0 ? firstBin - 1 : 0),
+    _trackLastBin(lastBin < (_N / 2) ? lastBin + 1 : _N / 2),
+    _trigTable(fftTrigTable),
+    _bins(binSpace) {
+    if (_bins != 0) {
+        reset();
+    }
+}
+
+void SlidingDFT::reset() {
+    for (uint16_t k = _trackFirstBin; k <= _trackLastBin; k++) {
+        _bins[k - _trackFirstBin].r = 0;
+        _bins[k - _trackFirstBin].i = 0;
+    }
+}
+
+void SlidingDFT::update(q15 newSample, q15 oldSample, uint16_t pos) {
+
+    // The change in the buffer at this position is all that matters
+    const int32_t d = (int32_t)newSample - (int32_t)oldSample;
+    if (d == 0) {
+        return;
+    }
+
+    const uint16_t mask = _N - 1;
+    const uint16_t quarter = _N >> 2;
+    // The twiddle index for bin k at this position is (k * pos) mod N.  This
+    // steps by pos for each successive bin.
+    uint16_t idx = ((uint32_t)_trackFirstBin * (uint32_t)pos) & mask;
+    Bin* bin = _bins;
+
+    for (uint16_t k = _trackFirstBin; k <= _trackLastBin; k++, bin++) {
+        // Multiply by e^(-j 2PI k pos / N) = cos() - j sin()
+        // NOTE: The trig table holds sin() / 2
+        bin->r += d * _trigTable[(idx + quarter) & mask];
+        bin->i -= d * _trigTable[idx];
+        idx = (idx + pos) & mask;
+    }
+}
+
+void SlidingDFT::resync(const q15* buffer) {
+    reset();
+    for (uint16_t p = 0; p < _N; p++) {
+        update(buffer[p], 0, p);
+    }
+}
+
+SlidingDFT::Bin SlidingDFT::_getBin(int16_t k) const {
+    // The input is real, so the spectrum is conjugate symmetric.  This
+    // allows the window to reach across bin 0 and bin N/2.
+    Bin result;
+    if (k < 0) {
+        const Bin& b = _bins[-k - _trackFirstBin];
+        result.r = b.r;
+        result.i = -b.i;
+    } else if (k > (int16_t)(_N / 2)) {
+        const Bin& b = _bins[_N - k - _trackFirstBin];
+        result.r = b.r;
+        result.i = -b.i;
+    } else {
+        result = _bins[k - _trackFirstBin];
+    }
+    return result;
+}
+
+void SlidingDFT::getSpectrum(cq15* result, uint16_t windowStart, bool hann) const {
+
+    const uint16_t mask = _N - 1;
+    const uint16_t quarter = _N >> 2;
+
+    // The rotation that shifts the window by one bin (used by the Hann window)
+    const int64_t ws = _trigTable[windowStart & mask];
+    const int64_t wc = _trigTable[(windowStart + quarter) & mask];
+
+    // The phase rotation needed to move bin k to the start of the window
+    // is e^(j 2PI k windowStart / N).  This steps by windowStart for each bin.
+    uint16_t idx = ((uint32_t)_firstBin * (uint32_t)windowStart) & mask;
+
+    // Each bin is (sum of sample * (trig / 2)), so the shift needed
+    // to get to the FixedFFT scale (DFT / N) is 14 + log2N.  The phase
+    // rotation adds another 14 bits.
+    const uint16_t shift = 28 + _log2N;
+
+    for (uint16_t k = _firstBin; k <= _lastBin; k++) {
+
+        Bin z = _getBin(k);
+
+        if (hann) {
+            // The Hann window in the frequency domain is:
+            //   0.5 X[k] - 0.25 X[k-1] - 0.25 X[k+1]
+            // where X is relative to the start of the window.
+            const Bin bm = _getBin(k - 1);
+            const Bin bp = _getBin(k + 1);
+            // X[k-1] relative to X[k] is rotated by e^(-j 2PI windowStart / N)
+            const int64_t ar = bm.r * wc + bm.i * ws;
+            const int64_t ai = bm.i * wc - bm.r * ws;
+            // X[k+1] relative to X[k] is rotated by e^(+j 2PI windowStart / N)
+            const int64_t cr = bp.r * wc - bp.i * ws;
+            const int64_t ci = bp.i * wc + bp.r * ws;
+            // Everything is scaled up by 2^16 (0.5 = 2^15, 0.25 * trig / 2 = 2^16)
+            z.r = ((z.r << 15) - ar - cr) >> 16;
+            z.i = ((z.i << 15) - ai - ci) >> 16;
+        }
+
+        const int64_t rs = _trigTable[idx];
+        const int64_t rc = _trigTable[(idx + quarter) & mask];
+        result[k].r = clamp_q15((z.r * rc - z.i * rs) >> shift);
+        result[k].i = clamp_q15((z.r * rs + z.i * rc) >> shift);
+
+        idx = (idx + windowStart) & mask;
+    }
+}
+
+}
@@ -0,0 +1,126 @@
+/*
+Copyright (C) 2024 - Bruce MacKinnon KC1FSZ
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef _SlidingDFT_h
+#define _SlidingDFT_h
+
+#include <cstdint>
+
+#include "fixed_math.h"
+
+namespace radlib {
+
+/**
+ * A sliding DFT that tracks a range of bins across an N-sample circular
+ * buffer, updating them incrementally as each sample arrives.  This is an
+ * alternative to running a complete FFT over the buffer every time a
+ * few new samples show up.
+ *
+ * This uses the "modulated" form of the sliding DFT: each bin accumulates
+ * the buffer contents multiplied by a twiddle that depends only on the
+ * position in the circular buffer.  When a sample is replaced the
+ * contribution of the old sample is removed using the same twiddle that was
+ * used to add it.  All of the accumulation is done with exact integer
+ * arithmetic so the bins never drift away from the buffer contents - there
+ * is no recursive rotation of the bin state.  The rotation needed to line
+ * the spectrum up with the start of the analysis window is applied only
+ * when the spectrum is read out.
+ *
+ * There is no internal memory allocation/deallocation.
+ */
+class SlidingDFT {
+public:
+
+    /**
+     * The accumulator for one bin.  Wide integers are used so that no
+     * scaling (and therefore no rounding) is needed during the update.
+     */
+    struct Bin {
+        int64_t r = 0;
+        int64_t i = 0;
+    };
+
+    /**
+     * @param log2N The size of the circular buffer/DFT.
+     * @param firstBin The first bin that will be returned by getSpectrum().
+     * @param lastBin The last bin that will be returned by getSpectrum().
+     * @param fftTrigTable A trig table in the format built by FixedFFT
+     *   for the same N (i.e. sin() scaled by 0.5). This can be shared
+     *   with a FixedFFT instance.
+     * @param binSpace Space for the bin accumulators.  See binSpaceSize().
+     */
+    SlidingDFT(uint16_t log2N, uint16_t firstBin, uint16_t lastBin,
+        const q15* fftTrigTable, Bin* binSpace);
+
+    /**
+     * @returns The number of Bin entries needed for the binSpace. One bin
+     *   is tracked on either side of the requested range to support the
+     *   frequency-domain window.
+     */
+    static constexpr uint16_t binSpaceSize(uint16_t firstBin, uint16_t lastBin) {
+        return (lastBin - firstBin) + 3;
+    }
+
+    /**
+     * Clears all bins.  This is consistent with a zeroed buffer.
+     */
+    void reset();
+
+    /**
+     * Call this each time a sample in the circular buffer is replaced.
+     *
+     * @param newSample The sample being written into the buffer.
+     * @param oldSample The sample that is being overwritten.
+     * @param pos The buffer location being written.
+     */
+    void update(q15 newSample, q15 oldSample, uint16_t pos);
+
+    /**
+     * Recomputes all bins directly from the buffer contents.  This is
+     * O(N * bins) so it should only be used when the bins have not been
+     * kept up to date (i.e. after updates were skipped).
+     */
+    void resync(const q15* buffer);
+
+    /**
+     * Produces the spectrum in the same format/scale as FixedFFT, as if
+     * the transform had been run on the buffer starting at windowStart.
+     * Only bins firstBin to lastBin (inclusive) are written.
+     *
+     * @param windowStart The buffer location of the first sample of the
+     *   analysis window.
+     * @param hann Set to true to apply a Hann window.  The window is
+     *   applied in the frequency domain.
+     */
+    void getSpectrum(cq15* result, uint16_t windowStart, bool hann) const;
+
+private:
+
+    Bin _getBin(int16_t k) const;
+
+    const uint16_t _N;
+    const uint16_t _log2N;
+    const uint16_t _firstBin;
+    const uint16_t _lastBin;
+    // The tracked bins extend one past the requested range on either side
+    const uint16_t _trackFirstBin;
+    const uint16_t _trackLastBin;
+    const q15* _trigTable;
+    Bin* _bins;
+};
+
+}
+
+#endif
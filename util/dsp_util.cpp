@@ -1,4 +1,5 @@
 #include "dsp_util.h"
+#include "NCO.h"
 
 namespace radlib {
 
@@ -45,6 +46,48 @@ uint16_t wrapIndex(uint16_t base, uint16_t disp, uint16_t size) {
     return target;
 }
 
+void load_real_fft_q15(cq15* out, const q15* buffer, uint16_t readBufferPtr, 
+    uint16_t fftN, q15 avg, const q15* window) {
+    for (uint16_t i = 0; i < fftN / 2; i++) {
+        const uint16_t n = 2 * i;
+        q15 x0 = buffer[wrapIndex(readBufferPtr, n, fftN)] - avg;
+        q15 x1 = buffer[wrapIndex(readBufferPtr, n + 1, fftN)] - avg;
+        if (window != 0) {
+            x0 = mult_q15(x0, window[n]);
+            x1 = mult_q15(x1, window[n + 1]);
+        }
+        out[i].r = x0;
+        out[i].i = x1;
+    }
+}
+
+const q15* make_hann_window_q15(q15* window, uint16_t n) {
+    if (window != 0) {
+        for (uint16_t i = 0; i < n; i++) {
+            window[i] = f32_to_q15(0.5 * (1.0 - std::cos(2.0 * pi() * ((float) i) / ((float)n))));
+        }
+    }
+    return window;
+}
+
+uint16_t make_bit_reverse_swaps(uint16_t* table, uint16_t log2n) {
+    const uint16_t n = 1 << log2n;
+    uint16_t count = 0;
+    for (uint16_t m = 1; m < n - 1; m++) {
+        uint16_t mr = 0;
+        for (uint16_t b = 0; b < log2n; b++) {
+            if (m & (1 << b)) {
+                mr |= 1 << (log2n - 1 - b);
+            }
+        }
+        if (mr > m) {
+            table[count++] = m;
+            table[count++] = mr;
+        }
+    }
+    return count;
+}
+
 
 static const float PI = std::atan(1.0) * 4.0;
 
@@ -62,13 +105,9 @@ void convert_f32_cf32(cf32* complexData, const float* realData, uint16_t n) {
 void visit_real_tone(uint32_t len, float sample_freq_hz, float tone_freq_hz,
     float amplitude, float phase_degrees, std::function<void(unsigned int idx, float y)> cb) {
 
-    float omega = 2.0f * pi() * (tone_freq_hz / sample_freq_hz);
-    float phi = 2.0f * pi() * (phase_degrees / 360.0);
-
+    NCO nco(sample_freq_hz, tone_freq_hz, phase_degrees);
     for (uint32_t i = 0; i < len; i++) {
-        float sig = std::cos(phi) * amplitude;
-        cb(i, sig);
-        phi += omega;
+        cb(i, nco.nextF32() * amplitude);
     }
 }
 
@@ -125,15 +164,11 @@ void make_real_tone_distorted(q15* output,
 void make_complex_tone_cq15(cq15* output, unsigned int len, float sample_freq_hz, 
     float tone_freq_hz, float amplitude, float phaseDegrees) {
 
-    float omega = 2.0f * pi() * (tone_freq_hz / sample_freq_hz);
-    float phi = 2.0f * pi() * (phaseDegrees / 360.0);
-
+    NCO nco(sample_freq_hz, tone_freq_hz, phaseDegrees);
     for (unsigned int i = 0; i < len; i++) {
-        float sig_i = std::cos(phi) * amplitude;
-        output[i].r = f32_to_q15(sig_i);
-        float sig_q = std::sin(phi) * amplitude;
-        output[i].i = f32_to_q15(sig_q);
-        phi += omega;
+        const cf32 sig = nco.nextComplexF32();
+        output[i].r = f32_to_q15(sig.r * amplitude);
+        output[i].i = f32_to_q15(sig.i * amplitude);
     }
 }
 
@@ -141,15 +176,11 @@ void make_complex_tone_cf32(cf32* output, uint32_t len,
     float sample_freq_hz, float tone_freq_hz, 
     float amplitude, float phase_degrees) {
 
-    float omega = 2.0f * pi() * (tone_freq_hz / sample_freq_hz);
-    float phi = 2.0f * pi() * (phase_degrees / 360.0);
-
+    NCO nco(sample_freq_hz, tone_freq_hz, phase_degrees);
     for (unsigned int i = 0; i < len; i++) {
-        float sig_i = std::cos(phi) * amplitude;
-        output[i].r = sig_i;
-        float sig_q = std::sin(phi) * amplitude;
-        output[i].i = sig_q;
-        phi += omega;
+        const cf32 sig = nco.nextComplexF32();
+        output[i].r = sig.r * amplitude;
+        output[i].i = sig.i * amplitude;
     }
 }
 
@@ -233,16 +264,26 @@ float corr_f32_cf32(const float* c0, const cf32* c1, uint16_t len) {
     return std::sqrt(result_r * result_r + result_i * result_i);
 }
 
-// TODO: CLEAN THIS UP FOR EFFICIENCY
 float corr_q15_cq15_2(const q15* c0, uint16_t c0Base, uint16_t c0Size,
     const cq15* c1, uint16_t c1Size) {
 
     float result_r = 0;
     float result_i = 0;
 
-    for (uint16_t i = 0; i < c1Size; i++) {
+    // The c0 series is visited in (at most) two contiguous segments: from 
+    // the base to the end of the circular buffer and then from the start
+    // of the buffer.  This avoids a wrap calculation on every tap.
+    const uint16_t c0Start = wrapIndex(c0Base, 0, c0Size);
+    uint16_t firstLen = c0Size - c0Start;
+    if (firstLen > c1Size) {
+        firstLen = c1Size;
+    }
+
+    const q15* p0 = c0 + c0Start;
+    uint16_t i = 0;
+    for (; i < firstLen; i++) {
         // Real value
-        float a = q15_to_f32(c0[wrapIndex(c0Base, i, c0Size)]);
+        float a = q15_to_f32(p0[i]);
         // Real value
         float c = q15_to_f32(c1[i].r);
         // Complex conjugate value
@@ -250,6 +291,13 @@ float corr_q15_cq15_2(const q15* c0, uint16_t c0Base, uint16_t c0Size,
         result_r += (a * c);
         result_i += (a * d);
     }
+    for (uint16_t j = 0; i < c1Size; i++, j++) {
+        float a = q15_to_f32(c0[j]);
+        float c = q15_to_f32(c1[i].r);
+        float d = -q15_to_f32(c1[i].i);
+        result_r += (a * c);
+        result_i += (a * d);
+    }
 
     // TODO: Improve efficiency
     result_r /= (float)c1Size;
@@ -268,6 +316,45 @@ float corr_q15_cq15_2(const q15* c0, uint16_t c0Base, uint16_t c0Size,
     */
 }
 
+float corr_cq15_cq15_2(const cq15* c0, uint16_t c0Base, uint16_t c0Size,
+    const cq15* c1, uint16_t c1Size) {
+
+    float result_r = 0;
+    float result_i = 0;
+
+    // Same two-segment walk as corr_q15_cq15_2()
+    const uint16_t c0Start = wrapIndex(c0Base, 0, c0Size);
+    uint16_t firstLen = c0Size - c0Start;
+    if (firstLen > c1Size) {
+        firstLen = c1Size;
+    }
+
+    const cq15* p0 = c0 + c0Start;
+    uint16_t i = 0;
+    for (; i < firstLen; i++) {
+        float a = q15_to_f32(p0[i].r);
+        float b = q15_to_f32(p0[i].i);
+        float c = q15_to_f32(c1[i].r);
+        // Complex conjugate
+        float d = -q15_to_f32(c1[i].i);
+        result_r += (a * c - b * d);
+        result_i += (a * d + b * c);
+    }
+    for (uint16_t j = 0; i < c1Size; i++, j++) {
+        float a = q15_to_f32(c0[j].r);
+        float b = q15_to_f32(c0[j].i);
+        float c = q15_to_f32(c1[i].r);
+        float d = -q15_to_f32(c1[i].i);
+        result_r += (a * c - b * d);
+        result_i += (a * d + b * c);
+    }
+
+    result_r /= (float)c1Size;
+    result_i /= (float)c1Size;
+
+    return std::sqrt(result_r * result_r + result_i * result_i);
+}
+
 /**
  * This is an out-of-the-book implementation to use for sanity checking.
 */
@@ -298,16 +385,33 @@ uint16_t maxMagIdx(const cf32* data, uint16_t start, uint16_t dataLen) {
     return maxIdx;
 }
 
+float fir_f32(const f32* h, const f32* x, uint16_t taps) {
+    float acc = 0;
+    for (uint16_t i = 0; i < taps; i++) {
+        acc += h[i] * x[i];
+    }
+    return acc;
+}
+
+float fir_sym_f32(const f32* h, const f32* x, uint16_t taps) {
+    const uint16_t half = taps / 2;
+    float acc = h[half] * x[half];
+    for (uint16_t i = 0; i < half; i++) {
+        acc += h[i] * (x[i] + x[taps - 1 - i]);
+    }
+    return acc;
+}
+
 void convolve_f32(f32* out, const f32* in, unsigned int N, const f32* h, 
     unsigned int HN) {
     for (unsigned int n = 0; n < N; n++) {
         float sumOfProducts = 0;
-        for (unsigned k = 0; k < HN; k++) {
-            // We convolve forward through the impulse response(h) and backwards
-            // through the signal (in). Pad the negative history of the signal 
-            // series with zeros.
-            f32 xPadded = (n >= k) ? in[n - k] : 0.0;
-            sumOfProducts += xPadded * h[k];
+        // We convolve forward through the impulse response(h) and backwards
+        // through the signal (in). The negative history of the signal 
+        // series is zero, so those taps are skipped.
+        const unsigned int kEnd = (n < HN) ? n + 1 : HN;
+        for (unsigned k = 0; k < kEnd; k++) {
+            sumOfProducts += in[n - k] * h[k];
         }
         out[n] = sumOfProducts;
     }
@@ -89,18 +89,53 @@ float corr_f32_cf32(const float* c0, const cf32* c1, uint16_t len);
 float corr_q15_cq15_2(const q15* c0, uint16_t c0Start, uint16_t c0Size, 
     const cq15* c1, uint16_t c1Size);
 
+/**
+ * The same as corr_q15_cq15_2() for a complex (I/Q) c0 series.
+ */
+float corr_cq15_cq15_2(const cq15* c0, uint16_t c0Start, uint16_t c0Size, 
+    const cq15* c1, uint16_t c1Size);
+
 /**
  * A utility function for dealing with circular buffers.  Result
  * is (base + disp) % size.
 */
 uint16_t wrapIndex(uint16_t base, uint16_t disp, uint16_t size);
 
+/**
+ * Loads the input of FixedFFT::transformReal() from a circular buffer of 
+ * real samples.  The fftN samples starting at readBufferPtr have avg 
+ * (the DC bias) removed and the window applied (if provided), and are 
+ * packed two per entry (even samples in the real part, odd samples in the
+ * imaginary part).
+ *
+ * @param out Space for fftN / 2 entries.
+ * @param window The fftN point window, or 0 for none.
+ */
+void load_real_fft_q15(cq15* out, const q15* buffer, uint16_t readBufferPtr, 
+    uint16_t fftN, q15 avg, const q15* window);
+
+/**
+ * Builds the list of index pairs that are exchanged by the bit-reversal
+ * phase of a 2^log2n point FFT (i.e. m, reverse(m) for each m < reverse(m)).
+ *
+ * @returns The number of entries written (two per swap), which is 
+ *   2^log2n - 2^ceil(log2n / 2).
+ */
+uint16_t make_bit_reverse_swaps(uint16_t* table, uint16_t log2n);
+
 /**
  * Visits points on a real-valued sinusoidal tone.
  */
 void visit_real_tone(uint32_t len, float sample_freq_hz, float tone_freq_hz,
     float amplitude, float phaseDegrees, std::function<void(uint32_t idx, float y)> cb);
 
+/**
+ * Builds a Hann window (raised cosine) of length n.
+ *
+ * @returns The window, or 0 if window is 0.
+ */
+const q15* make_hann_window_q15(q15* window, uint16_t n);
+
 /**
  * Fills a buffer with a real sinusoidal signal of the specified amplitude/frequency/
  * phase.
@@ -152,16 +187,36 @@ void simpleDFT(cf32* in, cf32* out, uint16_t fftN);
  */
 uint16_t maxMagIdx(const cf32* data, uint16_t start, uint16_t dataLen);
 
+/**
+ * The output of a FIR filter (any coefficients).
+ *
+ * @param h The coefficients.
+ * @param x The most recent taps samples (newest first).
+ */
+float fir_f32(const f32* h, const f32* x, uint16_t taps);
+
+/**
+ * The output of a symmetric FIR filter with an odd number of taps.  Only
+ * the first half of the coefficients (plus the center tap) are used.  The
+ * samples that share a coefficient are added before the multiply.
+ *
+ * @param h The coefficients (taps / 2 + 1 of them).
+ * @param x The most recent taps samples (newest first).
+ */
+float fir_sym_f32(const f32* h, const f32* x, uint16_t taps);
+
 /**
  * NOTE: The series is pre-padded with zeros and the last samples are 
- * ignored. This may not be desirable.
+ * ignored. This may not be desirable.  This is direct form, so see 
+ * Convolver for long filters and streams.
  */
 void convolve_f32(f32* sigQ, const f32* sigI, unsigned int n, const f32* h, 
     unsigned int hn);
 
 /**
  * NOTE: The series is pre-padded with zeros and the last samples are 
- * ignored. This may not be desirable.
+ * ignored. This may not be desirable.  This is direct form, so see 
+ * Convolver for long filters and streams.
  */
 void delay_f32(f32* out, const f32* in, unsigned int n, unsigned int delay);
 
@@ -28,17 +28,35 @@ Tom Roberts, and Malcolm Slaney (malcolm@interval.com).
 namespace radlib {
 
 F32FFT::F32FFT(uint16_t n, float* trigTable)
+:   N(n),
+    _cosTable(makeTrigTable(n, trigTable)) {
+}
+
+F32FFT::F32FFT(uint16_t n, const float* trigTable)
 :   N(n),
     _cosTable(trigTable) {
-    for (uint16_t i = 0; i < N; i++) {
-        _cosTable[CHK(i, N)] = (std::sin(TWO_PI * ((float) i) / (float)N));
+}
+
+const float* F32FFT::makeTrigTable(uint16_t n, float* trigTable) {
+    const float pi = std::atan(1.0) * 4.0;
+    const float twoPi = pi * 2.0f;
+    for (uint16_t i = 0; i < n; i++) {
+        trigTable[CHK(i, n)] = (std::sin(twoPi * ((float) i) / (float)n));
     }
+    return trigTable;
 }
 
 /**
  * Performs the FFT in-place. Meaning: the input series is overwritten.
  */
 void F32FFT::transform(cf32 f[]) const {
+    _transform(f, N);
+}
+
+void F32FFT::_transform(cf32 f[], uint16_t n) const {
+
+    const uint16_t log2n = (n == N) ? _log2N : _log2N - 1;
+    const uint16_t shiftAmount = (n == N) ? _shiftAmount : _halfShiftAmount;
 
     // One of the indices being swapped    
     uint16_t m;   
@@ -59,28 +77,48 @@ void F32FFT::transform(cf32 f[]) const {
     // The bit-reversal phase of the algorithm, based on this:
     // https://graphics.stanford.edu/~seander/bithacks.html#BitReverseObvious
 
-    for (m = 1; m < N - 1; m++) {
-        // Swap odd and even bits
-        mr = ((m >> 1) & 0x5555) | ((m & 0x5555) << 1);
-        // Swap consecutive pairs
-        mr = ((mr >> 2) & 0x3333) | ((mr & 0x3333) << 2);
-        // Swap nibbles 
-        mr = ((mr >> 4) & 0x0F0F) | ((mr & 0x0F0F) << 4);
-        // Swap bytes
-        mr = ((mr >> 8) & 0x00FF) | ((mr & 0x00FF) << 8);
-        // Shift down mr
-        mr >>= _shiftAmount;
-        // Don't swap that which has already been swapped
-        if (mr <= m) continue;
-
-        // Swap the bit-reversed indices
-        tr = f[m].r;
-        f[CHK(m,N)].r = f[mr].r;
-        f[CHK(mr,N)].r = tr;
-
-        ti = f[m].i;
-        f[CHK(m,N)].i = f[mr].i;
-        f[CHK(mr,N)].i = ti;
+    if (_bitReverse != 0) {
+        const uint16_t* swap = (n == N) ? _bitReverse : _bitReverse + _bitReverseSize;
+        const uint16_t* end = swap + ((n == N) ? _bitReverseSize : _bitReverseHalfSize);
+        for (; swap != end; swap += 2) {
+            m = swap[0];
+            mr = swap[1];
+            tr = f[m].r;
+            f[m].r = f[mr].r;
+            f[mr].r = tr;
+            ti = f[m].i;
+            f[m].i = f[mr].i;
+            f[mr].i = ti;
+        }
+    } else {
+        for (m = 1; m < n - 1; m++) {
+            // Swap odd and even bits
+            mr = ((m >> 1) & 0x5555) | ((m & 0x5555) << 1);
+            // Swap consecutive pairs
+            mr = ((mr >> 2) & 0x3333) | ((mr & 0x3333) << 2);
+            // Swap nibbles 
+            mr = ((mr >> 4) & 0x0F0F) | ((mr & 0x0F0F) << 4);
+            // Swap bytes
+            mr = ((mr >> 8) & 0x00FF) | ((mr & 0x00FF) << 8);
+            // Shift down mr
+            mr >>= shiftAmount;
+            // Don't swap that which has already been swapped
+            if (mr <= m) continue;
+
+            // Swap the bit-reversed indices
+            tr = f[m].r;
+            f[CHK(m,N)].r = f[mr].r;
+            f[CHK(mr,N)].r = tr;
+
+            ti = f[m].i;
+            f[CHK(m,N)].i = f[mr].i;
+            f[CHK(mr,N)].i = ti;
+        }
+    }
+
+    if (_radix4) {
+        _radix4Stages(f, n, log2n);
+        return;
     }
 
     // -----------------------------------------------------------------------
@@ -89,11 +127,12 @@ void F32FFT::transform(cf32 f[]) const {
 
     // Length of the FFT's being combined (starts at 1)
     int16_t L = 1;
-    // Log2 of number of samples, minus 1
+    // Log2 of number of samples, minus 1.  NOTE: This is the stride through
+    // the trig table for the first stage, which is always based on N.
     k = _log2N - 1;
     // While the length of the FFTs being combined is less than the number 
     // of gathered samples:
-    while (L < N) {
+    while (L < n) {
         // Determine the length of the FFT which will result from combining two FFT's
         iStep = L << 1;
         // For each element in the FFT's that are being combined
@@ -105,7 +144,7 @@ void F32FFT::transform(cf32 f[]) const {
             // sin(2PI m/N) / 2
             const float wi = -_cosTable[CHK(j,N)] / 2.0;                 
             // i gets the index of one of the FFT elements being combined
-            for (i = m; i < N; i += iStep) {
+            for (i = m; i < n; i += iStep) {
                 // j gets the index of the FFT element being combined with i
                 j = i + L;
                 // Compute the trig terms (bottom half of the above matrix)
@@ -126,6 +165,175 @@ void F32FFT::transform(cf32 f[]) const {
     }
 }
 
+void F32FFT::_radix4Stages(cf32 f[], uint16_t n, uint16_t log2n) const {
+
+    // See FixedFFT::_radix4Stages() for the details
+    const unsigned int quarter = N / 4;
+    const unsigned int mask = N - 1;
+
+    unsigned int L = 1;
+    unsigned int log2L = 0;
+
+    if (log2n & 1) {
+        for (unsigned int i = 0; i < n; i += 2) {
+            const float ar = f[i].r / 2, ai = f[i].i / 2;
+            const float br = f[i + 1].r / 2, bi = f[i + 1].i / 2;
+            f[i].r = ar + br;
+            f[i].i = ai + bi;
+            f[i + 1].r = ar - br;
+            f[i + 1].i = ai - bi;
+        }
+        L = 2;
+        log2L = 1;
+    }
+
+    while (L < n) {
+        const unsigned int iStep = L << 2;
+        const unsigned int shift = _log2N - (log2L + 2);
+        for (unsigned int m = 0; m < L; m++) {
+            // The divide by four is folded into the twiddles
+            const unsigned int j1 = m << shift;
+            const unsigned int j2 = (2 * j1) & mask;
+            const unsigned int j3 = (3 * j1) & mask;
+            const float w1r = _cosTable[(j1 + quarter) & mask] / 4, w1i = -_cosTable[j1] / 4;
+            const float w2r = _cosTable[(j2 + quarter) & mask] / 4, w2i = -_cosTable[j2] / 4;
+            const float w3r = _cosTable[(j3 + quarter) & mask] / 4, w3i = -_cosTable[j3] / 4;
+            for (unsigned int i = m; i < n; i += iStep) {
+                cf32* p0 = f + i;
+                cf32* p1 = p0 + L;
+                cf32* p2 = p1 + L;
+                cf32* p3 = p2 + L;
+                const float ar = p0->r / 4;
+                const float ai = p0->i / 4;
+                const float br = w2r * p1->r - w2i * p1->i;
+                const float bi = w2r * p1->i + w2i * p1->r;
+                const float cr = w1r * p2->r - w1i * p2->i;
+                const float ci = w1r * p2->i + w1i * p2->r;
+                const float dr = w3r * p3->r - w3i * p3->i;
+                const float di = w3r * p3->i + w3i * p3->r;
+                const float s0r = ar + br, s0i = ai + bi;
+                const float s1r = ar - br, s1i = ai - bi;
+                const float t0r = cr + dr, t0i = ci + di;
+                const float t1r = cr - dr, t1i = ci - di;
+                p0->r = s0r + t0r;
+                p0->i = s0i + t0i;
+                p1->r = s1r + t1i;
+                p1->i = s1i - t1r;
+                p2->r = s0r - t0r;
+                p2->i = s0i - t0i;
+                p3->r = s1r - t1i;
+                p3->i = s1i + t1r;
+            }
+        }
+        L = iStep;
+        log2L += 2;
+    }
+}
+
+void F32FFT::setBitReverseTable(uint16_t* space) {
+    _bitReverse = space;
+    if (_bitReverse != 0) {
+        _bitReverseSize = make_bit_reverse_swaps(_bitReverse, _log2N);
+        _bitReverseHalfSize = make_bit_reverse_swaps(_bitReverse + _bitReverseSize, _log2N - 1);
+    }
+}
+
+void F32FFT::transformReal(cf32 f[]) const {
+
+    const uint16_t h = N / 2;
+    _transform(f, h);
+
+    // See FixedFFT::transformReal() for the details
+    auto split = [this](cf32 a, cf32 b, uint16_t k) {
+        const float o_r = (a.i + b.i) / 2;
+        const float o_i = (b.r - a.r) / 2;
+        const float wr = _cosTable[(k + N / 4) & (N - 1)] / 2.0;
+        const float wi = -_cosTable[k] / 2.0;
+        return cf32(
+            (a.r + b.r) / 4 + wr * o_r - wi * o_i,
+            (a.i - b.i) / 4 + wr * o_i + wi * o_r);
+    };
+
+    const float z0r = f[0].r;
+    const float z0i = f[0].i;
+    f[0] = cf32((z0r + z0i) / 2, 0);
+    f[h] = cf32((z0r - z0i) / 2, 0);
+
+    for (uint16_t k = 1; k <= h / 2; k++) {
+        const uint16_t m = h - k;
+        const cf32 zk = f[k];
+        const cf32 zm = f[m];
+        f[k] = split(zk, zm, k);
+        if (m != k) {
+            f[m] = split(zm, zk, m);
+        }
+    }
+}
+
+void F32FFT::inverseTransform(cf32 f[]) const {
+    // IDFT(X) = conj(DFT(conj(X))), and transform() divides by N
+    for (uint16_t i = 0; i < N; i++) {
+        f[i].i = -f[i].i;
+    }
+    _transform(f, N);
+    for (uint16_t i = 0; i < N; i++) {
+        f[i].r = f[i].r * N;
+        f[i].i = -f[i].i * N;
+    }
+}
+
+void F32FFT::inverseTransformReal(cf32 f[]) const {
+
+    const uint16_t h = N / 2;
+
+    // This undoes the split in transformReal().  The transforms of the 
+    // even and odd samples are recovered from X and put back together 
+    // as Z = E + jO:
+    //
+    //   E[k] = X[k] + conj(X[N/2 - k])
+    //   O[k] = (X[k] - conj(X[N/2 - k])) W^-k
+    auto merge = [this](cf32 a, cf32 b, uint16_t k) {
+        // a = X[k], b = X[N/2 - k]
+        const float e_r = a.r + b.r;
+        const float e_i = a.i - b.i;
+        const float d_r = a.r - b.r;
+        const float d_i = a.i + b.i;
+        // W^-k = cos() + j sin()
+        const float wr = _cosTable[(k + N / 4) & (N - 1)];
+        const float wi = _cosTable[k];
+        const float o_r = d_r * wr - d_i * wi;
+        const float o_i = d_r * wi + d_i * wr;
+        // E + jO
+        return cf32(e_r - o_i, e_i + o_r);
+    };
+
+    // Bins 0 and N/2 give Z[0]
+    const float x0 = f[0].r;
+    const float xh = f[h].r;
+    f[0] = cf32(x0 + xh, x0 - xh);
+
+    for (uint16_t k = 1; k <= h / 2; k++) {
+        const uint16_t m = h - k;
+        const cf32 xk = f[k];
+        const cf32 xm = f[m];
+        f[k] = merge(xk, xm, k);
+        if (m != k) {
+            f[m] = merge(xm, xk, m);
+        }
+    }
+
+    // The inverse of the N/2 point transform (see inverseTransform()).  Z 
+    // is on the DFT / (N/2) scale, so this is the plain IDFT.
+    for (uint16_t i = 0; i < h; i++) {
+        f[i].i = -f[i].i;
+    }
+    _transform(f, h);
+    for (uint16_t i = 0; i < h; i++) {
+        f[i].r = f[i].r * h;
+        f[i].i = -f[i].i * h;
+    }
+}
+
 float F32FFT::binToFreq(uint16_t bin, float sampleFreq) const {
     return ((float)bin * sampleFreq) / N;
 }
@@ -46,23 +46,117 @@ public:
      */
     F32FFT(uint16_t n, float* trigTableSpace);
 
+    /**
+     * Uses a trig table that has already been built (see makeTrigTable()
+     * and SharedTables).  The table is only read, so any number of 
+     * instances of the same size can share it.
+     */
+    F32FFT(uint16_t n, const float* trigTable);
+
+    /**
+     * Builds the trig table used by an n point FFT.
+     *
+     * @returns The table.
+     */
+    static const float* makeTrigTable(uint16_t n, float* trigTableSpace);
+
     /**
      * Performs the FFT in-place. Meaning: the input series is overwritten.
      */
     void transform(cf32 f[]) const;
 
+    /**
+     * Performs the FFT of a real series using an N/2 point complex FFT, 
+     * which is about half the work of transform().  The scaling is the same
+     * as transform() (i.e. DFT / N).
+     *
+     * @param f On input, the N real samples packed two per entry (i.e. 
+     *   f[n].r = x[2n] and f[n].i = x[2n + 1] for n < N/2).  On output, 
+     *   bins 0 to N/2 (inclusive).  The upper bins aren't produced since 
+     *   they are the mirror images of these.  This must have room for 
+     *   N/2 + 1 entries.
+     */
+    void transformReal(cf32 f[]) const;
+
+    /**
+     * The inverse of transform(), so inverseTransform(transform(x)) = x.
+     * Since transform() includes the 1/N, this is the IDFT without it.
+     * Performed in-place.
+     */
+    void inverseTransform(cf32 f[]) const;
+
+    /**
+     * The inverse of transformReal().
+     *
+     * @param f On input, bins 0 to N/2 (inclusive) of a real series (in 
+     *   the format produced by transformReal()).  On output, the N real 
+     *   samples packed two per entry.
+     */
+    void inverseTransformReal(cf32 f[]) const;
+
     float binToFreq(uint16_t bin, float sampleFreq) const;
 
+    uint16_t getN() const { return N; }
+
+    /**
+     * Selects the butterfly kernel.  The default is the original radix-2 
+     * Danielson-Lanczos loop.  When enabled, the stages are combined in 
+     * pairs using radix-4 butterflies (with one radix-2 stage first when 
+     * log2(N) is odd), which roughly halves the passes over the data and
+     * the twiddle lookups.  The scaling is the same (DFT / N).
+     */
+    void setRadix4Enabled(bool en) { _radix4 = en; }
+
+    /**
+     * Replaces the bit-reversal index arithmetic with a precomputed list
+     * of swaps.  This costs bitReverseSpaceSize() words and is usually
+     * a bit faster.
+     *
+     * @param space Room for bitReverseSpaceSize(log2(N)) entries, or 0 to 
+     *   go back to computing the indices on the fly.
+     */
+    void setBitReverseTable(uint16_t* space);
+
+    /**
+     * @returns The number of entries needed by setBitReverseTable().  The 
+     *   table holds the swaps for N and N/2 (used by transformReal()).
+     */
+    static constexpr uint16_t bitReverseSpaceSize(uint16_t log2N) {
+        return ((1 << log2N) - (1 << ((log2N + 1) / 2))) + 
+            ((1 << (log2N - 1)) - (1 << (log2N / 2)));
+    }
+
 private: 
 
+    /**
+     * The complex FFT of the first n entries (n = N or N/2).  The trig 
+     * table is always the one for N.
+     */
+    void _transform(cf32 f[], uint16_t n) const;
+
+    /**
+     * The radix-4 version of the butterfly stages of _transform().  The
+     * input has already been put into bit-reversed order.
+     */
+    void _radix4Stages(cf32 f[], uint16_t n, uint16_t log2n) const;
+
     const uint16_t N;
     const uint16_t _log2N = std::log2(N);
+    // The bit-reversal shift for N and N/2 (the real-input FFT runs at N/2)
     const uint16_t _shiftAmount = 16 - _log2N;
+    const uint16_t _halfShiftAmount = _shiftAmount + 1;
     const float PI = std::atan(1.0) * 4.0;
     const float TWO_PI = PI * 2.0f;
 
+    bool _radix4 = false;
+
+    // Bit-reversal swaps for N followed by the swaps for N/2
+    uint16_t* _bitReverse = 0;
+    uint16_t _bitReverseSize = 0;
+    uint16_t _bitReverseHalfSize = 0;
+
     // Pre-built table for fast trig
-    float* _cosTable;
+    const float* _cosTable;
 };
 
 }
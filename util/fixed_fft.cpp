@@ -21,24 +21,43 @@ Tom Roberts, and Malcolm Slaney (malcolm@interval.com).
 */
 #include <cassert>
 #include "fixed_fft.h"
+#include "dsp_util.h"
+#include "simd_q15.h"
 
 #define CHK(x,y) (x)
 
 namespace radlib {
 
 FixedFFT::FixedFFT(uint16_t n, q15* trigTable)
+:   N(n),
+    _cosTable(makeTrigTable(n, trigTable)) {
+}
+
+FixedFFT::FixedFFT(uint16_t n, const q15* trigTable)
 :   N(n),
     _cosTable(trigTable) {
-    for (uint16_t i = 0; i < N; i++) {
+}
+
+const q15* FixedFFT::makeTrigTable(uint16_t n, q15* trigTable) {
+    const float pi = std::atan(1.0) * 4.0;
+    const float twoPi = pi * 2.0f;
+    for (uint16_t i = 0; i < n; i++) {
         // NOTE: There is overflow when sin(phi) = 1.0 so we scale down everything by 2.
-        _cosTable[CHK(i, N)] = f32_to_q15(std::sin(TWO_PI * ((float) i) / (float)N) / 2.0f);
+        trigTable[CHK(i, n)] = f32_to_q15(std::sin(twoPi * ((float) i) / (float)n) / 2.0f);
     }
+    return trigTable;
 }
 
 /**
  * Performs the FFT in-place. Meaning: the input series is overwritten.
  */
 void FixedFFT::transform(cq15 f[]) const {
+    _transform(f, N);
+}
+
+void FixedFFT::_reorder(cq15 f[], uint16_t n) const {
+
+    const uint16_t shiftAmount = (n == N) ? _shiftAmount : _halfShiftAmount;
 
     // One of the indices being swapped    
     uint16_t m;   
@@ -47,6 +66,59 @@ void FixedFFT::transform(cq15 f[]) const {
     // Temporary while swapping
     q15 tr, ti; 
 
+    // -----------------------------------------------------------------------
+    // The bit-reversal phase of the algorithm, based on this:
+    // https://graphics.stanford.edu/~seander/bithacks.html#BitReverseObvious
+
+    if (_bitReverse != 0) {
+        const uint16_t* swap = (n == N) ? _bitReverse : _bitReverse + _bitReverseSize;
+        const uint16_t* end = swap + ((n == N) ? _bitReverseSize : _bitReverseHalfSize);
+        for (; swap != end; swap += 2) {
+            m = swap[0];
+            mr = swap[1];
+            tr = f[m].r;
+            f[m].r = f[mr].r;
+            f[mr].r = tr;
+            ti = f[m].i;
+            f[m].i = f[mr].i;
+            f[mr].i = ti;
+        }
+    } else {
+        for (m = 1; m < n - 1; m++) {
+            // Swap odd and even bits
+            mr = ((m >> 1) & 0x5555) | ((m & 0x5555) << 1);
+            // Swap consecutive pairs
+            mr = ((mr >> 2) & 0x3333) | ((mr & 0x3333) << 2);
+            // Swap nibbles 
+            mr = ((mr >> 4) & 0x0F0F) | ((mr & 0x0F0F) << 4);
+            // Swap bytes
+            mr = ((mr >> 8) & 0x00FF) | ((mr & 0x00FF) << 8);
+            // Shift down mr
+            mr >>= shiftAmount;
+            // Don't swap that which has already been swapped
+            if (mr <= m) continue;
+
+            // Swap the bit-reversed indices
+            tr = f[m].r;
+            f[CHK(m,N)].r = f[mr].r;
+            f[CHK(mr,N)].r = tr;
+
+            ti = f[m].i;
+            f[CHK(m,N)].i = f[mr].i;
+            f[CHK(mr,N)].i = ti;
+        }
+    }
+}
+
+void FixedFFT::_transform(cq15 f[], uint16_t n) const {
+
+    const uint16_t log2n = (n == N) ? _log2N : _log2N - 1;
+
+    // One of the indices being combined
+    uint16_t m;   
+    // Temporary values
+    q15 tr, ti; 
+
     // Indices being combined in Danielson-Lanczos part of the algorithm    
     int16_t i, j; 
     // Used for looking up trig values
@@ -55,32 +127,11 @@ void FixedFFT::transform(cq15 f[]) const {
     // Length of the FFT which results from combining two FFT's
     int16_t iStep; 
     
-    // -----------------------------------------------------------------------
-    // The bit-reversal phase of the algorithm, based on this:
-    // https://graphics.stanford.edu/~seander/bithacks.html#BitReverseObvious
+    _reorder(f, n);
 
-    for (m = 1; m < N - 1; m++) {
-        // Swap odd and even bits
-        mr = ((m >> 1) & 0x5555) | ((m & 0x5555) << 1);
-        // Swap consecutive pairs
-        mr = ((mr >> 2) & 0x3333) | ((mr & 0x3333) << 2);
-        // Swap nibbles 
-        mr = ((mr >> 4) & 0x0F0F) | ((mr & 0x0F0F) << 4);
-        // Swap bytes
-        mr = ((mr >> 8) & 0x00FF) | ((mr & 0x00FF) << 8);
-        // Shift down mr
-        mr >>= _shiftAmount;
-        // Don't swap that which has already been swapped
-        if (mr <= m) continue;
-
-        // Swap the bit-reversed indices
-        tr = f[m].r;
-        f[CHK(m,N)].r = f[mr].r;
-        f[CHK(mr,N)].r = tr;
-
-        ti = f[m].i;
-        f[CHK(m,N)].i = f[mr].i;
-        f[CHK(mr,N)].i = ti;
+    if (_radix4) {
+        _radix4Stages(f, n, log2n);
+        return;
     }
 
     // -----------------------------------------------------------------------
@@ -89,13 +140,20 @@ void FixedFFT::transform(cq15 f[]) const {
 
     // Length of the FFT's being combined (starts at 1)
     int16_t L = 1;
-    // Log2 of number of samples, minus 1
+    // Log2 of number of samples, minus 1.  NOTE: This is the stride through
+    // the trig table for the first stage, which is always based on N.
     k = _log2N - 1;
     // While the length of the FFTs being combined is less than the number 
     // of gathered samples:
-    while (L < N) {
+    while (L < n) {
         // Determine the length of the FFT which will result from combining two FFT's
         iStep = L << 1;
+        // Use the vectorized butterflies when they are available
+        if (fft_stage_q15_simd(f, n, L, k, _cosTable, N)) {
+            --k;
+            L = iStep;
+            continue;
+        }
         // For each element in the FFT's that are being combined
         for (m = 0; m < L; ++m) { 
             // Lookup the trig values for that element
@@ -109,7 +167,7 @@ void FixedFFT::transform(cq15 f[]) const {
             // table.
             const q15 wi = -_cosTable[CHK(j,N)];                 
             // i gets the index of one of the FFT elements being combined
-            for (i = m; i < N; i += iStep) {
+            for (i = m; i < n; i += iStep) {
                 // j gets the index of the FFT element being combined with i
                 j = i + L;
                 // Compute the trig terms (bottom half of the above matrix)
@@ -130,6 +188,233 @@ void FixedFFT::transform(cq15 f[]) const {
     }
 }
 
+void FixedFFT::_radix4Stages(cq15 f[], uint16_t n, uint16_t log2n) const {
+
+    const unsigned int quarter = N / 4;
+    const unsigned int mask = N - 1;
+
+    // Length of the FFT's being combined (starts at 1)
+    unsigned int L = 1;
+    unsigned int log2L = 0;
+
+    // When log2(n) is odd the first stage is a plain radix-2 stage.  The 
+    // twiddles are all 1 here.
+    if (log2n & 1) {
+        for (unsigned int i = 0; i < n; i += 2) {
+            const q15 ar = f[i].r >> 1, ai = f[i].i >> 1;
+            const q15 br = f[i + 1].r >> 1, bi = f[i + 1].i >> 1;
+            f[i].r = ar + br;
+            f[i].i = ai + bi;
+            f[i + 1].r = ar - br;
+            f[i + 1].i = ai - bi;
+        }
+        L = 2;
+        log2L = 1;
+    }
+
+    // Each radix-4 stage combines four FFT's of length L.  This is the same
+    // as two of the radix-2 stages:
+    //
+    //   a = x0, b = W^2m x1, c = W^m x2, d = W^3m x3  (W = e^(-j 2PI / 4L))
+    //   y0 = (a + b) + (c + d)
+    //   y1 = (a - b) - j(c - d)
+    //   y2 = (a + b) - (c + d)
+    //   y3 = (a - b) + j(c - d)
+    //
+    // Everything is divided by four to keep the scaling of the radix-2 
+    // version.
+    while (L < n) {
+        const unsigned int iStep = L << 2;
+        // The stride through the trig table for W
+        const unsigned int shift = _log2N - (log2L + 2);
+        for (unsigned int m = 0; m < L; m++) {
+            // NOTE: The table holds the trig values / 2
+            const unsigned int j1 = m << shift;
+            const unsigned int j2 = (2 * j1) & mask;
+            const unsigned int j3 = (3 * j1) & mask;
+            const q15 w1r = _cosTable[(j1 + quarter) & mask], w1i = -_cosTable[j1];
+            const q15 w2r = _cosTable[(j2 + quarter) & mask], w2i = -_cosTable[j2];
+            const q15 w3r = _cosTable[(j3 + quarter) & mask], w3i = -_cosTable[j3];
+            for (unsigned int i = m; i < n; i += iStep) {
+                cq15* p0 = f + i;
+                cq15* p1 = p0 + L;
+                cq15* p2 = p1 + L;
+                cq15* p3 = p2 + L;
+                const q15 ar = p0->r >> 2;
+                const q15 ai = p0->i >> 2;
+                // The multiplies are already scaled by 2 (see above)
+                const q15 br = (mult_q15(w2r, p1->r) - mult_q15(w2i, p1->i)) >> 1;
+                const q15 bi = (mult_q15(w2r, p1->i) + mult_q15(w2i, p1->r)) >> 1;
+                const q15 cr = (mult_q15(w1r, p2->r) - mult_q15(w1i, p2->i)) >> 1;
+                const q15 ci = (mult_q15(w1r, p2->i) + mult_q15(w1i, p2->r)) >> 1;
+                const q15 dr = (mult_q15(w3r, p3->r) - mult_q15(w3i, p3->i)) >> 1;
+                const q15 di = (mult_q15(w3r, p3->i) + mult_q15(w3i, p3->r)) >> 1;
+                const q15 s0r = ar + br, s0i = ai + bi;
+                const q15 s1r = ar - br, s1i = ai - bi;
+                const q15 t0r = cr + dr, t0i = ci + di;
+                const q15 t1r = cr - dr, t1i = ci - di;
+                p0->r = s0r + t0r;
+                p0->i = s0i + t0i;
+                p1->r = s1r + t1i;
+                p1->i = s1i - t1r;
+                p2->r = s0r - t0r;
+                p2->i = s0i - t0i;
+                p3->r = s1r - t1i;
+                p3->i = s1i + t1r;
+            }
+        }
+        L = iStep;
+        log2L += 2;
+    }
+}
+
+void FixedFFT::setBitReverseTable(uint16_t* space) {
+    _bitReverse = space;
+    if (_bitReverse != 0) {
+        _bitReverseSize = make_bit_reverse_swaps(_bitReverse, _log2N);
+        _bitReverseHalfSize = make_bit_reverse_swaps(_bitReverse + _bitReverseSize, _log2N - 1);
+    }
+}
+
+void FixedFFT::transformReal(cq15 f[]) const {
+    _transform(f, N / 2);
+    _splitReal(f);
+}
+
+uint16_t FixedFFT::transformBFP(cq15 f[]) const {
+    const uint16_t shifts = _transformBFP(f, N);
+    return shifts + _headroom(f, N);
+}
+
+uint16_t FixedFFT::transformRealBFP(cq15 f[]) const {
+    // NOTE: The split can grow the values a bit, so it needs the headroom.
+    // It also has a divide by two of its own.
+    const uint16_t shifts = _transformBFP(f, N / 2) + _headroom(f, N / 2) + 1;
+    _splitReal(f);
+    return shifts + _headroom(f, N / 2 + 1);
+}
+
+uint16_t FixedFFT::_transformBFP(cq15 f[], uint16_t n) const {
+
+    _reorder(f, n);
+
+    // An upper bound on the largest magnitude of any component.  The
+    // magnitudes are OR'ed together, which gives the highest bit that 
+    // is in use.
+    uint16_t bits = 0;
+    for (uint16_t i = 0; i < n; i++) {
+        bits |= (uint16_t)std::abs(f[i].r) | (uint16_t)std::abs(f[i].i);
+    }
+
+    uint16_t shifts = 0;
+    // Length of the FFT's being combined (starts at 1)
+    unsigned int L = 1;
+    // The stride through the trig table for the first stage
+    unsigned int k = _log2N - 1;
+
+    while (L < n) {
+
+        // A butterfly can grow a component by a factor of (1 + sqrt(2)),
+        // so the stage is only safe without scaling if everything is 
+        // below 1/4.  Otherwise this stage is scaled like transform().
+        const unsigned int scale = (bits >= 0x2000) ? 1 : 0;
+        // The table holds the trig values / 2.  The products are rounded
+        // since the truncation bias would build up in the low bins.
+        const unsigned int productShift = 14 + scale;
+        const q31 round = 1 << (productShift - 1);
+        shifts += scale;
+        bits = 0;
+
+        const unsigned int iStep = L << 1;
+        for (unsigned int m = 0; m < L; m++) {
+            const unsigned int j = m << k;
+            const q31 wr = _cosTable[j + N / 4];
+            const q31 wi = -_cosTable[j];
+            for (unsigned int i = m; i < n; i += iStep) {
+                cq15& a = f[i];
+                cq15& b = f[i + L];
+                const q15 tr = (wr * b.r - wi * b.i + round) >> productShift;
+                const q15 ti = (wr * b.i + wi * b.r + round) >> productShift;
+                const q15 qr = a.r >> scale;
+                const q15 qi = a.i >> scale;
+                b.r = qr - tr;
+                b.i = qi - ti;
+                a.r = qr + tr;
+                a.i = qi + ti;
+                bits |= (uint16_t)std::abs(a.r) | (uint16_t)std::abs(a.i) |
+                    (uint16_t)std::abs(b.r) | (uint16_t)std::abs(b.i);
+            }
+        }
+
+        --k;
+        L = iStep;
+    }
+
+    return shifts;
+}
+
+uint16_t FixedFFT::_headroom(cq15 f[], uint16_t n) const {
+    uint16_t bits = 0;
+    for (uint16_t i = 0; i < n; i++) {
+        bits |= (uint16_t)std::abs(f[i].r) | (uint16_t)std::abs(f[i].i);
+    }
+    if (bits < 0x4000) {
+        return 0;
+    }
+    for (uint16_t i = 0; i < n; i++) {
+        f[i].r >>= 1;
+        f[i].i >>= 1;
+    }
+    return 1;
+}
+
+void FixedFFT::_splitReal(cq15 f[]) const {
+
+    const uint16_t h = N / 2;
+
+    // The N/2 point result (Z) is split into the transforms of the even 
+    // and odd samples (E and O), which are then combined:
+    //
+    //   E[k] = (Z[k] + conj(Z[N/2 - k])) / 2
+    //   O[k] = (Z[k] - conj(Z[N/2 - k])) / 2j
+    //   X[k] = (E[k] + W^k O[k]) / 2
+    //
+    // The last divide by two is there because Z has the N/2 point scaling.
+    auto split = [this](cq15 a, cq15 b, uint16_t k) {
+        // O (a = Z[k], b = Z[N/2 - k])
+        const q15 o_r = ((int32_t)a.i + (int32_t)b.i) >> 1;
+        const q15 o_i = ((int32_t)b.r - (int32_t)a.r) >> 1;
+        // W^k O / 2.  NOTE: The scale by two was taken care of during the 
+        // loading of the table.
+        const q15 wr = _cosTable[(k + N / 4) & (N - 1)];
+        const q15 wi = -_cosTable[k];
+        cq15 x;
+        x.r = (((int32_t)a.r + (int32_t)b.r) >> 2) + mult_q15(wr, o_r) - mult_q15(wi, o_i);
+        x.i = (((int32_t)a.i - (int32_t)b.i) >> 2) + mult_q15(wr, o_i) + mult_q15(wi, o_r);
+        return x;
+    };
+
+    // Bins 0 and N/2 only depend on Z[0]
+    const q15 z0r = f[0].r;
+    const q15 z0i = f[0].i;
+    f[0].r = ((int32_t)z0r + (int32_t)z0i) >> 1;
+    f[0].i = 0;
+    f[h].r = ((int32_t)z0r - (int32_t)z0i) >> 1;
+    f[h].i = 0;
+
+    // The others are done in pairs since bins k and N/2 - k use the 
+    // same two values of Z.
+    for (uint16_t k = 1; k <= h / 2; k++) {
+        const uint16_t m = h - k;
+        const cq15 zk = f[k];
+        const cq15 zm = f[m];
+        f[k] = split(zk, zm, k);
+        if (m != k) {
+            f[m] = split(zm, zk, m);
+        }
+    }
+}
+
 float FixedFFT::binToFreq(uint16_t bin, float sampleFreq) const {
     return ((float)bin * sampleFreq) / (float)N;
 }
@@ -39,25 +39,158 @@ namespace radlib {
 class FixedFFT {
 public:
 
+    /**
+     * @param trigTableSpace A work-area of size n that will be filled with 
+     *   trig values during construction.
+     */
     FixedFFT(uint16_t n, q15* trigTableSpace);
 
+    /**
+     * Uses a trig table that has already been built (see makeTrigTable()
+     * and SharedTables).  The table is only read, so any number of 
+     * instances of the same size can share it and it can live in flash.
+     */
+    FixedFFT(uint16_t n, const q15* trigTable);
+
+    /**
+     * Builds the trig table used by an n point FFT.
+     *
+     * @returns The table.
+     */
+    static const q15* makeTrigTable(uint16_t n, q15* trigTableSpace);
+
     /**
      * Performs the FFT in-place. Meaning: the input series is overwritten.
      */
     void transform(cq15 f[]) const;
 
+    /**
+     * Performs the FFT of a real series using an N/2 point complex FFT, 
+     * which is about half the work of transform().  The scaling is the same
+     * as transform() (i.e. DFT / N).
+     *
+     * @param f On input, the N real samples packed two per entry (i.e. 
+     *   f[n].r = x[2n] and f[n].i = x[2n + 1] for n < N/2).  On output, 
+     *   bins 0 to N/2 (inclusive).  The upper bins aren't produced since 
+     *   they are the mirror images of these.  This must have room for 
+     *   N/2 + 1 entries.
+     */
+    void transformReal(cq15 f[]) const;
+
+    /**
+     * A block-floating-point version of transform().  Rather than scaling 
+     * every stage, a stage is only scaled when the data might overflow 
+     * otherwise, so weak signals keep their precision.  The result always
+     * has one bit of headroom (i.e. all components are below 0.5) so 
+     * that magnitudes can be computed safely.
+     *
+     * @returns The exponent s.  The result is DFT / 2^s (transform() 
+     *   always uses s = log2(N)), so multiply by 2^s / N to get the same
+     *   scale as transform().
+     */
+    uint16_t transformBFP(cq15 f[]) const;
+
+    /**
+     * The block-floating-point version of transformReal().  See 
+     * transformBFP().
+     */
+    uint16_t transformRealBFP(cq15 f[]) const;
+
     float binToFreq(uint16_t bin, float sampleFreq) const;
 
+    uint16_t getN() const { return N; }
+
+    /**
+     * @returns The trig table (sin / 2) for N.
+     */
+    const q15* getTrigTable() const { return _cosTable; }
+
+    /**
+     * Selects the butterfly kernel.  The default is the original radix-2 
+     * Danielson-Lanczos loop.  When enabled, the stages are combined in 
+     * pairs using radix-4 butterflies (with one radix-2 stage first when 
+     * log2(N) is odd), which roughly halves the passes over the data and
+     * the twiddle lookups.  The scaling is the same (DFT / N), but the
+     * truncation happens in different places so the results can differ
+     * by a few LSBs.
+     */
+    void setRadix4Enabled(bool en) { _radix4 = en; }
+
+    /**
+     * Replaces the bit-reversal index arithmetic with a precomputed list
+     * of swaps.  This costs bitReverseSpaceSize() words and is usually
+     * a bit faster.
+     *
+     * @param space Room for bitReverseSpaceSize(log2(N)) entries, or 0 to 
+     *   go back to computing the indices on the fly.
+     */
+    void setBitReverseTable(uint16_t* space);
+
+    /**
+     * @returns The number of entries needed by setBitReverseTable().  The 
+     *   table holds the swaps for N and N/2 (used by transformReal()).
+     */
+    static constexpr uint16_t bitReverseSpaceSize(uint16_t log2N) {
+        return ((1 << log2N) - (1 << ((log2N + 1) / 2))) + 
+            ((1 << (log2N - 1)) - (1 << (log2N / 2)));
+    }
+
 private: 
 
+    /**
+     * The complex FFT of the first n entries (n = N or N/2).  The trig 
+     * table is always the one for N.
+     */
+    void _transform(cq15 f[], uint16_t n) const;
+
+    /**
+     * The block-floating-point version of _transform().
+     *
+     * @returns The number of stages that were scaled.
+     */
+    uint16_t _transformBFP(cq15 f[], uint16_t n) const;
+
+    /**
+     * Puts the first n entries into bit-reversed order.
+     */
+    void _reorder(cq15 f[], uint16_t n) const;
+
+    /**
+     * Turns the N/2 point transform of the packed real samples into 
+     * bins 0 to N/2 (see transformReal()).
+     */
+    void _splitReal(cq15 f[]) const;
+
+    /**
+     * Scales down the first n entries by two if any of them are above 0.5.
+     *
+     * @returns The number of times the data was scaled (0 or 1).
+     */
+    uint16_t _headroom(cq15 f[], uint16_t n) const;
+
+    /**
+     * The radix-4 version of the butterfly stages of _transform().  The
+     * input has already been put into bit-reversed order.
+     */
+    void _radix4Stages(cq15 f[], uint16_t n, uint16_t log2n) const;
+
     const uint16_t N;
     const uint16_t _log2N = std::log2(N);
+    // The bit-reversal shift for N and N/2 (the real-input FFT runs at N/2)
     const uint16_t _shiftAmount = 16 - _log2N;
+    const uint16_t _halfShiftAmount = _shiftAmount + 1;
     const float PI = std::atan(1.0) * 4.0;
     const float TWO_PI = PI * 2.0f;
 
+    bool _radix4 = false;
+
+    // Bit-reversal swaps for N followed by the swaps for N/2
+    uint16_t* _bitReverse = 0;
+    uint16_t _bitReverseSize = 0;
+    uint16_t _bitReverseHalfSize = 0;
+
     // Pre-built table for fast trig
-    q15* _cosTable;
+    const q15* _cosTable;
 };
 
 }
@@ -0,0 +1,167 @@
+/*
+Copyright (C) 2024 - Bruce MacKinnon KC1FSZ
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "fixed_fft31.h"
+
+namespace radlib {
+
+/**
+ * The number of fraction bits in each type of twiddle.
+ */
+template <class W> struct TwiddleBits { };
+template <> struct TwiddleBits<q31> { static const unsigned int value = 31; };
+template <> struct TwiddleBits<q15> { static const unsigned int value = 15; };
+
+/**
+ * @returns a * w, where w is a twiddle from the trig table.
+ */
+template <class W> static inline q31 mult_twiddle(q31 a, W w) {
+    return (q31)(((int64_t)a * (int64_t)w) >> TwiddleBits<W>::value);
+}
+
+FixedFFT31::FixedFFT31(uint16_t n, q31* trigTable)
+:   N(n),
+    _cosTable31(makeTrigTable(n, trigTable)) {
+}
+
+FixedFFT31::FixedFFT31(uint16_t n, const q31* trigTable)
+:   N(n),
+    _cosTable31(trigTable) {
+}
+
+FixedFFT31::FixedFFT31(uint16_t n, const q15* trigTable)
+:   N(n),
+    _cosTable15(trigTable) {
+}
+
+const q31* FixedFFT31::makeTrigTable(uint16_t n, q31* trigTable) {
+    const double twoPi = std::atan(1.0) * 8.0;
+    for (uint16_t i = 0; i < n; i++) {
+        // NOTE: There is overflow when sin(phi) = 1.0 so we scale down 
+        // everything by 2.  Double precision is needed to fill all 31 bits.
+        trigTable[i] = (q31)std::lround(std::sin(twoPi * (double)i / (double)n) * 1073741824.0);
+    }
+    return trigTable;
+}
+
+void FixedFFT31::transform(cq31 f[]) const {
+    if (_cosTable31 != 0) {
+        _transform(f, N, _cosTable31);
+    } else {
+        _transform(f, N, _cosTable15);
+    }
+}
+
+void FixedFFT31::transformReal(cq31 f[]) const {
+    if (_cosTable31 != 0) {
+        _transform(f, N / 2, _cosTable31);
+        _splitReal(f, _cosTable31);
+    } else {
+        _transform(f, N / 2, _cosTable15);
+        _splitReal(f, _cosTable15);
+    }
+}
+
+template <class W> 
+void FixedFFT31::_transform(cq31 f[], uint16_t n, const W* table) const {
+
+    // -----------------------------------------------------------------------
+    // The bit-reversal phase (see FixedFFT::_reorder())
+
+    const uint16_t shiftAmount = 16 - ((n == N) ? _log2N : _log2N - 1);
+    for (uint16_t m = 1; m < n - 1; m++) {
+        uint16_t mr = ((m >> 1) & 0x5555) | ((m & 0x5555) << 1);
+        mr = ((mr >> 2) & 0x3333) | ((mr & 0x3333) << 2);
+        mr = ((mr >> 4) & 0x0F0F) | ((mr & 0x0F0F) << 4);
+        mr = ((mr >> 8) & 0x00FF) | ((mr & 0x00FF) << 8);
+        mr >>= shiftAmount;
+        if (mr <= m) continue;
+        const cq31 t = f[m];
+        f[m] = f[mr];
+        f[mr] = t;
+    }
+
+    // -----------------------------------------------------------------------
+    // The Danielson-Lanczos stages (see FixedFFT::_transform())
+
+    // Length of the FFT's being combined (starts at 1)
+    unsigned int L = 1;
+    // The stride through the trig table for the first stage, which is 
+    // always based on N.
+    unsigned int k = _log2N - 1;
+    while (L < n) {
+        const unsigned int iStep = L << 1;
+        for (unsigned int m = 0; m < L; m++) {
+            const unsigned int j = m << k;
+            // cos(2PI m/N) / 2 and sin(2PI m/N) / 2
+            const W wr = table[j + N / 4];
+            const W wi = -table[j];
+            for (unsigned int i = m; i < n; i += iStep) {
+                const unsigned int p = i + L;
+                const q31 tr = mult_twiddle(f[p].r, wr) - mult_twiddle(f[p].i, wi);
+                const q31 ti = mult_twiddle(f[p].i, wr) + mult_twiddle(f[p].r, wi);
+                const q31 qr = f[i].r >> 1;
+                const q31 qi = f[i].i >> 1;
+                f[p].r = qr - tr;
+                f[p].i = qi - ti;
+                f[i].r = qr + tr;
+                f[i].i = qi + ti;
+            }
+        }
+        --k;
+        L = iStep;
+    }
+}
+
+template <class W> 
+void FixedFFT31::_splitReal(cq31 f[], const W* table) const {
+
+    const uint16_t h = N / 2;
+
+    // See FixedFFT::_splitReal()
+    auto split = [this, table](cq31 a, cq31 b, uint16_t k) {
+        // O (a = Z[k], b = Z[N/2 - k])
+        const q31 o_r = ((int64_t)a.i + (int64_t)b.i) >> 1;
+        const q31 o_i = ((int64_t)b.r - (int64_t)a.r) >> 1;
+        // W^k O / 2.  NOTE: The table holds the trig values / 2.
+        const W wr = table[(k + N / 4) & (N - 1)];
+        const W wi = -table[k];
+        cq31 x;
+        x.r = (q31)((((int64_t)a.r + (int64_t)b.r) >> 2) + mult_twiddle(o_r, wr) - mult_twiddle(o_i, wi));
+        x.i = (q31)((((int64_t)a.i - (int64_t)b.i) >> 2) + mult_twiddle(o_i, wr) + mult_twiddle(o_r, wi));
+        return x;
+    };
+
+    // Bins 0 and N/2 only depend on Z[0]
+    const q31 z0r = f[0].r;
+    const q31 z0i = f[0].i;
+    f[0].r = ((int64_t)z0r + (int64_t)z0i) >> 1;
+    f[0].i = 0;
+    f[h].r = ((int64_t)z0r - (int64_t)z0i) >> 1;
+    f[h].i = 0;
+
+    // Bins k and N/2 - k use the same two values of Z
+    for (uint16_t k = 1; k <= h / 2; k++) {
+        const uint16_t m = h - k;
+        const cq31 zk = f[k];
+        const cq31 zm = f[m];
+        f[k] = split(zk, zm, k);
+        if (m != k) {
+            f[m] = split(zm, zk, m);
+        }
+    }
+}
+
+}
@@ -0,0 +1,104 @@
+/*
+Copyright (C) 2024 - Bruce MacKinnon KC1FSZ
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef _fixed_fft31_h
+#define _fixed_fft31_h
+
+#include <cstdint>
+#include <cmath>
+
+#include "fixed_math.h"
+
+namespace radlib {
+
+/**
+ * A Q31 version of FixedFFT.  The algorithm and scaling are the same (the
+ * result is DFT / N), but the data is 32 bits and the products are 
+ * computed with 64-bit intermediates.  Each stage still loses one bit to
+ * the scaling, but there are 16 more to start with, so weak signals keep
+ * about the same precision that they would get from a floating-point FFT.
+ * This is useful on cores without an FPU where a 32x32->64 multiply is
+ * cheap (i.e. SMULL on ARM).
+ *
+ * The twiddles can be q31 (built by makeTrigTable()) or the q15 table 
+ * used by FixedFFT, which saves memory at the cost of about 15 bits of 
+ * twiddle precision.
+ *
+ * There is no internal memory allocation/deallocation.
+ */
+class FixedFFT31 {
+public:
+
+    /**
+     * @param trigTableSpace A work-area of size n that will be filled with 
+     *   trig values during construction.
+     */
+    FixedFFT31(uint16_t n, q31* trigTableSpace);
+
+    /**
+     * Uses a q31 trig table that has already been built (see 
+     * makeTrigTable()).
+     */
+    FixedFFT31(uint16_t n, const q31* trigTable);
+
+    /**
+     * Uses the q15 trig table from a FixedFFT of the same size (see 
+     * FixedFFT::makeTrigTable() and SharedTables).
+     */
+    FixedFFT31(uint16_t n, const q15* trigTable);
+
+    /**
+     * Builds the trig table (sin / 2) used by an n point FFT.
+     *
+     * @returns The table.
+     */
+    static const q31* makeTrigTable(uint16_t n, q31* trigTableSpace);
+
+    /**
+     * Performs the FFT in-place. Meaning: the input series is overwritten.
+     */
+    void transform(cq31 f[]) const;
+
+    /**
+     * Same as FixedFFT::transformReal().
+     *
+     * @param f On input, the N real samples packed two per entry.  On 
+     *   output, bins 0 to N/2 (inclusive).  This must have room for 
+     *   N/2 + 1 entries.
+     */
+    void transformReal(cq31 f[]) const;
+
+    uint16_t getN() const { return N; }
+
+private:
+
+    /**
+     * The complex FFT of the first n entries (n = N or N/2).  The trig 
+     * table is always the one for N.
+     */
+    template <class W> void _transform(cq31 f[], uint16_t n, const W* table) const;
+
+    template <class W> void _splitReal(cq31 f[], const W* table) const;
+
+    const uint16_t N;
+    const uint16_t _log2N = std::log2(N);
+    // Only one of these is used
+    const q31* _cosTable31 = 0;
+    const q15* _cosTable15 = 0;
+};
+
+}
+
+#endif
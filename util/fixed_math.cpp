@@ -16,6 +16,7 @@ this program. If not, see <https://www.gnu.org/licenses/>.
 */
 #include "dsp_util.h"
 #include "fixed_math.h"
+#include "simd_q15.h"
 
 namespace radlib {
 
@@ -63,8 +64,11 @@ uint16_t max_idx(const cq15* sample, uint16_t start, uint16_t len) {
 }
 
 uint16_t max_idx_2(const cq15* sample, uint16_t start, uint16_t len) {
-    q15 max_mag = 0;
     uint16_t max_bin = 0;
+    if (max_idx_2_simd(sample, start, len, &max_bin)) {
+        return max_bin;
+    }
+    q15 max_mag = 0;
     for (unsigned int i = 0; i < len; i++) {
         if (i >= start) {
             q15 m = sample[i].approx_mag_q15();
@@ -77,6 +81,30 @@ uint16_t max_idx_2(const cq15* sample, uint16_t start, uint16_t len) {
     return max_bin;
 }
 
+q31 fir_sym_q15(const q15* h, const q15* x, uint16_t taps) {
+    q31 acc = 0;
+    if (fir_sym_q15_simd(h, x, taps, &acc)) {
+        return acc;
+    }
+    const uint16_t half = taps / 2;
+    acc = (q31)h[half] * (q31)x[half];
+    for (uint16_t i = 0; i < half; i++) {
+        acc += (q31)h[i] * ((q31)x[i] + (q31)x[taps - 1 - i]);
+    }
+    return acc;
+}
+
+q31 fir_q15(const q15* h, const q15* x, uint16_t taps) {
+    q31 acc = 0;
+    if (fir_q15_simd(h, x, taps, &acc)) {
+        return acc;
+    }
+    for (uint16_t i = 0; i < taps; i++) {
+        acc += (q31)h[i] * (q31)x[i];
+    }
+    return acc;
+}
+
 q15 max_q15(const q15* data, uint16_t dataLen) {
     q15 max = 0;
     for (uint16_t i = 0; i < dataLen; i++) {
@@ -108,4 +136,20 @@ q15 mean_q15(const q15* data, uint16_t log2DataLen) {
     return (uint16_t)(total >> log2DataLen);
 }
 
+uint16_t isqrt_u32(uint32_t a) {
+    // Classic bit-by-bit method: one result bit per iteration, always 16 
+    // iterations.  The comparison is turned into a mask so that there are 
+    // no data-dependent branches.
+    uint32_t result = 0;
+    uint32_t bit = (uint32_t)1 << 30;
+    for (uint16_t i = 0; i < 16; i++) {
+        const uint32_t trial = result + bit;
+        const uint32_t mask = -(uint32_t)(a >= trial);
+        a -= trial & mask;
+        result = (result >> 1) + (bit & mask);
+        bit >>= 2;
+    }
+    return (uint16_t)result;
+}
+
 }
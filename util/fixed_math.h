@@ -29,6 +29,7 @@ typedef int32_t q31;
 #define q15_to_f32(a) ((float)(a) / 32768.0f)
 #define f32_to_q15(a) ((q15)((a) * 32768.0f)) 
 #define f32_to_q31(a) ((q31)((a) * 2147483648.0f)) 
+#define q31_to_f32(a) ((float)(a) / 2147483648.0f)
 #define int_to_q15(a) ((q15)(a << 15))
 #define q15_to_int(a) ((int)(a >> 15))
 #define char_to_q15(a) (q15)(((q15)(a)) << 15)
@@ -67,6 +68,18 @@ struct cq15 {
     static cq15 mult(cq15 c0, cq15 c1);
 };
 
+struct cq31 {
+
+    q31 r = 0;
+    q31 i = 0;
+
+    float mag_f32_squared() const {
+        float ref = q31_to_f32(r);
+        float imf = q31_to_f32(i);
+        return ref * ref + imf * imf;
+    }
+};
+
 /**
  * Correlates the real part of two series.
 */
@@ -88,12 +101,45 @@ uint16_t max_idx(const cq15* data, uint16_t start, uint16_t dataLen);
 */
 uint16_t max_idx_2(const cq15* sample, uint16_t start, uint16_t len);
 
+/**
+ * The accumulator of a symmetric FIR filter with an odd number of taps.  
+ * Only the first half of the coefficients (plus the center tap) are 
+ * provided.  The samples that share a coefficient are added before the
+ * multiply.
+ *
+ * @param h The coefficients (taps / 2 + 1 of them).
+ * @param x The most recent taps samples (newest first).
+ * @returns The sum of the products (i.e. q30 for q15 coefficients).
+ */
+q31 fir_sym_q15(const q15* h, const q15* x, uint16_t taps);
+
+/**
+ * The accumulator of a FIR filter (any coefficients).
+ *
+ * @param h The coefficients.
+ * @param x The most recent taps samples (newest first).
+ * @returns The sum of the products (i.e. q30 for q15 coefficients).
+ */
+q31 fir_q15(const q15* h, const q15* x, uint16_t taps);
+
 q15 max_q15(const q15* data, uint16_t dataLen);
 q15 min_q15(const q15* data, uint16_t dataLen);
 
 // NOTE: This will only work for data lengths that are a power of two!
 q15 mean_q15(const q15* data, uint16_t dataLenLog2);
 
+/**
+ * Integer square root (rounded down) using only shifts and adds.
+ */
+uint16_t isqrt_u32(uint32_t a);
+
+/**
+ * @returns The base-2 log of n (rounded down).  Usable at compile time.
+ */
+constexpr uint16_t log2_u16(uint16_t n) {
+    return (n <= 1) ? 0 : 1 + log2_u16(n >> 1);
+}
+
 }
 
 #endif
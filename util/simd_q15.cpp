@@ -0,0 +1,508 @@
+/*
+Copyright (C) 2024 - Bruce MacKinnon KC1FSZ
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "simd_q15.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define RADLIB_SIMD_X86
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#define RADLIB_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+namespace radlib {
+
+// The kernels treat the complex values as pairs of q15's
+static_assert(sizeof(cq15) == 2 * sizeof(q15), "cq15 must be packed");
+
+static SIMDLevel& _currentLevel() {
+    static SIMDLevel level = simd_detect_level();
+    return level;
+}
+
+SIMDLevel simd_detect_level() {
+#if defined(RADLIB_SIMD_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return SIMDLevel::AVX2;
+    }
+    return SIMDLevel::SSE2;
+#elif defined(RADLIB_SIMD_NEON)
+    return SIMDLevel::NEON;
+#else
+    return SIMDLevel::NONE;
+#endif
+}
+
+SIMDLevel simd_level() {
+    return _currentLevel();
+}
+
+bool simd_set_level(SIMDLevel level) {
+    const SIMDLevel detected = simd_detect_level();
+    if (level == SIMDLevel::NONE ||
+        level == detected ||
+        (level == SIMDLevel::SSE2 && detected == SIMDLevel::AVX2)) {
+        _currentLevel() = level;
+        return true;
+    }
+    return false;
+}
+
+#if defined(RADLIB_SIMD_X86)
+
+// ----- x86 ------------------------------------------------------------------
+
+/**
+ * mult_q15() on 8 lanes.  The full product is (hi:lo), so bits 15 to 30 are
+ * (hi << 1) | (lo >> 15).  This truncates just like the scalar version
+ * (_mm_mulhrs_epi16 rounds, so it can't be used).
+ */
+static inline __m128i _mult_q15_sse2(__m128i a, __m128i b) {
+    const __m128i lo = _mm_mullo_epi16(a, b);
+    const __m128i hi = _mm_mulhi_epi16(a, b);
+    return _mm_or_si128(_mm_slli_epi16(hi, 1), _mm_srli_epi16(lo, 15));
+}
+
+/**
+ * Exchanges the real/imaginary parts of each complex value.
+ */
+static inline __m128i _swap_ri_sse2(__m128i a) {
+    return _mm_shufflehi_epi16(_mm_shufflelo_epi16(a, _MM_SHUFFLE(2, 3, 0, 1)),
+        _MM_SHUFFLE(2, 3, 0, 1));
+}
+
+/**
+ * The approximate magnitude from cq15::approx_mag_q15().  The result ends
+ * up in both the real and imaginary lanes.
+ */
+static inline __m128i _approx_mag_sse2(__m128i a) {
+    // NOTE: abs(-32768) wraps to -32768 as in the scalar version
+    const __m128i absA = _mm_max_epi16(a, _mm_sub_epi16(_mm_setzero_si128(), a));
+    const __m128i absB = _swap_ri_sse2(absA);
+    // floor((a + b) / 2) without leaving 16 bits
+    const __m128i half = _mm_add_epi16(
+        _mm_add_epi16(_mm_srai_epi16(absA, 1), _mm_srai_epi16(absB, 1)),
+        _mm_and_si128(_mm_and_si128(absA, absB), _mm_set1_epi16(1)));
+    return _mm_add_epi16(_mm_max_epi16(absA, absB), half);
+}
+
+/**
+ * The radix-2 butterflies for 4 complex values at a time.  L must be a
+ * multiple of 4.
+ */
+static void _fft_stage_sse2(cq15* f, uint16_t n, uint16_t L, uint16_t k,
+    const q15* cosTable, uint16_t N) {
+
+    const uint16_t iStep = L << 1;
+    // Used to negate the real lanes: (x ^ -1) - (-1) = -x
+    const __m128i negReal = _mm_set_epi16(0, -1, 0, -1, 0, -1, 0, -1);
+
+    for (uint16_t m = 0; m < L; m += 4) {
+        // The twiddles, duplicated into the real/imaginary lanes
+        q15 wr[8], wi[8];
+        for (uint16_t t = 0; t < 4; t++) {
+            const uint16_t j = (m + t) << k;
+            wr[2 * t] = wr[2 * t + 1] = cosTable[j + N / 4];
+            wi[2 * t] = wi[2 * t + 1] = -cosTable[j];
+        }
+        const __m128i vwr = _mm_loadu_si128((const __m128i*)wr);
+        const __m128i vwi = _mm_loadu_si128((const __m128i*)wi);
+        for (uint16_t i = m; i < n; i += iStep) {
+            __m128i* pi = (__m128i*)(f + i);
+            __m128i* pj = (__m128i*)(f + i + L);
+            const __m128i x = _mm_loadu_si128(pj);
+            // (wr * xr, wr * xi)
+            const __m128i p0 = _mult_q15_sse2(vwr, x);
+            // (wi * xi, wi * xr)
+            const __m128i p1 = _mult_q15_sse2(vwi, _swap_ri_sse2(x));
+            // (tr, ti) = (wr * xr - wi * xi, wr * xi + wi * xr)
+            const __m128i t = _mm_add_epi16(p0,
+                _mm_sub_epi16(_mm_xor_si128(p1, negReal), negReal));
+            const __m128i q = _mm_srai_epi16(_mm_loadu_si128(pi), 1);
+            _mm_storeu_si128(pj, _mm_sub_epi16(q, t));
+            _mm_storeu_si128(pi, _mm_add_epi16(q, t));
+        }
+    }
+}
+
+__attribute__((target("avx2")))
+static inline __m256i _mult_q15_avx2(__m256i a, __m256i b) {
+    const __m256i lo = _mm256_mullo_epi16(a, b);
+    const __m256i hi = _mm256_mulhi_epi16(a, b);
+    return _mm256_or_si256(_mm256_slli_epi16(hi, 1), _mm256_srli_epi16(lo, 15));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i _swap_ri_avx2(__m256i a) {
+    return _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(a, _MM_SHUFFLE(2, 3, 0, 1)),
+        _MM_SHUFFLE(2, 3, 0, 1));
+}
+
+/**
+ * Same as _fft_stage_sse2() with 8 complex values at a time.  L must be a
+ * multiple of 8.
+ */
+__attribute__((target("avx2")))
+static void _fft_stage_avx2(cq15* f, uint16_t n, uint16_t L, uint16_t k,
+    const q15* cosTable, uint16_t N) {
+
+    const uint16_t iStep = L << 1;
+    const __m256i negReal = _mm256_set_epi16(0, -1, 0, -1, 0, -1, 0, -1,
+        0, -1, 0, -1, 0, -1, 0, -1);
+
+    for (uint16_t m = 0; m < L; m += 8) {
+        q15 wr[16], wi[16];
+        for (uint16_t t = 0; t < 8; t++) {
+            const uint16_t j = (m + t) << k;
+            wr[2 * t] = wr[2 * t + 1] = cosTable[j + N / 4];
+            wi[2 * t] = wi[2 * t + 1] = -cosTable[j];
+        }
+        const __m256i vwr = _mm256_loadu_si256((const __m256i*)wr);
+        const __m256i vwi = _mm256_loadu_si256((const __m256i*)wi);
+        for (uint16_t i = m; i < n; i += iStep) {
+            __m256i* pi = (__m256i*)(f + i);
+            __m256i* pj = (__m256i*)(f + i + L);
+            const __m256i x = _mm256_loadu_si256(pj);
+            const __m256i p0 = _mult_q15_avx2(vwr, x);
+            const __m256i p1 = _mult_q15_avx2(vwi, _swap_ri_avx2(x));
+            const __m256i t = _mm256_add_epi16(p0,
+                _mm256_sub_epi16(_mm256_xor_si256(p1, negReal), negReal));
+            const __m256i q = _mm256_srai_epi16(_mm256_loadu_si256(pi), 1);
+            _mm256_storeu_si256(pj, _mm256_sub_epi16(q, t));
+            _mm256_storeu_si256(pi, _mm256_add_epi16(q, t));
+        }
+    }
+}
+
+static uint16_t _max_idx_2_sse2(const cq15* sample, uint16_t start, uint16_t len) {
+
+    // Pass 1: the largest magnitude (ties go to the lowest index, so the
+    // location is found in a second pass).
+    __m128i vmax = _mm_setzero_si128();
+    unsigned int i = start;
+    for (; i + 4 <= len; i += 4) {
+        const __m128i m = _approx_mag_sse2(_mm_loadu_si128((const __m128i*)(sample + i)));
+        vmax = _mm_max_epi16(vmax, m);
+    }
+    vmax = _mm_max_epi16(vmax, _mm_srli_si128(vmax, 8));
+    vmax = _mm_max_epi16(vmax, _mm_srli_si128(vmax, 4));
+    vmax = _mm_max_epi16(vmax, _mm_srli_si128(vmax, 2));
+    q15 max_mag = (q15)_mm_cvtsi128_si32(vmax);
+    for (; i < len; i++) {
+        const q15 m = sample[i].approx_mag_q15();
+        if (m > max_mag) {
+            max_mag = m;
+        }
+    }
+
+    // Same as the scalar version: nothing is found unless it is above zero
+    if (max_mag <= 0) {
+        return 0;
+    }
+
+    // Pass 2: the first location of the largest magnitude
+    const __m128i target = _mm_set1_epi16(max_mag);
+    i = start;
+    for (; i + 4 <= len; i += 4) {
+        const __m128i m = _approx_mag_sse2(_mm_loadu_si128((const __m128i*)(sample + i)));
+        const int hits = _mm_movemask_epi8(_mm_cmpeq_epi16(m, target));
+        if (hits != 0) {
+            // Four mask bits per complex value
+            return i + (__builtin_ctz(hits) >> 2);
+        }
+    }
+    for (; i < len; i++) {
+        if (sample[i].approx_mag_q15() == max_mag) {
+            break;
+        }
+    }
+    return i;
+}
+
+/**
+ * Reverses the order of 8 q15's.
+ */
+static inline __m128i _reverse_sse2(__m128i a) {
+    const __m128i b = _mm_shufflehi_epi16(_mm_shufflelo_epi16(a, _MM_SHUFFLE(0, 1, 2, 3)),
+        _MM_SHUFFLE(0, 1, 2, 3));
+    return _mm_shuffle_epi32(b, _MM_SHUFFLE(1, 0, 3, 2));
+}
+
+static q31 _fir_sym_q15_sse2(const q15* h, const q15* x, uint16_t taps) {
+
+    const uint16_t half = taps / 2;
+    __m128i acc = _mm_setzero_si128();
+    uint16_t i = 0;
+    // The two samples that share a coefficient are multiplied separately
+    // (rather than added first) so nothing can overflow 16 bits.
+    for (; i + 8 <= half; i += 8) {
+        const __m128i vh = _mm_loadu_si128((const __m128i*)(h + i));
+        const __m128i x0 = _mm_loadu_si128((const __m128i*)(x + i));
+        const __m128i x1 = _reverse_sse2(_mm_loadu_si128((const __m128i*)(x + taps - 8 - i)));
+        acc = _mm_add_epi32(acc, _mm_madd_epi16(vh, x0));
+        acc = _mm_add_epi32(acc, _mm_madd_epi16(vh, x1));
+    }
+    acc = _mm_add_epi32(acc, _mm_srli_si128(acc, 8));
+    acc = _mm_add_epi32(acc, _mm_srli_si128(acc, 4));
+    q31 result = _mm_cvtsi128_si32(acc) + (q31)h[half] * (q31)x[half];
+    for (; i < half; i++) {
+        result += (q31)h[i] * ((q31)x[i] + (q31)x[taps - 1 - i]);
+    }
+    return result;
+}
+
+static q31 _fir_q15_sse2(const q15* h, const q15* x, uint16_t taps) {
+    __m128i acc = _mm_setzero_si128();
+    uint16_t i = 0;
+    for (; i + 8 <= taps; i += 8) {
+        const __m128i vh = _mm_loadu_si128((const __m128i*)(h + i));
+        const __m128i vx = _mm_loadu_si128((const __m128i*)(x + i));
+        acc = _mm_add_epi32(acc, _mm_madd_epi16(vh, vx));
+    }
+    acc = _mm_add_epi32(acc, _mm_srli_si128(acc, 8));
+    acc = _mm_add_epi32(acc, _mm_srli_si128(acc, 4));
+    q31 result = _mm_cvtsi128_si32(acc);
+    for (; i < taps; i++) {
+        result += (q31)h[i] * (q31)x[i];
+    }
+    return result;
+}
+
+#elif defined(RADLIB_SIMD_NEON)
+
+// ----- ARM ------------------------------------------------------------------
+
+/**
+ * mult_q15() on 8 lanes.  The narrowing shift truncates just like the scalar
+ * version (vqdmulhq_s16 saturates -1 * -1, so it can't be used).
+ */
+static inline int16x8_t _mult_q15_neon(int16x8_t a, int16x8_t b) {
+    const int32x4_t lo = vmull_s16(vget_low_s16(a), vget_low_s16(b));
+    const int32x4_t hi = vmull_s16(vget_high_s16(a), vget_high_s16(b));
+    return vcombine_s16(vshrn_n_s32(lo, 15), vshrn_n_s32(hi, 15));
+}
+
+/**
+ * The approximate magnitude from cq15::approx_mag_q15().
+ */
+static inline int16x8_t _approx_mag_neon(int16x8x2_t a) {
+    // NOTE: vabsq_s16 wraps -32768 as in the scalar version
+    const int16x8_t absR = vabsq_s16(a.val[0]);
+    const int16x8_t absI = vabsq_s16(a.val[1]);
+    const int16x8_t half = vaddq_s16(
+        vaddq_s16(vshrq_n_s16(absR, 1), vshrq_n_s16(absI, 1)),
+        vandq_s16(vandq_s16(absR, absI), vdupq_n_s16(1)));
+    return vaddq_s16(vmaxq_s16(absR, absI), half);
+}
+
+/**
+ * The radix-2 butterflies for 8 complex values at a time.  L must be a
+ * multiple of 8.
+ */
+static void _fft_stage_neon(cq15* f, uint16_t n, uint16_t L, uint16_t k,
+    const q15* cosTable, uint16_t N) {
+
+    const uint16_t iStep = L << 1;
+
+    for (uint16_t m = 0; m < L; m += 8) {
+        q15 wr[8], wi[8];
+        for (uint16_t t = 0; t < 8; t++) {
+            const uint16_t j = (m + t) << k;
+            wr[t] = cosTable[j + N / 4];
+            wi[t] = -cosTable[j];
+        }
+        const int16x8_t vwr = vld1q_s16(wr);
+        const int16x8_t vwi = vld1q_s16(wi);
+        for (uint16_t i = m; i < n; i += iStep) {
+            int16_t* pi = (int16_t*)(f + i);
+            int16_t* pj = (int16_t*)(f + i + L);
+            // Separates the real and imaginary parts
+            const int16x8x2_t x = vld2q_s16(pj);
+            const int16x8_t tr = vsubq_s16(_mult_q15_neon(vwr, x.val[0]),
+                _mult_q15_neon(vwi, x.val[1]));
+            const int16x8_t ti = vaddq_s16(_mult_q15_neon(vwr, x.val[1]),
+                _mult_q15_neon(vwi, x.val[0]));
+            const int16x8x2_t y = vld2q_s16(pi);
+            const int16x8_t qr = vshrq_n_s16(y.val[0], 1);
+            const int16x8_t qi = vshrq_n_s16(y.val[1], 1);
+            int16x8x2_t out;
+            out.val[0] = vsubq_s16(qr, tr);
+            out.val[1] = vsubq_s16(qi, ti);
+            vst2q_s16(pj, out);
+            out.val[0] = vaddq_s16(qr, tr);
+            out.val[1] = vaddq_s16(qi, ti);
+            vst2q_s16(pi, out);
+        }
+    }
+}
+
+static uint16_t _max_idx_2_neon(const cq15* sample, uint16_t start, uint16_t len) {
+
+    // Pass 1: the largest magnitude (ties go to the lowest index, so the
+    // location is found in a second pass).
+    int16x8_t vmax = vdupq_n_s16(0);
+    unsigned int i = start;
+    for (; i + 8 <= len; i += 8) {
+        vmax = vmaxq_s16(vmax, _approx_mag_neon(vld2q_s16((const int16_t*)(sample + i))));
+    }
+    int16x4_t m4 = vpmax_s16(vget_low_s16(vmax), vget_high_s16(vmax));
+    m4 = vpmax_s16(m4, m4);
+    m4 = vpmax_s16(m4, m4);
+    q15 max_mag = vget_lane_s16(m4, 0);
+    for (; i < len; i++) {
+        const q15 m = sample[i].approx_mag_q15();
+        if (m > max_mag) {
+            max_mag = m;
+        }
+    }
+
+    if (max_mag <= 0) {
+        return 0;
+    }
+
+    // Pass 2: the first location of the largest magnitude
+    i = start;
+    for (; i + 8 <= len; i += 8) {
+        q15 m[8];
+        vst1q_s16(m, _approx_mag_neon(vld2q_s16((const int16_t*)(sample + i))));
+        for (uint16_t t = 0; t < 8; t++) {
+            if (m[t] == max_mag) {
+                return i + t;
+            }
+        }
+    }
+    for (; i < len; i++) {
+        if (sample[i].approx_mag_q15() == max_mag) {
+            break;
+        }
+    }
+    return i;
+}
+
+static q31 _fir_sym_q15_neon(const q15* h, const q15* x, uint16_t taps) {
+
+    const uint16_t half = taps / 2;
+    int32x4_t acc = vdupq_n_s32(0);
+    uint16_t i = 0;
+    for (; i + 8 <= half; i += 8) {
+        const int16x8_t vh = vld1q_s16(h + i);
+        const int16x8_t x0 = vld1q_s16(x + i);
+        // Reverse the 8 samples at the other end
+        const int16x8_t r = vrev64q_s16(vld1q_s16(x + taps - 8 - i));
+        const int16x8_t x1 = vcombine_s16(vget_high_s16(r), vget_low_s16(r));
+        acc = vmlal_s16(acc, vget_low_s16(vh), vget_low_s16(x0));
+        acc = vmlal_s16(acc, vget_high_s16(vh), vget_high_s16(x0));
+        acc = vmlal_s16(acc, vget_low_s16(vh), vget_low_s16(x1));
+        acc = vmlal_s16(acc, vget_high_s16(vh), vget_high_s16(x1));
+    }
+    q31 result = vgetq_lane_s32(acc, 0) + vgetq_lane_s32(acc, 1) +
+        vgetq_lane_s32(acc, 2) + vgetq_lane_s32(acc, 3) +
+        (q31)h[half] * (q31)x[half];
+    for (; i < half; i++) {
+        result += (q31)h[i] * ((q31)x[i] + (q31)x[taps - 1 - i]);
+    }
+    return result;
+}
+
+static q31 _fir_q15_neon(const q15* h, const q15* x, uint16_t taps) {
+    int32x4_t acc = vdupq_n_s32(0);
+    uint16_t i = 0;
+    for (; i + 8 <= taps; i += 8) {
+        const int16x8_t vh = vld1q_s16(h + i);
+        const int16x8_t vx = vld1q_s16(x + i);
+        acc = vmlal_s16(acc, vget_low_s16(vh), vget_low_s16(vx));
+        acc = vmlal_s16(acc, vget_high_s16(vh), vget_high_s16(vx));
+    }
+    q31 result = vgetq_lane_s32(acc, 0) + vgetq_lane_s32(acc, 1) +
+        vgetq_lane_s32(acc, 2) + vgetq_lane_s32(acc, 3);
+    for (; i < taps; i++) {
+        result += (q31)h[i] * (q31)x[i];
+    }
+    return result;
+}
+
+#endif
+
+// ----- Dispatch ---------------------------------------------------------------
+
+bool fft_stage_q15_simd(cq15* f, uint16_t n, uint16_t L, uint16_t k,
+    const q15* cosTable, uint16_t N) {
+#if defined(RADLIB_SIMD_X86)
+    const SIMDLevel level = _currentLevel();
+    if (level == SIMDLevel::AVX2 && L >= 8) {
+        _fft_stage_avx2(f, n, L, k, cosTable, N);
+        return true;
+    } else if (level != SIMDLevel::NONE && L >= 4) {
+        _fft_stage_sse2(f, n, L, k, cosTable, N);
+        return true;
+    }
+#elif defined(RADLIB_SIMD_NEON)
+    if (_currentLevel() == SIMDLevel::NEON && L >= 8) {
+        _fft_stage_neon(f, n, L, k, cosTable, N);
+        return true;
+    }
+#endif
+    return false;
+}
+
+bool max_idx_2_simd(const cq15* sample, uint16_t start, uint16_t len,
+    uint16_t* result) {
+#if defined(RADLIB_SIMD_X86)
+    if (_currentLevel() != SIMDLevel::NONE) {
+        *result = _max_idx_2_sse2(sample, start, len);
+        return true;
+    }
+#elif defined(RADLIB_SIMD_NEON)
+    if (_currentLevel() == SIMDLevel::NEON) {
+        *result = _max_idx_2_neon(sample, start, len);
+        return true;
+    }
+#endif
+    return false;
+}
+
+bool fir_sym_q15_simd(const q15* h, const q15* x, uint16_t taps, q31* result) {
+#if defined(RADLIB_SIMD_X86)
+    if (_currentLevel() != SIMDLevel::NONE) {
+        *result = _fir_sym_q15_sse2(h, x, taps);
+        return true;
+    }
+#elif defined(RADLIB_SIMD_NEON)
+    if (_currentLevel() == SIMDLevel::NEON) {
+        *result = _fir_sym_q15_neon(h, x, taps);
+        return true;
+    }
+#endif
+    return false;
+}
+
+bool fir_q15_simd(const q15* h, const q15* x, uint16_t taps, q31* result) {
+#if defined(RADLIB_SIMD_X86)
+    if (_currentLevel() != SIMDLevel::NONE) {
+        *result = _fir_q15_sse2(h, x, taps);
+        return true;
+    }
+#elif defined(RADLIB_SIMD_NEON)
+    if (_currentLevel() == SIMDLevel::NEON) {
+        *result = _fir_q15_neon(h, x, taps);
+        return true;
+    }
+#endif
+    return false;
+}
+
+}
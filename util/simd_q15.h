@@ -0,0 +1,98 @@
+/*
+Copyright (C) 2024 - Bruce MacKinnon KC1FSZ
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef _simd_q15_h
+#define _simd_q15_h
+
+#include <cstdint>
+
+#include "fixed_math.h"
+
+namespace radlib {
+
+/**
+ * Vectorized versions of the q15 inner loops (FFT butterflies, peak search,
+ * correlation filter).  These are used automatically by FixedFFT, max_idx_2()
+ * fir_sym_q15() and fir_q15() when the CPU supports them.  The scalar code stays the
+ * reference: every kernel produces exactly the same result as the scalar
+ * version, including the truncation in mult_q15() and the q15 wrap-around.
+ *
+ * SSE2 is always there on x86-64 and AVX2 is detected at runtime.  NEON is
+ * used when the compiler targets it.  Everything else (i.e. the embedded
+ * builds) gets the scalar code.
+ */
+enum class SIMDLevel { NONE, SSE2, AVX2, NEON };
+
+/**
+ * @returns The best level supported by this CPU.
+ */
+SIMDLevel simd_detect_level();
+
+/**
+ * @returns The level being used by the kernels.  Starts off as
+ *   simd_detect_level().
+ */
+SIMDLevel simd_level();
+
+/**
+ * Changes the level being used by the kernels (i.e. NONE to force the
+ * scalar code when testing).  Levels that the CPU doesn't support are
+ * ignored.  This isn't thread-safe, so call it before the processing
+ * starts.
+ *
+ * @returns true if the level was changed.
+ */
+bool simd_set_level(SIMDLevel level);
+
+/**
+ * One radix-2 Danielson-Lanczos stage of FixedFFT (see FixedFFT::_transform()).
+ *
+ * @param f The data, already in bit-reversed order.
+ * @param n The size of the transform.
+ * @param L The length of the FFT's being combined.
+ * @param k The stride through the trig table (in log terms).
+ * @param cosTable The FixedFFT trig table (sin / 2).
+ * @param N The size of the trig table.
+ * @returns false if the stage wasn't done (no SIMD or L is too small), in
+ *   which case the caller needs to run the scalar loop.
+ */
+bool fft_stage_q15_simd(cq15* f, uint16_t n, uint16_t L, uint16_t k,
+    const q15* cosTable, uint16_t N);
+
+/**
+ * The vectorized version of max_idx_2().
+ *
+ * @returns false if there is no SIMD, in which case result isn't changed.
+ */
+bool max_idx_2_simd(const cq15* sample, uint16_t start, uint16_t len,
+    uint16_t* result);
+
+/**
+ * The vectorized version of fir_sym_q15().
+ *
+ * @returns false if there is no SIMD, in which case result isn't changed.
+ */
+bool fir_sym_q15_simd(const q15* h, const q15* x, uint16_t taps, q31* result);
+
+/**
+ * The vectorized version of fir_q15().
+ *
+ * @returns false if there is no SIMD, in which case result isn't changed.
+ */
+bool fir_q15_simd(const q15* h, const q15* x, uint16_t taps, q31* result);
+
+}
+
+#endif